@@ -12,7 +12,8 @@
 // general includes
 #include <stdio.h>
 #include <limits.h>
-//#include <stdlib.h>
+#include <stdlib.h>
+#include <stdint.h>
 
 // declaration of chugin constructor
 CK_DLL_CTOR(gverb_ctor);
@@ -69,6 +70,10 @@ public:
       float diffscale;
       int a,b,c,cc,d,dd,e;
       float spread1,spread2;
+      int ldiflens[4], rdiflens[4];
+      int tapsize;
+      size_t total;
+      float *buf;
       
       p = &realp;
       memset((void *)p, 0, sizeof (ty_gverb));
@@ -88,23 +93,13 @@ public:
       /* Input damper */
       
       p->inputbandwidth = inputbandwidth;
-      p->inputdamper = damper_make(1.0 - p->inputbandwidth);
+      damper_init(&p->inputdamper, 1.0 - p->inputbandwidth);
       
    	/* FDN section */
 
-	p->fdndels = (ty_fixeddelay **)malloc(FDNORDER*sizeof(ty_fixeddelay *));
 	for(i = 0; i < FDNORDER; i++)
 	{
-		p->fdndels[i] = fixeddelay_make((int)p->maxdelay+1000);
-	}
-	p->fdngains = (float *)malloc(FDNORDER*sizeof(float));
-	p->fdnlens = (int *)malloc(FDNORDER*sizeof(int));
-
-	p->fdndamps = (ty_damper **)malloc(FDNORDER*sizeof(ty_damper *));
-
-	for(i = 0; i < FDNORDER; i++)
-	{
-		p->fdndamps[i] = damper_make(p->fdndamping);
+		p->fdndamps[i] = 0.0f;
 	}
 
 	ga = 60.0;
@@ -130,10 +125,6 @@ public:
 		p->fdngains[i] = -powf((float)p->alpha,p->fdnlens[i]);
 	}
 
-	p->d = (float *)malloc(FDNORDER*sizeof(float));
-	p->u = (float *)malloc(FDNORDER*sizeof(float));
-	p->f = (float *)malloc(FDNORDER*sizeof(float));
-
 	/* Diffuser section */
 
 	diffscale = (float)p->fdnlens[3]/(210+159+562+410);
@@ -151,12 +142,10 @@ public:
 	dd = d-c;
 	e = 1341-d;
 
-	p->ldifs = (ty_diffuser **)malloc(4*sizeof(ty_diffuser *));
-
-	p->ldifs[0] = diffuser_make((int)(diffscale*b),0.75);
-	p->ldifs[1] = diffuser_make((int)(diffscale*cc),0.75);
-	p->ldifs[2] = diffuser_make((int)(diffscale*dd),0.625);
-	p->ldifs[3] = diffuser_make((int)(diffscale*e),0.625);
+	ldiflens[0] = (int)(diffscale*b);
+	ldiflens[1] = (int)(diffscale*cc);
+	ldiflens[2] = (int)(diffscale*dd);
+	ldiflens[3] = (int)(diffscale*e);
 
 	b = 210;
 	r = -0.568366f;
@@ -169,19 +158,13 @@ public:
 	dd = d-c;
 	e = 1341-d;
 
-	p->rdifs = (ty_diffuser **)malloc(4*sizeof(ty_diffuser *));
-
-	p->rdifs[0] = diffuser_make((int)(diffscale*b),0.75);
-	p->rdifs[1] = diffuser_make((int)(diffscale*cc),0.75);
-	p->rdifs[2] = diffuser_make((int)(diffscale*dd),0.625);
-	p->rdifs[3] = diffuser_make((int)(diffscale*e),0.625);
+	rdiflens[0] = (int)(diffscale*b);
+	rdiflens[1] = (int)(diffscale*cc);
+	rdiflens[2] = (int)(diffscale*dd);
+	rdiflens[3] = (int)(diffscale*e);
 
 	/* Tapped delay section */
 
-	p->tapdelay = fixeddelay_make(44000);
-	p->taps = (int *)malloc(FDNORDER*sizeof(int));
-	p->tapgains = (float *)malloc(FDNORDER*sizeof(float));
-
 	p->taps[0] = (int)(5+0.410*p->largestdelay);
 	p->taps[1] = (int)(5+0.300*p->largestdelay);
 	p->taps[2] = (int)(5+0.155*p->largestdelay);
@@ -191,23 +174,59 @@ public:
 	{
 		p->tapgains[i] = pow(p->alpha,(double)p->taps[i]);
 	}
-	
+
+	/* One arena for every delay line: the FDN rows first, cache-line
+	 * aligned, then the tap delay and the diffusers.  The tap delay has
+	 * to reach the longest tap gverb_set_roomsize() can ask for. */
+
+	p->fdnsize = (int)p->maxdelay+1000;
+	tapsize = (int)(5+0.410*p->rate*p->maxroomsize*0.00294f)+1;
+	if (tapsize < 44000) tapsize = 44000;
+
+	total = FDNORDER*p->fdnsize + tapsize;
+	for(i = 0; i < 4; i++)
+	{
+		total += ldiflens[i] + rdiflens[i];
+	}
+	p->arena = calloc(total*sizeof(float) + 64, 1);
+	buf = (float *)(((uintptr_t)p->arena + 63) & ~(uintptr_t)63);
+
+	p->fdnbuf = buf;
+	p->fdnidx = 0;
+	buf += FDNORDER*p->fdnsize;
+	fixeddelay_init(&p->tapdelay, tapsize, buf);
+	buf += tapsize;
+	for(i = 0; i < 4; i++)
+	{
+		diffuser_init(&p->ldifs[i], ldiflens[i], i < 2 ? 0.75 : 0.625, buf);
+		buf += ldiflens[i];
+		diffuser_init(&p->rdifs[i], rdiflens[i], i < 2 ? 0.75 : 0.625, buf);
+		buf += rdiflens[i];
+	}
+    }
+
+    ~GVerb()
+    {
+      free(p->arena);
     }
 
     // for Chugins extending UGen
+    // in and out are interleaved stereo, nframes frames each; the reverb
+    // is fed from the left input.  The setters only run between calls, so
+    // parameters change on block boundaries.
     void tick( SAMPLE * in, SAMPLE * out, int nframes )
     {
+      const float drylevel = p->drylevel;
       float rev[2];
-      memset(out, 0, sizeof(SAMPLE)*2*nframes);
 
-      for (int i=0; i < nframes; i+=2)
+      for (int i=0; i < nframes; i++, in+=2, out+=2)
 	{
-	  gverb_do(p, in[i], rev, rev+1);
+	  gverb_do(p, in[0], rev, rev+1);
 	  
-	  out[i] = rev[0] + in[i] * p->drylevel;
-	  out[i+1] = rev[1] + in[i+1] * p->drylevel;
-	}
+	  out[0] = rev[0] + in[0] * drylevel;
+	  out[1] = rev[1] + in[1] * drylevel;
 	}
+    }
   
   // set parameter example
   float setRoomsize( t_CKFLOAT x )
@@ -0,0 +1,112 @@
+// gverb-bench - check GVerb's block path and time it.
+//
+// Renders the same input and parameter changes twice, once a frame per
+// tick and once 64 frames per tick, with the changes landing on block
+// boundaries, and checks that the two come out bit-for-bit the same.
+// Then times a tick per frame against a tick per block, for one instance
+// and for many.
+// Build with "make bench".
+
+// the GVerb class lives in the chugin's source; nothing here needs a VM
+#include "GVerb.cpp"
+
+#include <chrono>
+#include <vector>
+
+static double now()
+{
+  using namespace std::chrono;
+  return duration<double>(steady_clock::now().time_since_epoch()).count();
+}
+
+static const int kBlock = 64;
+
+// noise bursts, left and right inverted
+static void make_input(std::vector<SAMPLE> &in, int nframes)
+{
+  unsigned int s = 12345;
+  in.resize(2 * nframes);
+  for (int i = 0; i < nframes; i++)
+    {
+      s = s * 1664525u + 1013904223u;
+      float x = ((s >> 8) / 16777216.0f - 0.5f) * (i % 50000 < 20000);
+      in[2 * i] = x;
+      in[2 * i + 1] = -x;
+    }
+}
+
+// every 64 blocks, change one parameter
+static void change(GVerb &g, int block)
+{
+  if (block % 64)
+    return;
+  unsigned int k = block / 64, v = k * 2654435761u >> 16;
+  switch (k % 7)
+    {
+    case 0: g.setRoomsize(1 + v % 300); break;
+    case 1: g.setRevTime(44100.0 * (0.5 + v % 20)); break;
+    case 2: g.setDamping((v % 100) / 100.0); break;
+    case 3: g.setBandwidth((v % 100) / 100.0); break;
+    case 4: g.setEarlyLevel((v % 100) / 100.0); break;
+    case 5: g.setTailLevel((v % 100) / 100.0); break;
+    case 6: g.setDryLevel((v % 100) / 100.0); break;
+    }
+}
+
+static void render(std::vector<SAMPLE> &in, std::vector<SAMPLE> &out,
+		   int ticksize)
+{
+  GVerb g(44100);
+  int nframes = in.size() / 2;
+  out.assign(in.size(), 0.f);
+  for (int i = 0; i < nframes; i += ticksize)
+    {
+      if (i % kBlock == 0)
+	change(g, i / kBlock);
+      g.tick(&in[2 * i], &out[2 * i], ticksize);
+    }
+}
+
+static double time_ticks(int ninst, int ticksize)
+{
+  std::vector<GVerb *> v;
+  for (int i = 0; i < ninst; i++)
+    {
+      v.push_back(new GVerb(44100));
+      v.back()->setRoomsize(50 + i % 200);
+    }
+  int nframes = 44100;
+  std::vector<SAMPLE> in(2 * kBlock, 0.f), out(2 * kBlock);
+  in[0] = in[1] = 0.5f;
+  double t = now();
+  for (int i = 0; i < nframes; i += kBlock)
+    for (size_t k = 0; k < v.size(); k++)
+      for (int j = 0; j < kBlock; j += ticksize)
+	v[k]->tick(&in[2 * j], &out[2 * j], ticksize);
+  t = now() - t;
+  for (size_t k = 0; k < v.size(); k++)
+    delete v[k];
+  return t * 1e9 / nframes / ninst;
+}
+
+int main()
+{
+  std::vector<SAMPLE> in, one, block;
+  make_input(in, 44100 * 20);
+  render(in, one, 1);
+  render(in, block, kBlock);
+
+  size_t diff = 0;
+  for (size_t i = 0; i < one.size(); i++)
+    diff += memcmp(&one[i], &block[i], sizeof(SAMPLE)) != 0;
+  printf("1-frame vs %d-frame ticks, %d frames: %s (%zu samples differ)\n",
+	 kBlock, (int)in.size() / 2, diff ? "FAIL" : "ok", diff);
+
+  printf("%10s %12s %12s   (ns per frame per instance)\n", "instances",
+	 "1-frame", "64-frame");
+  int ninsts[] = { 1, 16, 64 };
+  for (int n : ninsts)
+    printf("%10d %12.1f %12.1f\n", n, time_ticks(n, 1), time_ticks(n, kBlock));
+
+  return diff ? 1 : 0;
+}
@@ -30,6 +30,11 @@
 #include <string.h>
 #include <stdio.h>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#include <emmintrin.h>
+	#define GVERB_SSE
+#endif
+
 #define FDNORDER 4
 
 typedef struct
@@ -40,26 +45,30 @@ typedef struct
 	float drylevel;
 	float taillevel;
 	float earlylevel;
-	ty_damper *inputdamper;
+	ty_damper inputdamper;
 	float maxroomsize;
 	float roomsize;
 	float revtime;
 	float maxdelay;
 	float largestdelay;
-	ty_fixeddelay **fdndels;
-	float *fdngains;
-	int *fdnlens;
-	ty_damper **fdndamps; 
+	/* The FDN's delay lines, interleaved: fdnbuf[FDNORDER*i + k] is
+	 * sample i of line k.  The lines all advance together, so they share
+	 * fdnidx, and each sample's writes are one row. */
+	float *fdnbuf;
+	int fdnsize;
+	int fdnidx;
+	float fdngains[FDNORDER];
+	int fdnlens[FDNORDER];
+	float fdndamps[FDNORDER];	/* the lines' damper states */
 	float fdndamping;
-	ty_diffuser **ldifs;
-	ty_diffuser **rdifs;
-	ty_fixeddelay *tapdelay;
-	int *taps;
-	float *tapgains;
-	float *d;
-	float *u;
-	float *f;
+	ty_diffuser ldifs[4];
+	ty_diffuser rdifs[4];
+	ty_fixeddelay tapdelay;
+	int taps[FDNORDER];
+	float tapgains[FDNORDER];
 	double alpha;
+	/* fdnbuf, then the tap delay and diffuser buffers, in one block */
+	void *arena;
 } ty_gverb;
 
 
@@ -105,58 +114,122 @@ static inline void gverb_fdnmatrix(float *a, float *b)
   b[3] = 0.5f*(+dl0 + dl1 + dl2 + dl3);
 }
 
+#ifdef GVERB_SSE
+/* v, with denormals, infinities and NaNs zeroed as FIX_DENORM_NAN_FLOAT
+ * does */
+static inline __m128 gverb_fix_denorm_nan(__m128 v)
+{
+	const __m128 expmask = _mm_castsi128_ps(_mm_set1_epi32(0x7f800000));
+	const __m128 zero = _mm_setzero_ps();
+	__m128 e = _mm_and_ps(v, expmask);
+	__m128 bad = _mm_or_ps(_mm_and_ps(_mm_cmpeq_ps(e, zero),
+									  _mm_cmpneq_ps(v, zero)),
+						   _mm_cmpeq_ps(e, expmask));
+	return _mm_andnot_ps(bad, v);
+}
+
+/* gverb_fdnmatrix on the four lanes of a, adding in the same order */
+static inline __m128 gverb_fdnmatrix_sse(__m128 a)
+{
+	const __m128 s1 = _mm_setr_ps(0.0f, 0.0f, -0.0f, 0.0f);
+	const __m128 s2 = _mm_setr_ps(0.0f, -0.0f, 0.0f, 0.0f);
+	const __m128 s3 = _mm_setr_ps(-0.0f, -0.0f, -0.0f, 0.0f);
+	const __m128 s4 = _mm_setr_ps(-0.0f, 0.0f, 0.0f, 0.0f);
+	__m128 dl0 = _mm_shuffle_ps(a, a, _MM_SHUFFLE(0, 0, 0, 0));
+	__m128 dl1 = _mm_shuffle_ps(a, a, _MM_SHUFFLE(1, 1, 1, 1));
+	__m128 dl2 = _mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 2, 2, 2));
+	__m128 dl3 = _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 3, 3, 3));
+	__m128 b = _mm_add_ps(_mm_xor_ps(dl0, s1), _mm_xor_ps(dl1, s2));
+	b = _mm_add_ps(b, _mm_xor_ps(dl2, s3));
+	b = _mm_add_ps(b, _mm_xor_ps(dl3, s4));
+	return _mm_mul_ps(_mm_set1_ps(0.5f), b);
+}
+#endif
+
 static inline void gverb_do(ty_gverb *p, float x, float *yl, float *yr)
 {
 	float z;
 	unsigned int i;
 	float lsum,rsum,sum,sign;
+	float u[FDNORDER], dl[FDNORDER], t[FDNORDER];
+	float *row = p->fdnbuf + FDNORDER*p->fdnidx;
 
 	if(IS_NAN_FLOAT(x) || IS_DENORM_FLOAT(x) || fabsf(x) > 100000.0f)
 	{
 		x = 0.0f;
 	}
 
-	z = damper_do(p->inputdamper, x);
+	z = damper_do(&p->inputdamper, x);
 
-	z = diffuser_do(p->ldifs[0],z);
+	z = diffuser_do(&p->ldifs[0],z);
 
 	for(i = 0; i < FDNORDER; i++)
 	{
-		p->u[i] = p->tapgains[i]*fixeddelay_read(p->tapdelay,p->taps[i]);
+		u[i] = fixeddelay_read(&p->tapdelay,p->taps[i]);
 	}
-	fixeddelay_write(p->tapdelay,z);
+	fixeddelay_write(&p->tapdelay,z);
 
+	/* each line's output, at its own length behind the shared index */
 	for(i = 0; i < FDNORDER; i++)
 	{
-		p->d[i] = damper_do(p->fdndamps[i],
-							p->fdngains[i]*fixeddelay_read(p->fdndels[i],
-							p->fdnlens[i]));
+		int r = p->fdnidx - p->fdnlens[i];
+		if(r < 0) r += p->fdnsize;
+		dl[i] = p->fdnbuf[FDNORDER*r + i];
 	}
 
+#ifdef GVERB_SSE
+	{
+		__m128 vu = _mm_mul_ps(_mm_loadu_ps(p->tapgains), _mm_loadu_ps(u));
+		__m128 vd = _mm_mul_ps(_mm_loadu_ps(p->fdngains), _mm_loadu_ps(dl));
+		vd = _mm_add_ps(_mm_mul_ps(vd, _mm_set1_ps(1.0f-p->fdndamping)),
+						_mm_mul_ps(_mm_loadu_ps(p->fdndamps),
+								   _mm_set1_ps(p->fdndamping)));
+		_mm_storeu_ps(p->fdndamps, vd);
+		_mm_storeu_ps(t, _mm_add_ps(_mm_mul_ps(_mm_set1_ps(p->taillevel), vd),
+									_mm_mul_ps(_mm_set1_ps(p->earlylevel), vu)));
+		_mm_store_ps(row, gverb_fix_denorm_nan(
+			_mm_add_ps(vu, gverb_fdnmatrix_sse(vd))));
+	}
+#else
+	{
+		float d[FDNORDER], f[FDNORDER];
+		for(i = 0; i < FDNORDER; i++)
+		{
+			u[i] = p->tapgains[i]*u[i];
+			d[i] = p->fdngains[i]*dl[i];
+			d[i] = d[i]*(1.0f-p->fdndamping) + p->fdndamps[i]*p->fdndamping;
+			p->fdndamps[i] = d[i];
+			t[i] = p->taillevel*d[i] + p->earlylevel*u[i];
+		}
+		gverb_fdnmatrix(d,f);
+		for(i = 0; i < FDNORDER; i++)
+		{
+			float w = u[i]+f[i];
+			FIX_DENORM_NAN_FLOAT(w);
+			row[i] = w;
+		}
+	}
+#endif
+	if(++p->fdnidx >= p->fdnsize) p->fdnidx = 0;
+
 	sum = 0.0f;
 	sign = 1.0f;
 	for(i = 0; i < FDNORDER; i++)
 	{
-		sum += sign*(p->taillevel*p->d[i] + p->earlylevel*p->u[i]);
+		sum += sign*t[i];
 		sign = -sign;
 	}
 	sum += x*p->earlylevel;
 	lsum = sum;
 	rsum = sum;
 
-	gverb_fdnmatrix(p->d,p->f);
-
-	for(i = 0; i < FDNORDER; i++)
-	{
-		fixeddelay_write(p->fdndels[i],p->u[i]+p->f[i]);
-	}
-
-	lsum = diffuser_do(p->ldifs[1],lsum);
-	lsum = diffuser_do(p->ldifs[2],lsum);
-	lsum = diffuser_do(p->ldifs[3],lsum);
-	rsum = diffuser_do(p->rdifs[1],rsum);
-	rsum = diffuser_do(p->rdifs[2],rsum);
-	rsum = diffuser_do(p->rdifs[3],rsum);
+	/* the left and right diffuser chains are independent; interleave them */
+	lsum = diffuser_do(&p->ldifs[1],lsum);
+	rsum = diffuser_do(&p->rdifs[1],rsum);
+	lsum = diffuser_do(&p->ldifs[2],lsum);
+	rsum = diffuser_do(&p->rdifs[2],rsum);
+	lsum = diffuser_do(&p->ldifs[3],lsum);
+	rsum = diffuser_do(&p->rdifs[3],rsum);
 
 	*yl = lsum;
 	*yr = rsum;
@@ -218,19 +291,13 @@ static inline void gverb_set_revtime(ty_gverb *p, double a)
 
 static inline void gverb_set_damping(ty_gverb *p, double a)
 {
-	unsigned int i;
-
 	p->fdndamping = CLIP(a, 0.0f, 1.0f);
-	for(i = 0; i < FDNORDER; i++)
-	{
-		damper_set(p->fdndamps[i],p->fdndamping);
-	}
 }
 
 static inline void gverb_set_inputbandwidth(ty_gverb *p, double a)
 {
 	p->inputbandwidth = CLIP(a, 0.0f, 1.0f);
-	damper_set(p->inputdamper,1.0f - p->inputbandwidth);
+	damper_set(&p->inputdamper,1.0f - p->inputbandwidth);
 }
 
 static inline void gverb_set_drylevel(ty_gverb *p, double a)
@@ -29,20 +29,13 @@
 #include <stdlib.h>
 
 
-ty_diffuser *diffuser_make(int size, float coeff)
+void diffuser_init(ty_diffuser *p, int size, float coeff, float *buf)
 {
-	ty_diffuser *p;
-	int i;
-
-	p = (ty_diffuser *)malloc(sizeof(ty_diffuser));
-	if(!p) return (NULL);
 	p->size = size;
 	p->coeff = coeff;
 	p->idx = 0;
-	p->buf = (float *)malloc(size*sizeof(float));
-	if(!p->buf) return (NULL);
-	for (i = 0; i < size; i++) p->buf[i] = 0.0;
-	return(p);
+	p->buf = buf;
+	diffuser_flush(p);
 }
 
 
@@ -51,15 +44,10 @@ void diffuser_flush(ty_diffuser *p)
 	memset(p->buf, 0, p->size * sizeof(float));
 }
 
-ty_damper *damper_make(float damping)
+void damper_init(ty_damper *p, float damping)
 {
-	ty_damper *p;
-
-	p = (ty_damper *)malloc(sizeof(ty_damper));
-	if(!p) return (NULL);
 	p->damping = damping;
 	p->delay = 0.0;
-	return(p);
 }
 
 
@@ -73,20 +61,12 @@ void fixeddelay_flush(ty_fixeddelay *p)
 	memset(p->buf, 0, p->size * sizeof(float));
 }
 
-ty_fixeddelay *fixeddelay_make(int size)
+void fixeddelay_init(ty_fixeddelay *p, int size, float *buf)
 {
-	ty_fixeddelay *p;
-	int i;
-
-	p = (ty_fixeddelay *)malloc(sizeof(ty_fixeddelay));
-	if(!p) return (NULL);
 	p->size = size;
 	p->idx = 0;
-	p->buf = (float *)malloc(size*sizeof(float));
-	if(!p->buf) return (NULL);
-	for (i = 0; i < size; i++)
-		p->buf[i] = 0.0;
-	return(p);
+	p->buf = buf;
+	fixeddelay_flush(p);
 }
 
 int isprime(int n)
@@ -1,9 +1,21 @@
 #ifndef GVERBDSP_H
 #define GVERBDSP_H
 
+#include <string.h>
+
+// the bits of a float, without the aliasing (or, where long is 64 bits,
+// the overlong read) of casting its address
+static inline unsigned int float_bits(float v)
+{
+	unsigned int b;
+
+	memcpy(&b, &v, sizeof(b));
+	return(b);
+}
+
 // BGG -- from file c74/msp/z_dsp.h
-#define IS_DENORM_FLOAT(v)    ((((*(unsigned long *)&(v))&0x7f800000)==0)&&((v)!=0.f))
-#define IS_NAN_FLOAT(v)       (((*(unsigned long *)&(v))&0x7f800000)==0x7f800000)
+#define IS_DENORM_FLOAT(v)    (((float_bits(v)&0x7f800000)==0)&&((v)!=0.f))
+#define IS_NAN_FLOAT(v)       ((float_bits(v)&0x7f800000)==0x7f800000)
 #define IS_DENORM_NAN_FLOAT(v)      (IS_DENORM_FLOAT(v)||IS_NAN_FLOAT(v))
 #define FIX_DENORM_NAN_FLOAT(v)     ((v)=IS_DENORM_NAN_FLOAT(v)?0.f:(v))
 
@@ -13,6 +25,9 @@
 // and back to dB
 #define CO_DB(g) ((g) != 0.0f ? 20.0f/log(10) * log((g)) : -90.0f)
 
+// The delay lines and diffusers below don't own their buffers; GVerb
+// carves them all out of one arena along with its FDN (see gverbdefs.h).
+
 typedef struct {
   int size;
   int idx;
@@ -31,16 +46,13 @@ typedef struct {
   float delay;
 } ty_damper;
 
-extern ty_diffuser *diffuser_make(int, float);
-extern void diffuser_free(ty_diffuser *);
+extern void diffuser_init(ty_diffuser *, int, float, float *);
 extern void diffuser_flush(ty_diffuser *);
 
-extern ty_damper *damper_make(float);
-extern void damper_free(ty_damper *);
+extern void damper_init(ty_damper *, float);
 extern void damper_flush(ty_damper *);
 
-extern ty_fixeddelay *fixeddelay_make(int);
-extern void fixeddelay_free(ty_fixeddelay *);
+extern void fixeddelay_init(ty_fixeddelay *, int, float *);
 extern void fixeddelay_flush(ty_fixeddelay *);
 
 extern int isprime(int);
@@ -56,15 +68,17 @@ static inline float diffuser_do(ty_diffuser *p, float x)
 	FIX_DENORM_NAN_FLOAT(w);
 	y = p->buf[p->idx] + w*p->coeff;
 	p->buf[p->idx] = w;
-	p->idx = (p->idx + 1) % p->size;
+	if(++p->idx >= p->size) p->idx = 0;
 	return(y);
 }
 
+// n must be in [0, size]
 static inline float fixeddelay_read(ty_fixeddelay *p, int n)
 {
 	int i;
 
-	i = (p->idx - n + p->size) % p->size;
+	i = p->idx - n;
+	if(i < 0) i += p->size;
 	return(p->buf[i]);
 }
 
@@ -72,7 +86,7 @@ static inline void fixeddelay_write(ty_fixeddelay *p, float x)
 {
 	FIX_DENORM_NAN_FLOAT(x);
 	p->buf[p->idx] = x;
-	p->idx = (p->idx + 1) % p->size;
+	if(++p->idx >= p->size) p->idx = 0;
 }
 
 static inline void damper_set(ty_damper *p, float damping)
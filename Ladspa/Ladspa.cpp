@@ -10,6 +10,14 @@
 
 // general includes
 #include <math.h>
+#include <algorithm>
+#include <mutex>
+#include <unordered_map>
+#if !defined(__PLATFORM_WINDOWS__)
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 //#include <stdio.h>
 //#include <limits.h>
 //#include <dlfcn.h>
@@ -20,7 +28,13 @@
 
 #define DEFAULT_BUFSIZE 1
 
-#define DEBUG
+// audio-rate control inputs: a LADSPAControl passes its input through
+// and keeps the latest sample, which a LADSPA reads for a bound control
+// port, see LADSPA.control()
+struct LadspaControlSource
+{
+  LADSPA_Data value;
+};
 
 // declaration of chugin constructor
 CK_DLL_CTOR(ladspa_ctor);
@@ -31,15 +45,378 @@ CK_DLL_MFUN(ladspa_load);
 CK_DLL_MFUN(ladspa_list);
 CK_DLL_MFUN(ladspa_info);
 CK_DLL_MFUN(ladspa_label);
+CK_DLL_MFUN(ladspa_labelID);
 CK_DLL_MFUN(ladspa_set);
 CK_DLL_MFUN(ladspa_get);
 CK_DLL_MFUN(ladspa_verbose);
+CK_DLL_MFUN(ladspa_control);
+CK_DLL_MFUN(ladspa_smooth);
 
 // for Chugins extending UGen, this is mono synthesis function for 1 sample
 CK_DLL_TICKF(ladspa_tick);
 
+// LADSPAControl: a signal source for a LADSPA control port
+CK_DLL_CTOR(ladspacontrol_ctor);
+CK_DLL_DTOR(ladspacontrol_dtor);
+CK_DLL_TICK(ladspacontrol_tick);
+
+// LADSPAChain: several plugins processed as one UGen
+CK_DLL_CTOR(ladspachain_ctor);
+CK_DLL_DTOR(ladspachain_dtor);
+CK_DLL_MFUN(ladspachain_add);
+CK_DLL_MFUN(ladspachain_addLabel);
+CK_DLL_MFUN(ladspachain_addID);
+CK_DLL_MFUN(ladspachain_clear);
+CK_DLL_MFUN(ladspachain_size);
+CK_DLL_MFUN(ladspachain_set);
+CK_DLL_MFUN(ladspachain_get);
+CK_DLL_MFUN(ladspachain_setWet);
+CK_DLL_MFUN(ladspachain_getWet);
+CK_DLL_MFUN(ladspachain_verbose);
+CK_DLL_TICKF(ladspachain_tick);
+
 // this is a special offset reserved for Chugin internal data
 t_CKINT ladspa_data_offset = 0;
+t_CKINT ladspachain_data_offset = 0;
+t_CKINT ladspacontrol_data_offset = 0;
+
+// compute the default value of a control port from its range hints
+static LADSPA_Data ladspa_get_default( const LADSPA_Descriptor * psDescriptor,
+                                       unsigned long index )
+{
+  LADSPA_Data fDefault = 0;
+  LADSPA_PortRangeHintDescriptor iHintDescriptor;
+  iHintDescriptor = psDescriptor->PortRangeHints[index].HintDescriptor;
+  switch (iHintDescriptor & LADSPA_HINT_DEFAULT_MASK) {
+  case LADSPA_HINT_DEFAULT_NONE:
+    break;
+  case LADSPA_HINT_DEFAULT_MINIMUM:
+    fDefault = psDescriptor->PortRangeHints[index].LowerBound;
+    break;
+  case LADSPA_HINT_DEFAULT_LOW:
+    if (LADSPA_IS_HINT_LOGARITHMIC(iHintDescriptor)) {
+      fDefault 
+        = exp(log(psDescriptor->PortRangeHints[index].LowerBound) 
+                    * 0.75
+                    + log(psDescriptor->PortRangeHints[index].UpperBound) 
+                    * 0.25);
+    }
+    else {
+      fDefault 
+        = (psDescriptor->PortRangeHints[index].LowerBound
+             * 0.75
+             + psDescriptor->PortRangeHints[index].UpperBound
+             * 0.25);
+    }
+    break;
+  case LADSPA_HINT_DEFAULT_MIDDLE:
+    if (LADSPA_IS_HINT_LOGARITHMIC(iHintDescriptor)) {
+      fDefault 
+        = sqrt(psDescriptor->PortRangeHints[index].LowerBound
+                     * psDescriptor->PortRangeHints[index].UpperBound);
+    }
+    else {
+      fDefault 
+        = 0.5 * (psDescriptor->PortRangeHints[index].LowerBound
+                       + psDescriptor->PortRangeHints[index].UpperBound);
+    }
+    break;
+  case LADSPA_HINT_DEFAULT_HIGH:
+    if (LADSPA_IS_HINT_LOGARITHMIC(iHintDescriptor)) {
+      fDefault 
+        = exp(log(psDescriptor->PortRangeHints[index].LowerBound) 
+                    * 0.25
+                    + log(psDescriptor->PortRangeHints[index].UpperBound) 
+                    * 0.75);
+    }
+    else {
+      fDefault 
+        = (psDescriptor->PortRangeHints[index].LowerBound
+             * 0.25
+             + psDescriptor->PortRangeHints[index].UpperBound
+             * 0.75);
+    }
+    break;
+  case LADSPA_HINT_DEFAULT_MAXIMUM:
+    fDefault = psDescriptor->PortRangeHints[index].UpperBound;
+    break;
+  case LADSPA_HINT_DEFAULT_0:
+    fDefault = 0;
+    break;
+  case LADSPA_HINT_DEFAULT_1:
+    fDefault = 1;
+    break;
+  case LADSPA_HINT_DEFAULT_100:
+    fDefault = 100;
+    break;
+  case LADSPA_HINT_DEFAULT_440:
+    fDefault = 440;
+    break;
+  default:
+    printf("LADSPA warning: UNKNOWN DEFAULT CODE\n");
+    // (Not necessarily an error - may be a newer version.)
+    break;
+  }
+  return fDefault;
+}
+
+// LadspaIndex: process-wide map from plugin label / UniqueID to the
+// library that provides it and the descriptor index inside it, so that
+// plugins can be activated by label without dlopen-ing every library on
+// LADSPA_PATH. The scan result is persisted in a cache file (LADSPA_INDEX,
+// or ~/.chuck-ladspa-index); a library is only reopened when its mtime
+// differs from the cached one. An entry that no longer matches its library
+// (the library was rebuilt after the scan) triggers a rescan, see refresh().
+// Directory scanning is POSIX-only; on Windows the index is empty and
+// plugins must be loaded by filename.
+class LadspaIndex
+{
+public:
+  struct Entry
+  {
+	std::string path;
+	unsigned long index; // argument to ladspa_descriptor()
+	unsigned long uniqueID;
+	std::string label;
+  };
+
+  static LadspaIndex & instance()
+  {
+	static LadspaIndex index;
+	return index;
+  }
+
+  // entries are returned by copy, a rescan replaces them
+  bool find( const char * label, Entry & entry )
+  {
+	std::lock_guard<std::mutex> lock(mutex);
+	if (!scanned) scan();
+	std::unordered_map<std::string, size_t>::iterator it = byLabel.find(label);
+	if (it == byLabel.end()) return false;
+	entry = entries[it->second];
+	return true;
+  }
+
+  bool find( unsigned long uniqueID, Entry & entry )
+  {
+	std::lock_guard<std::mutex> lock(mutex);
+	if (!scanned) scan();
+	std::unordered_map<unsigned long, size_t>::iterator it = byID.find(uniqueID);
+	if (it == byID.end()) return false;
+	entry = entries[it->second];
+	return true;
+  }
+
+  // true if d is the plugin the entry describes
+  static bool matches( const LADSPA_Descriptor * d, const Entry & entry )
+  {
+	return d != NULL && d->UniqueID == entry.uniqueID && entry.label == d->Label;
+  }
+
+  // the entry's library has changed since it was scanned: rescan every
+  // library whose mtime moved and look the plugin up again by UniqueID
+  bool refresh( Entry & entry )
+  {
+	std::lock_guard<std::mutex> lock(mutex);
+	scan();
+	std::unordered_map<unsigned long, size_t>::iterator it = byID.find(entry.uniqueID);
+	if (it == byID.end()) return false;
+	entry = entries[it->second];
+	return true;
+  }
+
+private:
+  struct Library
+  {
+	time_t mtime;
+	std::vector<Entry> plugins;
+  };
+
+  LadspaIndex() : scanned(false) {}
+
+  static std::string cachePath()
+  {
+	const char * env = getenv("LADSPA_INDEX");
+	if (env && *env) return env;
+	const char * home = getenv("HOME");
+	if (home == NULL) return "";
+	return std::string(home) + "/.chuck-ladspa-index";
+  }
+
+  static std::string searchPath()
+  {
+	const char * env = getenv("LADSPA_PATH");
+	if (env && *env) return env;
+	std::string path = "/usr/local/lib/ladspa:/usr/lib/ladspa";
+	const char * home = getenv("HOME");
+	if (home) path = std::string(home) + "/.ladspa:" + path;
+	return path;
+  }
+
+  // cache format: "L <mtime> <path>" for each library, followed by one
+  // "P <index> <uniqueID> <label>" line per plugin (labels have no spaces)
+  void readCache( std::map<std::string, Library> & cache )
+  {
+	std::string file = cachePath();
+	if (file.empty()) return;
+	FILE * fp = fopen(file.c_str(), "r");
+	if (fp == NULL) return;
+	char line[4096];
+	Library * current = NULL;
+	while (fgets(line, sizeof(line), fp))
+	  {
+		line[strcspn(line, "\r\n")] = 0;
+		long long mtime;
+		unsigned long index, uniqueID;
+		int offset = 0;
+		char label[1024];
+		if (sscanf(line, "L %lld %n", &mtime, &offset) == 1 && offset > 0)
+		  {
+			current = &cache[line + offset];
+			current->mtime = (time_t)mtime;
+			current->plugins.clear();
+		  }
+		else if (current && sscanf(line, "P %lu %lu %1023s", &index, &uniqueID, label) == 3)
+		  {
+			Entry entry;
+			entry.index = index;
+			entry.uniqueID = uniqueID;
+			entry.label = label;
+			current->plugins.push_back(entry);
+		  }
+	  }
+	fclose(fp);
+  }
+
+  // written to a temporary file next to the cache and renamed over it, so
+  // that a concurrent reader or a crash never sees a partial index
+  void writeCache( const std::map<std::string, Library> & cache )
+  {
+	std::string file = cachePath();
+	if (file.empty()) return;
+#if !defined(__PLATFORM_WINDOWS__)
+	std::string temp = file + ".tmp." + std::to_string((long)getpid());
+#else
+	std::string temp = file + ".tmp";
+#endif
+	FILE * fp = fopen(temp.c_str(), "w");
+	if (fp == NULL) return;
+	for (std::map<std::string, Library>::const_iterator it = cache.begin(); it != cache.end(); ++it)
+	  {
+		fprintf(fp, "L %lld %s\n", (long long)it->second.mtime, it->first.c_str());
+		for (size_t i=0; i<it->second.plugins.size(); i++)
+		  {
+			const Entry & e = it->second.plugins[i];
+			fprintf(fp, "P %lu %lu %s\n", e.index, e.uniqueID, e.label.c_str());
+		  }
+	  }
+	bool ok = !ferror(fp);
+	if (fclose(fp) != 0) ok = false;
+#if defined(__PLATFORM_WINDOWS__)
+	if (ok) remove(file.c_str());
+#endif
+	if (!ok || rename(temp.c_str(), file.c_str()) != 0)
+	  remove(temp.c_str());
+  }
+
+  // open a library once and record all of its descriptors
+  static void scanLibrary( const std::string & path, Library & library )
+  {
+	library.plugins.clear();
+	void * pvLibrary = dlopen(path.c_str(), RTLD_NOW);
+	if (pvLibrary == NULL) return;
+	LADSPA_Descriptor_Function pfDescriptorFunction =
+	  (LADSPA_Descriptor_Function)dlsym(pvLibrary, "ladspa_descriptor");
+	for (unsigned long i=0; pfDescriptorFunction; i++)
+	  {
+		const LADSPA_Descriptor * d = pfDescriptorFunction(i);
+		if (d == NULL) break;
+		Entry entry;
+		entry.index = i;
+		entry.uniqueID = d->UniqueID;
+		entry.label = d->Label;
+		library.plugins.push_back(entry);
+	  }
+	dlclose(pvLibrary);
+  }
+
+  void scan()
+  {
+	entries.clear();
+	byLabel.clear();
+	byID.clear();
+	scanned = true;
+
+	std::map<std::string, Library> cache;
+	readCache(cache);
+	std::map<std::string, Library> found;
+	std::vector<std::string> order; // LADSPA_PATH order decides label clashes
+	bool dirty = false;
+#if !defined(__PLATFORM_WINDOWS__)
+	std::string path = searchPath();
+	size_t start = 0;
+	while (start <= path.size())
+	  {
+		size_t end = path.find(':', start);
+		if (end == std::string::npos) end = path.size();
+		std::string dir = path.substr(start, end - start);
+		start = end + 1;
+		DIR * pDir = dir.empty() ? NULL : opendir(dir.c_str());
+		if (pDir == NULL) continue;
+		std::vector<std::string> names;
+		while (struct dirent * ent = readdir(pDir))
+		  {
+			std::string name = ent->d_name;
+			if (name.size() > 3 && name.compare(name.size() - 3, 3, ".so") == 0)
+			  names.push_back(name);
+		  }
+		closedir(pDir);
+		std::sort(names.begin(), names.end());
+		for (size_t i=0; i<names.size(); i++)
+		  {
+			std::string file = dir + "/" + names[i];
+			struct stat st;
+			if (stat(file.c_str(), &st) != 0 || found.count(file)) continue;
+			std::map<std::string, Library>::iterator cached = cache.find(file);
+			if (cached != cache.end() && cached->second.mtime == st.st_mtime)
+			  found[file] = cached->second;
+			else
+			  {
+				Library & library = found[file];
+				library.mtime = st.st_mtime;
+				scanLibrary(file, library);
+				dirty = true;
+			  }
+			order.push_back(file);
+		  }
+	  }
+#endif
+	if (found.size() != cache.size()) dirty = true;
+	if (dirty) writeCache(found);
+
+	for (size_t i=0; i<order.size(); i++)
+	  {
+		const Library & library = found[order[i]];
+		for (size_t k=0; k<library.plugins.size(); k++)
+		  {
+			Entry entry = library.plugins[k];
+			entry.path = order[i];
+			entries.push_back(entry);
+		  }
+	  }
+	for (size_t i=0; i<entries.size(); i++)
+	  {
+		byLabel.insert(std::make_pair(entries[i].label, i));
+		byID.insert(std::make_pair(entries[i].uniqueID, i));
+	  }
+  }
+
+  std::vector<Entry> entries;
+  std::unordered_map<std::string, size_t> byLabel;
+  std::unordered_map<unsigned long, size_t> byID;
+  std::mutex mutex;
+  bool scanned;
+};
 
 // class definition for internal Chugin data
 // (note: this isn't strictly necessary, but serves as example
@@ -56,15 +433,25 @@ public:
 	unsigned short ladspaIndex;
 	LADSPA_Data value;
 	port_t porttype;
+	Chuck_Object * source; // LADSPAControl driving this port, or NULL
+	LadspaControlSource * input; // its data
+	LADSPA_Data pole; // one-pole smoothing of the control input
   };
 
   // constructor
-  Ladspa( t_CKFLOAT fs) :
+  Ladspa( t_CKFLOAT fs, CK_DL_API api ) :
+    inbuf(NULL),
+    outbuf(NULL),
+    kbuf(NULL),
     pluginLoaded(false),
     pluginActivated(false),
     verbose(true),
+    bufsize(DEFAULT_BUFSIZE),
+    kports(0),
+    inports(0),
+    outports(0),
     srate(fs),
-    bufsize(DEFAULT_BUFSIZE)
+    api(api)
   {
   }
 
@@ -77,36 +464,35 @@ public:
 	dlclose(pvPluginHandle);
 	if (verbose) printf("LADSPA: closed plugin\n");
       }
-	for (int i=0; i<inports; i++)
-	  delete inbuf[i];
-	for (int i=0; i<outports; i++)
-	  delete outbuf[i];
-	delete [] inbuf;
-	delete [] outbuf;
-	delete [] kbuf;
+	freePorts();
   }
   
   // for Chugins extending UGen
   void tick( SAMPLE *in, SAMPLE *out, int nframes )
   {
-	if (pluginActivated)
+	for (int f=0; f<nframes; f++, in += 2, out += 2)
 	  {
-		for (int i=0; i<inports; i++) inbuf[i][0] = (LADSPA_Data)in[i%2];
-		psDescriptor->run(pPlugin, bufsize);
-		for (int i=0; i<2; i++) out[i%2] = (SAMPLE)outbuf[i%outports][0];
-	  }
-	else
-	  {
-		out[0] = in[0];
-		out[1] = in[1];
+		if (pluginActivated)
+		  {
+			for (int k=0; k<kports; k++)
+			  if (kbuf[k].input)
+				kbuf[k].value += (1 - kbuf[k].pole)
+				  * (kbuf[k].input->value - kbuf[k].value);
+			for (int i=0; i<inports; i++) inbuf[i][0] = (LADSPA_Data)in[i%2];
+			psDescriptor->run(pPlugin, bufsize);
+		  }
+		if (pluginActivated && outports > 0)
+		  for (int i=0; i<2; i++) out[i%2] = (SAMPLE)outbuf[i%outports][0];
+		else
+		  {
+			out[0] = in[0];
+			out[1] = in[1];
+		  }
 	  }
   }
 
   float set( float val, int param)
   {
-#ifdef DEBUG
-    printf ("DEBUG: method 'set' : param number %d, value %f\n",param, val);
-#endif
 	if (pluginActivated)
 	  {
 		if (param < kports)
@@ -116,12 +502,7 @@ public:
 			  return 0;
 			}
 		  else
-			{
-			  if (verbose) printf ("LADSPA: setting parameter \"%s\" to %g\n",
-								   psDescriptor->PortNames[kbuf[param].ladspaIndex], val);
-			  kbuf[param].value = (LADSPA_Data)val;
-			  psDescriptor->run(pPlugin, 0);
-			}
+			kbuf[param].value = (LADSPA_Data)val;
 		else
 		  if (kports>1)
 			printf ("LADSPA error: param must be between 0 and %d.\n", kports-1);
@@ -145,11 +526,39 @@ public:
 	return 0;
   }
 
+  // drive control input <param> from the latest sample of <source>, a
+  // LADSPAControl; null returns the param to set()
+  int control( int param, Chuck_Object * source, LadspaControlSource * input )
+  {
+	if (!pluginActivated || param < 0 || param >= kports || kbuf[param].porttype != INPUT)
+	  {
+		printf ("LADSPA error: no control input %d.\n", param);
+		return -1;
+	  }
+	if (source) api->object->add_ref(source);
+	if (kbuf[param].source) api->object->release(kbuf[param].source);
+	kbuf[param].source = source;
+	kbuf[param].input = source ? input : NULL;
+	return param;
+  }
+
+  // one-pole smoothing of a driven param: 0 follows the control input
+  // exactly, values towards 1 glide more slowly
+  float smooth( int param, float pole )
+  {
+	if (!pluginActivated || param < 0 || param >= kports)
+	  {
+		printf ("LADSPA error: no control input %d.\n", param);
+		return 0;
+	  }
+	if (pole < 0) pole = 0;
+	if (pole > 0.9999f) pole = 0.9999f;
+	kbuf[param].pole = pole;
+	return pole;
+  }
+
   int LADSPAverbose (int val)
   {
-#ifdef DEBUG
-    printf ("DEBUG: method 'verbose' : value %d\n", val);
-#endif
 	if (val) verbose = true;
 	else verbose = false;
 	return val;
@@ -158,40 +567,44 @@ public:
   int LadspaActivate ( const char * pcPluginLabel )
   {
 	assert(pcPluginLabel != NULL);
-	if (pluginLoaded)
-	  {
 #ifdef DEBUG
-	    printf("DEBUG: method 'LadspaActivate' received string \"%s\"\n", pcPluginLabel);
+	printf("DEBUG: method 'LadspaActivate' received string \"%s\"\n", pcPluginLabel);
 #endif
-	    if (pluginActivated)
-	      {
-		psDescriptor->cleanup(pPlugin);
-		if (verbose) printf("LADSPA: deactivating current plugin...\n");
-		pluginActivated = false;
-	      }
+	deactivate();
+	if (pluginLoaded)
+	  {
 	    for (int i=0;; i++)
 		  {
 			psDescriptor = pfDescriptorFunction(i);
 			if (psDescriptor == NULL)
-			  {
-				printf("LADSPA error: unable to find label \"%s\" in plugin.\n", pcPluginLabel);
-				return 0;
-			  }
+			  break;
 			if (strcmp(psDescriptor->Label, pcPluginLabel) == 0)
-			  {
-				if (verbose) printf("LADSPA: activating plugin \"%s\"\n", pcPluginLabel);
-				pPlugin = psDescriptor->instantiate(psDescriptor, srate);
-				connectPorts();
-				pluginActivated = true;
-				return 1;
-			  }
+			  return activateDescriptor();
 		  }
 	  }
+	// not in the loaded file: look the label up on LADSPA_PATH
+	LadspaIndex::Entry entry;
+	if (LadspaIndex::instance().find(pcPluginLabel, entry))
+	  return activateIndexed(entry);
+	if (pluginLoaded)
+	  printf("LADSPA error: unable to find label \"%s\" in plugin.\n", pcPluginLabel);
 	else
-	  printf ("LADSPA error: no plugin loaded yet!\n");
+	  printf("LADSPA error: unable to find label \"%s\" on LADSPA_PATH.\n", pcPluginLabel);
 	return 0;
   }
 
+  int LadspaActivate ( unsigned long uniqueID )
+  {
+	deactivate();
+	LadspaIndex::Entry entry;
+	if (!LadspaIndex::instance().find(uniqueID, entry))
+	  {
+		printf("LADSPA error: unable to find plugin ID %lu on LADSPA_PATH.\n", uniqueID);
+		return 0;
+	  }
+	return activateIndexed(entry);
+  }
+
   int LADSPA_load ( const char *  pcPluginFilename )
   {
 #ifdef DEBUG
@@ -229,6 +642,7 @@ public:
 		return 0;
       }
 	pluginLoaded = true;
+	loadedPath = pcPluginFilename;
 	return 1;
   }
 
@@ -342,12 +756,76 @@ int LADSPA_info ()
   }
 
 private:
+
+  // drop the references control() took and the port buffers of the
+  // current plugin, if any
+  void freePorts()
+  {
+	for (int k=0; k<kports; k++)
+	  if (kbuf[k].source)
+		api->object->release(kbuf[k].source);
+	for (int i=0; i<inports; i++)
+	  delete [] inbuf[i];
+	for (int i=0; i<outports; i++)
+	  delete [] outbuf[i];
+	delete [] inbuf;
+	delete [] outbuf;
+	delete [] kbuf;
+	inbuf = NULL;
+	outbuf = NULL;
+	kbuf = NULL;
+	inports = outports = kports = 0;
+  }
+
+  void deactivate()
+  {
+	if (pluginActivated)
+	  {
+		psDescriptor->cleanup(pPlugin);
+		if (verbose) printf("LADSPA: deactivating current plugin...\n");
+		pluginActivated = false;
+	  }
+  }
+
+  int activateDescriptor()
+  {
+	if (verbose) printf("LADSPA: activating plugin \"%s\"\n", psDescriptor->Label);
+	pPlugin = psDescriptor->instantiate(psDescriptor, srate);
+	connectPorts();
+	pluginActivated = true;
+	return 1;
+  }
+
+  // load the library found by the index and activate a plugin by its
+  // descriptor index, without walking the library's descriptors; if the
+  // library no longer matches the index, rescan and try once more
+  int activateIndexed( LadspaIndex::Entry entry )
+  {
+	for (int attempt=0;; attempt++)
+	  {
+		if (!(pluginLoaded && entry.path == loadedPath && attempt == 0)
+			&& !LADSPA_load(entry.path.c_str()))
+		  return 0;
+		psDescriptor = pfDescriptorFunction(entry.index);
+		if (LadspaIndex::matches(psDescriptor, entry))
+		  return activateDescriptor();
+		if (attempt > 0 || !LadspaIndex::instance().refresh(entry))
+		  {
+			printf("LADSPA error: plugin ID %lu is no longer on LADSPA_PATH.\n", entry.uniqueID);
+			return 0;
+		  }
+		if (verbose) printf("LADSPA: \"%s\" has changed, rescanned LADSPA_PATH\n", loadedPath.c_str());
+	  }
+  }
   
   void connectPorts()
   {
 	//const LADSPA_Descriptor * thisDescriptor = psDescriptor;
     //printf("Connecting LADSPA audio ports...\n\n");
 
+    // the previous plugin's buffers, counted with its own port counts
+    freePorts();
+
     // Count ports
     inports = 0; // audio in
     outports = 0; // audio out
@@ -383,6 +861,9 @@ private:
 	kbuf[i].value = 0.0;
 	kbuf[i].ladspaIndex = 0;
 	kbuf[i].porttype = INPUT;
+	kbuf[i].source = NULL;
+	kbuf[i].input = NULL;
+	kbuf[i].pole = 0;
       }
 	
     //printf("Audio inports: %d, outports: %d, Control ports: %d\n",inports, outports, kports);
@@ -426,77 +907,7 @@ private:
 
   LADSPA_Data get_default ( int index )
   {
-	iHintDescriptor = psDescriptor->PortRangeHints[index].HintDescriptor;
-	switch (iHintDescriptor & LADSPA_HINT_DEFAULT_MASK) {
-	case LADSPA_HINT_DEFAULT_NONE:
-	  break;
-	case LADSPA_HINT_DEFAULT_MINIMUM:
-	  fDefault = psDescriptor->PortRangeHints[index].LowerBound;
-	  break;
-	case LADSPA_HINT_DEFAULT_LOW:
-	  if (LADSPA_IS_HINT_LOGARITHMIC(iHintDescriptor)) {
-		fDefault 
-		  = exp(log(psDescriptor->PortRangeHints[index].LowerBound) 
-				* 0.75
-				+ log(psDescriptor->PortRangeHints[index].UpperBound) 
-				* 0.25);
-	  }
-	  else {
-		fDefault 
-		  = (psDescriptor->PortRangeHints[index].LowerBound
-			 * 0.75
-			 + psDescriptor->PortRangeHints[index].UpperBound
-			 * 0.25);
-	  }
-	  break;
-	case LADSPA_HINT_DEFAULT_MIDDLE:
-	  if (LADSPA_IS_HINT_LOGARITHMIC(iHintDescriptor)) {
-		fDefault 
-		  = sqrt(psDescriptor->PortRangeHints[index].LowerBound
-				 * psDescriptor->PortRangeHints[index].UpperBound);
-	  }
-	  else {
-		fDefault 
-		  = 0.5 * (psDescriptor->PortRangeHints[index].LowerBound
-				   + psDescriptor->PortRangeHints[index].UpperBound);
-	  }
-	  break;
-	case LADSPA_HINT_DEFAULT_HIGH:
-	  if (LADSPA_IS_HINT_LOGARITHMIC(iHintDescriptor)) {
-		fDefault 
-		  = exp(log(psDescriptor->PortRangeHints[index].LowerBound) 
-				* 0.25
-				+ log(psDescriptor->PortRangeHints[index].UpperBound) 
-				* 0.75);
-	  }
-	  else {
-		fDefault 
-		  = (psDescriptor->PortRangeHints[index].LowerBound
-			 * 0.25
-			 + psDescriptor->PortRangeHints[index].UpperBound
-			 * 0.75);
-	  }
-	  break;
-	case LADSPA_HINT_DEFAULT_MAXIMUM:
-	  fDefault = psDescriptor->PortRangeHints[index].UpperBound;
-	  break;
-	case LADSPA_HINT_DEFAULT_0:
-	  fDefault = 0;
-	  break;
-	case LADSPA_HINT_DEFAULT_1:
-	  fDefault = 1;
-	  break;
-	case LADSPA_HINT_DEFAULT_100:
-	  fDefault = 100;
-	  break;
-	case LADSPA_HINT_DEFAULT_440:
-	  fDefault = 440;
-	  break;
-	default:
-	  printf("LADSPA warning: UNKNOWN DEFAULT CODE\n");
-	  // (Not necessarily an error - may be a newer version.)
-	  break;
-	}
+	fDefault = ladspa_get_default(psDescriptor, index);
 	return fDefault;
   }
   
@@ -511,12 +922,384 @@ private:
   LADSPA_Data ** inbuf, ** outbuf; // audio in and out buffers (multichannel)
   ControlData * kbuf; // control data buffers
   void * pvPluginHandle;
+  std::string loadedPath;
   bool pluginLoaded, pluginActivated;
   bool verbose;
   int bufsize;
   unsigned short numchans;
   unsigned short kports, inports, outports;
   float srate;
+  CK_DL_API api;
+};
+
+// maximum number of frames the chain processes in one pass; larger
+// tickf blocks are split into chunks of this size
+#define CHAIN_MAXBLOCK 256
+// the chain is a stereo signal path, like LADSPA
+#define CHAIN_CHANS 2
+
+// LadspaChain: an ordered list of LADSPA plugins hosted inside a single
+// UGen. All stages share one pair of stereo block buffers; each stage
+// reads from the current buffer and writes either back into it (when
+// the plugin allows in-place processing) or into the other buffer of
+// the pair. Stages with a wet gain are mixed on top of their dry input
+// with run_adding when the plugin provides it.
+class LadspaChain
+{
+public:
+  struct Stage
+  {
+	void * pvLibrary;
+	const LADSPA_Descriptor * psDescriptor;
+	LADSPA_Handle pPlugin;
+	std::vector<unsigned long> audioIn, audioOut; // LADSPA port indices
+	std::vector<unsigned long> controlIndex; // LADSPA port index per control
+	std::vector<LADSPA_Data> control; // control port values
+	std::vector<bool> controlIsInput;
+	LADSPA_Data wet; // < 0: replace the signal; otherwise dry + wet * plugin
+	bool inplace, adding;
+	int src, dst; // buffer pair indices assigned by wire()
+  };
+
+  LadspaChain( t_CKFLOAT fs ) :
+	verbose(true),
+	srate(fs)
+  {
+	memset(buf, 0, sizeof(buf));
+	memset(scratch, 0, sizeof(scratch));
+	memset(trash, 0, sizeof(trash));
+  }
+
+  ~LadspaChain()
+  {
+	clear();
+  }
+
+  void tick( SAMPLE * in, SAMPLE * out, int nframes )
+  {
+	if (stages.empty())
+	  {
+		memcpy(out, in, sizeof(SAMPLE) * nframes * CHAIN_CHANS);
+		return;
+	  }
+	while (nframes > 0)
+	  {
+		int n = nframes < CHAIN_MAXBLOCK ? nframes : CHAIN_MAXBLOCK;
+		for (int f=0; f<n; f++)
+		  for (int c=0; c<CHAIN_CHANS; c++)
+			buf[0][c][f] = (LADSPA_Data)in[f*CHAIN_CHANS+c];
+		run(n);
+		int last = stages.back().dst;
+		for (int f=0; f<n; f++)
+		  for (int c=0; c<CHAIN_CHANS; c++)
+			out[f*CHAIN_CHANS+c] = (SAMPLE)buf[last][c][f];
+		in += n * CHAIN_CHANS;
+		out += n * CHAIN_CHANS;
+		nframes -= n;
+	  }
+  }
+
+  int add( const char * pcPluginFilename, const char * pcPluginLabel )
+  {
+	void * pvLibrary = openLibrary(pcPluginFilename);
+	if (pvLibrary == NULL)
+	  return -1;
+	LADSPA_Descriptor_Function pfDescriptorFunction =
+	  (LADSPA_Descriptor_Function)dlsym(pvLibrary, "ladspa_descriptor");
+	const LADSPA_Descriptor * psDescriptor = NULL;
+	for (int i=0; pfDescriptorFunction; i++)
+	  {
+		psDescriptor = pfDescriptorFunction(i);
+		if (psDescriptor == NULL || strcmp(psDescriptor->Label, pcPluginLabel) == 0)
+		  break;
+	  }
+	if (psDescriptor == NULL)
+	  {
+		printf("LADSPA error: unable to find label \"%s\" in \"%s\".\n",
+			   pcPluginLabel, pcPluginFilename);
+		closeLibrary(pvLibrary);
+		return -1;
+	  }
+	return addDescriptor(pvLibrary, psDescriptor);
+  }
+
+  // add a plugin found on LADSPA_PATH by label
+  int add( const char * pcPluginLabel )
+  {
+	LadspaIndex::Entry entry;
+	if (!LadspaIndex::instance().find(pcPluginLabel, entry))
+	  {
+		printf("LADSPA error: unable to find label \"%s\" on LADSPA_PATH.\n", pcPluginLabel);
+		return -1;
+	  }
+	return addIndexed(entry);
+  }
+
+  // add a plugin found on LADSPA_PATH by UniqueID
+  int add( unsigned long uniqueID )
+  {
+	LadspaIndex::Entry entry;
+	if (!LadspaIndex::instance().find(uniqueID, entry))
+	  {
+		printf("LADSPA error: unable to find plugin ID %lu on LADSPA_PATH.\n", uniqueID);
+		return -1;
+	  }
+	return addIndexed(entry);
+  }
+
+  void clear()
+  {
+	for (size_t i=0; i<stages.size(); i++)
+	  {
+		const LADSPA_Descriptor * d = stages[i].psDescriptor;
+		if (d->deactivate) d->deactivate(stages[i].pPlugin);
+		d->cleanup(stages[i].pPlugin);
+	  }
+	stages.clear();
+	for (size_t i=0; i<libraries.size(); i++)
+	  dlclose(libraries[i].second);
+	libraries.clear();
+  }
+
+  int size() { return (int)stages.size(); }
+
+  float set( int stage, int param, float val )
+  {
+	if (!checkParam(stage, param)) return 0;
+	if (!stages[stage].controlIsInput[param])
+	  {
+		printf("LADSPA error: selected param is output only.\n");
+		return 0;
+	  }
+	stages[stage].control[param] = (LADSPA_Data)val;
+	return val;
+  }
+
+  float get( int stage, int param )
+  {
+	if (!checkParam(stage, param)) return 0;
+	return stages[stage].control[param];
+  }
+
+  float wet( int stage, float gain )
+  {
+	if (stage < 0 || stage >= (int)stages.size())
+	  {
+		printf("LADSPA error: no plugin at chain position %d.\n", stage);
+		return 0;
+	  }
+	stages[stage].wet = gain;
+	wire();
+	return gain;
+  }
+
+  float wet( int stage )
+  {
+	if (stage < 0 || stage >= (int)stages.size()) return 0;
+	return stages[stage].wet;
+  }
+
+  int setVerbose( int val )
+  {
+	verbose = val != 0;
+	return val;
+  }
+
+private:
+  // as Ladspa::activateIndexed: a stale entry rescans LADSPA_PATH once
+  int addIndexed( LadspaIndex::Entry entry )
+  {
+	for (int attempt=0;; attempt++)
+	  {
+		void * pvLibrary = openLibrary(entry.path.c_str());
+		if (pvLibrary == NULL)
+		  return -1;
+		LADSPA_Descriptor_Function pfDescriptorFunction =
+		  (LADSPA_Descriptor_Function)dlsym(pvLibrary, "ladspa_descriptor");
+		const LADSPA_Descriptor * psDescriptor =
+		  pfDescriptorFunction ? pfDescriptorFunction(entry.index) : NULL;
+		if (LadspaIndex::matches(psDescriptor, entry))
+		  return addDescriptor(pvLibrary, psDescriptor);
+		// let go of it, so a changed file is loaded afresh on the retry
+		closeLibrary(pvLibrary);
+		if (attempt > 0 || !LadspaIndex::instance().refresh(entry))
+		  {
+			printf("LADSPA error: plugin ID %lu is no longer on LADSPA_PATH.\n", entry.uniqueID);
+			return -1;
+		  }
+		if (verbose) printf("LADSPA: \"%s\" has changed, rescanned LADSPA_PATH\n", entry.path.c_str());
+	  }
+  }
+
+  int addDescriptor( void * pvLibrary, const LADSPA_Descriptor * psDescriptor )
+  {
+	const char * pcPluginLabel = psDescriptor->Label;
+	Stage stage;
+	stage.pvLibrary = pvLibrary;
+	stage.psDescriptor = psDescriptor;
+	stage.pPlugin = psDescriptor->instantiate(psDescriptor, srate);
+	if (stage.pPlugin == NULL)
+	  {
+		printf("LADSPA error: unable to instantiate \"%s\".\n", pcPluginLabel);
+		closeLibrary(pvLibrary);
+		return -1;
+	  }
+	stage.wet = -1;
+	for (unsigned long i=0; i<psDescriptor->PortCount; i++)
+	  {
+		LADSPA_PortDescriptor iPortDescriptor = psDescriptor->PortDescriptors[i];
+		if (LADSPA_IS_PORT_AUDIO(iPortDescriptor))
+		  {
+			if (LADSPA_IS_PORT_INPUT(iPortDescriptor)) stage.audioIn.push_back(i);
+			else stage.audioOut.push_back(i);
+		  }
+		else if (LADSPA_IS_PORT_CONTROL(iPortDescriptor))
+		  {
+			bool isInput = LADSPA_IS_PORT_INPUT(iPortDescriptor);
+			stage.controlIndex.push_back(i);
+			stage.controlIsInput.push_back(isInput);
+			stage.control.push_back(isInput ? ladspa_get_default(psDescriptor, i) : 0);
+		  }
+	  }
+	stages.push_back(stage);
+	// control values live in the stage vectors, so (re)connect them once
+	// the stage has reached its final address
+	Stage & s = stages.back();
+	for (size_t k=0; k<s.controlIndex.size(); k++)
+	  psDescriptor->connect_port(s.pPlugin, s.controlIndex[k], &s.control[k]);
+	if (psDescriptor->activate) psDescriptor->activate(s.pPlugin);
+	if (verbose) printf("LADSPA: added \"%s\" to chain at position %d\n",
+						pcPluginLabel, (int)stages.size()-1);
+	wire();
+	return (int)stages.size() - 1;
+  }
+
+  void * openLibrary( const char * pcPluginFilename )
+  {
+	// plugins from the same file share one library handle
+	for (size_t i=0; i<libraries.size(); i++)
+	  if (libraries[i].first == pcPluginFilename)
+		return libraries[i].second;
+	void * pvLibrary = dlopen(pcPluginFilename, RTLD_NOW);
+	if (pvLibrary == NULL)
+	  {
+		printf("LADSPA error: unable to open \"%s\".\n", pcPluginFilename);
+		return NULL;
+	  }
+	if (dlsym(pvLibrary, "ladspa_descriptor") == NULL)
+	  {
+		printf("LADSPA error: unable to find ladspa_descriptor() function in plugin file "
+			   "\"%s\"\n", pcPluginFilename);
+		dlclose(pvLibrary);
+		return NULL;
+	  }
+	libraries.push_back(std::make_pair(std::string(pcPluginFilename), pvLibrary));
+	return pvLibrary;
+  }
+
+  // close a library opened by openLibrary() unless a stage still uses it
+  void closeLibrary( void * pvLibrary )
+  {
+	for (size_t i=0; i<stages.size(); i++)
+	  if (stages[i].pvLibrary == pvLibrary)
+		return;
+	for (size_t i=0; i<libraries.size(); i++)
+	  if (libraries[i].second == pvLibrary)
+		{
+		  dlclose(pvLibrary);
+		  libraries.erase(libraries.begin() + i);
+		  return;
+		}
+  }
+
+  bool checkParam( int stage, int param )
+  {
+	if (stage < 0 || stage >= (int)stages.size())
+	  {
+		printf("LADSPA error: no plugin at chain position %d.\n", stage);
+		return false;
+	  }
+	if (param < 0 || param >= (int)stages[stage].control.size())
+	  {
+		printf("LADSPA error: plugin %d has no param %d.\n", stage, param);
+		return false;
+	  }
+	return true;
+  }
+
+  // assign block buffers to every stage and connect its audio ports.
+  // Audio input port i reads channel i%2; output port j writes channel
+  // j (ports past the second go to a scratch buffer, and a mono output
+  // is copied to the right channel after the run).
+  void wire()
+  {
+	int cur = 0;
+	for (size_t s=0; s<stages.size(); s++)
+	  {
+		Stage & st = stages[s];
+		const LADSPA_Descriptor * d = st.psDescriptor;
+		bool canInplace = !LADSPA_IS_INPLACE_BROKEN(d->Properties);
+		st.adding = st.wet >= 0 && d->run_adding && d->set_run_adding_gain;
+		// a dry/wet stage without run_adding keeps the dry signal intact
+		st.inplace = canInplace && (st.wet < 0 || st.adding);
+		st.src = cur;
+		st.dst = st.audioOut.empty() || st.inplace ? cur : 1 - cur;
+		for (size_t i=0; i<st.audioIn.size(); i++)
+		  d->connect_port(st.pPlugin, st.audioIn[i], buf[st.src][i % CHAIN_CHANS]);
+		for (size_t j=0; j<st.audioOut.size(); j++)
+		  d->connect_port(st.pPlugin, st.audioOut[j],
+						  j < CHAIN_CHANS ? buf[st.dst][j] : trash);
+		if (st.adding) d->set_run_adding_gain(st.pPlugin, st.wet);
+		cur = st.dst;
+	  }
+  }
+
+  void run( int n )
+  {
+	for (size_t s=0; s<stages.size(); s++)
+	  {
+		Stage & st = stages[s];
+		const LADSPA_Descriptor * d = st.psDescriptor;
+		LADSPA_Data (*src)[CHAIN_MAXBLOCK] = buf[st.src];
+		LADSPA_Data (*dst)[CHAIN_MAXBLOCK] = buf[st.dst];
+		if (st.audioOut.empty())
+		  {
+			d->run(st.pPlugin, n);
+			continue;
+		  }
+		if (st.adding)
+		  {
+			// run_adding sums onto whatever is in the output buffer, so it
+			// has to start out holding the dry signal
+			if (!st.inplace)
+			  for (int c=0; c<CHAIN_CHANS; c++)
+				memcpy(dst[c], src[c], sizeof(LADSPA_Data) * n);
+			if (st.audioOut.size() == 1)
+			  memcpy(scratch, dst[0], sizeof(LADSPA_Data) * n);
+			d->run_adding(st.pPlugin, n);
+			// a mono plugin only added to the left channel
+			if (st.audioOut.size() == 1)
+			  for (int f=0; f<n; f++)
+				dst[1][f] += dst[0][f] - scratch[f];
+			continue;
+		  }
+		d->run(st.pPlugin, n);
+		if (st.audioOut.size() == 1)
+		  memcpy(dst[1], dst[0], sizeof(LADSPA_Data) * n);
+		if (st.wet >= 0)
+		  for (int c=0; c<CHAIN_CHANS; c++)
+			for (int f=0; f<n; f++)
+			  dst[c][f] = src[c][f] + st.wet * dst[c][f];
+	  }
+  }
+
+  std::vector<Stage> stages;
+  std::vector< std::pair<std::string, void *> > libraries;
+  LADSPA_Data buf[2][CHAIN_CHANS][CHAIN_MAXBLOCK]; // ping-pong block buffers
+  LADSPA_Data scratch[CHAIN_MAXBLOCK];
+  LADSPA_Data trash[CHAIN_MAXBLOCK]; // sink for extra output ports
+  bool verbose;
+  float srate;
 };
 
 
@@ -528,6 +1311,18 @@ CK_DLL_QUERY( Ladspa )
   // hmm, don't change this...
   QUERY->setname(QUERY, "LADSPA");
   
+  // LADSPAControl: declared first, LADSPA.control() takes one
+  QUERY->begin_class(QUERY, "LADSPAControl", "UGen");
+  QUERY->doc_class(QUERY, "Drives a LADSPA control port with a signal. The input "
+                   "passes through unchanged; connect the output to blackhole "
+                   "(or anything that is ticked) and bind it with "
+                   "LADSPA.control(param, source).");
+  QUERY->add_ctor(QUERY, ladspacontrol_ctor);
+  QUERY->add_dtor(QUERY, ladspacontrol_dtor);
+  QUERY->add_ugen_func(QUERY, ladspacontrol_tick, NULL, 1, 1);
+  ladspacontrol_data_offset = QUERY->add_mvar(QUERY, "int", "@lc_data", false);
+  QUERY->end_class(QUERY);
+
   // begin the class definition
   // can change the second argument to extend a different ChucK class
   QUERY->begin_class(QUERY, "LADSPA", "UGen");
@@ -554,6 +1349,10 @@ CK_DLL_QUERY( Ladspa )
   // example of adding argument to the above method
   QUERY->add_arg(QUERY, "string", "label");
 
+  // activate a plugin on LADSPA_PATH by its unique ID
+  QUERY->add_mfun(QUERY, ladspa_labelID, "int", "activate");
+  QUERY->add_arg(QUERY, "int", "id");
+
   // example of adding setter method
   QUERY->add_mfun(QUERY, ladspa_set, "float", "set");
   // example of adding argument to the above method
@@ -573,6 +1372,16 @@ CK_DLL_QUERY( Ladspa )
   // example of adding setter method
   QUERY->add_mfun(QUERY, ladspa_verbose, "int", "verbose");
   QUERY->add_arg(QUERY, "int", "val");
+
+  // drive a control param from a LADSPAControl (null to release)
+  QUERY->add_mfun(QUERY, ladspa_control, "int", "control");
+  QUERY->add_arg(QUERY, "int", "param");
+  QUERY->add_arg(QUERY, "LADSPAControl", "source");
+
+  // one-pole smoothing (0-1) of a control param driven by a LADSPAControl
+  QUERY->add_mfun(QUERY, ladspa_smooth, "float", "smooth");
+  QUERY->add_arg(QUERY, "int", "param");
+  QUERY->add_arg(QUERY, "float", "pole");
   
   // this reserves a variable in the ChucK internal class to store 
   // referene to the c++ class we defined above
@@ -581,6 +1390,52 @@ CK_DLL_QUERY( Ladspa )
   // end the class definition
   // IMPORTANT: this MUST be called!
   QUERY->end_class(QUERY);
+
+  // LADSPAChain: an ordered chain of plugins run as one block
+  QUERY->begin_class(QUERY, "LADSPAChain", "UGen");
+  QUERY->add_ctor(QUERY, ladspachain_ctor);
+  QUERY->add_dtor(QUERY, ladspachain_dtor);
+  QUERY->add_ugen_funcf(QUERY, ladspachain_tick, NULL, 2, 2);
+
+  // append plugin <label> from <filename>; returns its chain position
+  QUERY->add_mfun(QUERY, ladspachain_add, "int", "add");
+  QUERY->add_arg(QUERY, "string", "filename");
+  QUERY->add_arg(QUERY, "string", "label");
+
+  // append a plugin found on LADSPA_PATH by label or unique ID
+  QUERY->add_mfun(QUERY, ladspachain_addLabel, "int", "add");
+  QUERY->add_arg(QUERY, "string", "label");
+
+  QUERY->add_mfun(QUERY, ladspachain_addID, "int", "add");
+  QUERY->add_arg(QUERY, "int", "id");
+
+  QUERY->add_mfun(QUERY, ladspachain_clear, "void", "clear");
+
+  QUERY->add_mfun(QUERY, ladspachain_size, "int", "size");
+
+  QUERY->add_mfun(QUERY, ladspachain_set, "float", "set");
+  QUERY->add_arg(QUERY, "int", "plugin");
+  QUERY->add_arg(QUERY, "int", "param");
+  QUERY->add_arg(QUERY, "float", "val");
+
+  QUERY->add_mfun(QUERY, ladspachain_get, "float", "get");
+  QUERY->add_arg(QUERY, "int", "plugin");
+  QUERY->add_arg(QUERY, "int", "param");
+
+  // mix a plugin on top of its input (dry + gain * wet); negative
+  // gain (the default) replaces the signal instead
+  QUERY->add_mfun(QUERY, ladspachain_setWet, "float", "wet");
+  QUERY->add_arg(QUERY, "int", "plugin");
+  QUERY->add_arg(QUERY, "float", "gain");
+
+  QUERY->add_mfun(QUERY, ladspachain_getWet, "float", "wet");
+  QUERY->add_arg(QUERY, "int", "plugin");
+
+  QUERY->add_mfun(QUERY, ladspachain_verbose, "int", "verbose");
+  QUERY->add_arg(QUERY, "int", "val");
+
+  ladspachain_data_offset = QUERY->add_mvar(QUERY, "int", "@lc_data", false);
+  QUERY->end_class(QUERY);
   
   // wasn't that a breeze?
   return TRUE;
@@ -594,7 +1449,7 @@ CK_DLL_CTOR(ladspa_ctor)
   OBJ_MEMBER_INT(SELF, ladspa_data_offset) = 0;
   
   // instantiate our internal c++ class representation
-  Ladspa * bcdata = new Ladspa(API->vm->srate(VM));
+  Ladspa * bcdata = new Ladspa(API->vm->srate(VM), API);
   
   // store the pointer in the ChucK object member
   OBJ_MEMBER_INT(SELF, ladspa_data_offset) = (t_CKINT) bcdata;
@@ -652,6 +1507,12 @@ CK_DLL_MFUN(ladspa_label)
   RETURN->v_int = bcdata->LadspaActivate(name.c_str());
 }
 
+CK_DLL_MFUN(ladspa_labelID)
+{
+  Ladspa * bcdata = (Ladspa *) OBJ_MEMBER_INT(SELF, ladspa_data_offset);
+  RETURN->v_int = bcdata->LadspaActivate((unsigned long)GET_NEXT_INT(ARGS));
+}
+
 // example implementation for setter
 CK_DLL_MFUN(ladspa_info)
 {
@@ -703,6 +1564,141 @@ CK_DLL_MFUN(ladspa_verbose)
 }
 
 
+CK_DLL_MFUN(ladspa_control)
+{
+  Ladspa * bcdata = (Ladspa *) OBJ_MEMBER_INT(SELF, ladspa_data_offset);
+  t_CKINT param = GET_NEXT_INT(ARGS);
+  Chuck_Object * source = GET_NEXT_OBJECT(ARGS);
+  LadspaControlSource * input = source ?
+    (LadspaControlSource *) OBJ_MEMBER_INT(source, ladspacontrol_data_offset) : NULL;
+  RETURN->v_int = bcdata->control(param, source, input);
+}
+
+CK_DLL_MFUN(ladspa_smooth)
+{
+  Ladspa * bcdata = (Ladspa *) OBJ_MEMBER_INT(SELF, ladspa_data_offset);
+  t_CKINT param = GET_NEXT_INT(ARGS);
+  t_CKFLOAT pole = GET_NEXT_FLOAT(ARGS);
+  RETURN->v_float = bcdata->smooth(param, pole);
+}
+
+CK_DLL_CTOR(ladspacontrol_ctor)
+{
+  LadspaControlSource * source = new LadspaControlSource;
+  source->value = 0;
+  OBJ_MEMBER_INT(SELF, ladspacontrol_data_offset) = (t_CKINT) source;
+}
+
+CK_DLL_DTOR(ladspacontrol_dtor)
+{
+  LadspaControlSource * source = (LadspaControlSource *) OBJ_MEMBER_INT(SELF, ladspacontrol_data_offset);
+  delete source;
+  OBJ_MEMBER_INT(SELF, ladspacontrol_data_offset) = 0;
+}
+
+CK_DLL_TICK(ladspacontrol_tick)
+{
+  LadspaControlSource * source = (LadspaControlSource *) OBJ_MEMBER_INT(SELF, ladspacontrol_data_offset);
+  source->value = (LADSPA_Data)in;
+  *out = in;
+  return TRUE;
+}
+
+CK_DLL_CTOR(ladspachain_ctor)
+{
+  OBJ_MEMBER_INT(SELF, ladspachain_data_offset) = 0;
+  LadspaChain * chain = new LadspaChain(API->vm->srate(VM));
+  OBJ_MEMBER_INT(SELF, ladspachain_data_offset) = (t_CKINT) chain;
+}
+
+CK_DLL_DTOR(ladspachain_dtor)
+{
+  LadspaChain * chain = (LadspaChain *) OBJ_MEMBER_INT(SELF, ladspachain_data_offset);
+  if( chain )
+    {
+      delete chain;
+      OBJ_MEMBER_INT(SELF, ladspachain_data_offset) = 0;
+    }
+}
+
+CK_DLL_TICKF(ladspachain_tick)
+{
+  LadspaChain * chain = (LadspaChain *) OBJ_MEMBER_INT(SELF, ladspachain_data_offset);
+  if(chain) chain->tick(in, out, nframes);
+  return TRUE;
+}
+
+CK_DLL_MFUN(ladspachain_add)
+{
+  LadspaChain * chain = (LadspaChain *) OBJ_MEMBER_INT(SELF, ladspachain_data_offset);
+  std::string filename = GET_NEXT_STRING_SAFE(ARGS);
+  std::string label = GET_NEXT_STRING_SAFE(ARGS);
+  RETURN->v_int = chain->add(filename.c_str(), label.c_str());
+}
+
+CK_DLL_MFUN(ladspachain_addLabel)
+{
+  LadspaChain * chain = (LadspaChain *) OBJ_MEMBER_INT(SELF, ladspachain_data_offset);
+  std::string label = GET_NEXT_STRING_SAFE(ARGS);
+  RETURN->v_int = chain->add(label.c_str());
+}
+
+CK_DLL_MFUN(ladspachain_addID)
+{
+  LadspaChain * chain = (LadspaChain *) OBJ_MEMBER_INT(SELF, ladspachain_data_offset);
+  RETURN->v_int = chain->add((unsigned long)GET_NEXT_INT(ARGS));
+}
+
+CK_DLL_MFUN(ladspachain_clear)
+{
+  LadspaChain * chain = (LadspaChain *) OBJ_MEMBER_INT(SELF, ladspachain_data_offset);
+  chain->clear();
+}
+
+CK_DLL_MFUN(ladspachain_size)
+{
+  LadspaChain * chain = (LadspaChain *) OBJ_MEMBER_INT(SELF, ladspachain_data_offset);
+  RETURN->v_int = chain->size();
+}
+
+CK_DLL_MFUN(ladspachain_set)
+{
+  LadspaChain * chain = (LadspaChain *) OBJ_MEMBER_INT(SELF, ladspachain_data_offset);
+  t_CKINT plugin = GET_NEXT_INT(ARGS);
+  t_CKINT param = GET_NEXT_INT(ARGS);
+  t_CKFLOAT val = GET_NEXT_FLOAT(ARGS);
+  RETURN->v_float = chain->set(plugin, param, val);
+}
+
+CK_DLL_MFUN(ladspachain_get)
+{
+  LadspaChain * chain = (LadspaChain *) OBJ_MEMBER_INT(SELF, ladspachain_data_offset);
+  t_CKINT plugin = GET_NEXT_INT(ARGS);
+  t_CKINT param = GET_NEXT_INT(ARGS);
+  RETURN->v_float = chain->get(plugin, param);
+}
+
+CK_DLL_MFUN(ladspachain_setWet)
+{
+  LadspaChain * chain = (LadspaChain *) OBJ_MEMBER_INT(SELF, ladspachain_data_offset);
+  t_CKINT plugin = GET_NEXT_INT(ARGS);
+  t_CKFLOAT gain = GET_NEXT_FLOAT(ARGS);
+  RETURN->v_float = chain->wet(plugin, gain);
+}
+
+CK_DLL_MFUN(ladspachain_getWet)
+{
+  LadspaChain * chain = (LadspaChain *) OBJ_MEMBER_INT(SELF, ladspachain_data_offset);
+  RETURN->v_float = chain->wet(GET_NEXT_INT(ARGS));
+}
+
+CK_DLL_MFUN(ladspachain_verbose)
+{
+  LadspaChain * chain = (LadspaChain *) OBJ_MEMBER_INT(SELF, ladspachain_data_offset);
+  RETURN->v_int = chain->setVerbose(GET_NEXT_INT(ARGS));
+}
+
+
 // windows
 #if defined(__PLATFORM_WINDOWS__)
 extern "C"
@@ -11,11 +11,19 @@
 // load (string): path to LADSPA file
 // list (): list the available plugins in the LADSPA file
 // info (): list the input and output ports for plugins
-// activate (string): activate plugin based on label name
+// activate (string): activate plugin based on label name. If no
+//                    file is loaded (or the label is not in it),
+//                    the label is looked up on LADSPA_PATH
+// activate (int): activate a plugin on LADSPA_PATH by unique ID
 // set (int, float): set the nth parameter to a new value
 // get (int): get the nth parameter. This could be either a control
 //            input or output
 // verbose (int): turn on/off notifications about plugin (default: 1)
+// control (int, LADSPAControl): drive control param n from the signal
+//                      going through a LADSPAControl, so it can be
+//                      modulated at audio rate (null releases the
+//                      param back to set())
+// smooth (int, float): one-pole smoothing (0 to 1) of a driven param
 
 "/usr/local/lib/ladspa/filter.so" => string plugname;
 "lpf" => string labelname;
@@ -49,7 +57,31 @@ labelname => plugin.activate;
 plugin.info();
 second => now;
 
-// set parameter 0 to a value of 100. The console should show
-// the name of the parameter that is being changed.
+// Plugins installed on LADSPA_PATH (default: ~/.ladspa,
+// /usr/local/lib/ladspa, /usr/lib/ladspa) can be activated by label
+// or unique ID without loading their file first. The plugin index is
+// cached in ~/.chuck-ladspa-index (or $LADSPA_INDEX) and a library is
+// only rescanned when it changes.
+// LADSPA other => blackhole;
+// "lpf" => other.activate;
+
+// set parameter 0 to a value of 100.
 plugin.set(0,100);
 second => now;
+
+// A control signal goes through a LADSPAControl, which has to be
+// ticked (here by blackhole), and is bound to a control port. The
+// plugin's own inputs stay audio only.
+SinOsc lfo => LADSPAControl sweep => blackhole;
+0.5 => lfo.freq;
+400 => lfo.gain;
+Step offset => sweep;
+1000 => offset.next;
+// parameter 0 now follows the sweep
+plugin.control(0, sweep);
+plugin.smooth(0, 0.99);
+5::second => now;
+// and is back under set()
+plugin.control(0, null);
+plugin.set(0, 100);
+second => now;
@@ -0,0 +1,42 @@
+////////////////////////////////////////////////////////////////
+// LADSPAChain: several LADSPA plugins in one UGen            //
+//                                                            //
+// The plugins of a chain share their audio buffers and are   //
+// run back to back on each block, instead of paying for one  //
+// LADSPA UGen (and its buffer copies) per plugin.            //
+////////////////////////////////////////////////////////////////
+
+// Options
+// add (string, string): append plugin <label> from LADSPA file
+//                       <filename>; returns its position in the
+//                       chain (or -1 on failure)
+// add (string): append plugin <label> found on LADSPA_PATH
+// add (int): append the plugin with this unique ID on LADSPA_PATH
+// set (int, int, float): set param of the plugin at a position
+// get (int, int): get param of the plugin at a position
+// wet (int, float): mix the plugin on top of its input signal
+//                   (dry + gain * plugin), using run_adding when
+//                   the plugin supports it. A negative gain (the
+//                   default) replaces the signal.
+// size (): number of plugins in the chain
+// clear (): remove all plugins
+// verbose (int): turn on/off notifications (default: 1)
+
+"/usr/local/lib/ladspa/filter.so" => string filters;
+"/usr/local/lib/ladspa/delay.so" => string delays;
+
+Noise n => LADSPAChain chain => dac;
+0.5 => n.gain;
+
+chain.add(filters, "lpf") => int lpf;
+chain.add(delays, "delay_5s") => int delay;
+
+// cutoff of the low-pass filter
+chain.set(lpf, 0, 800);
+// delay time and dry/wet of the delay
+chain.set(delay, 0, 0.25);
+chain.set(delay, 1, 1);
+// add the echoes on top of the filtered noise at half gain
+chain.wet(delay, 0.5);
+
+second => now;
@@ -10,24 +10,28 @@ Katja Vetter, Feb 2012.
 
 
 #include <stdlib.h>
+#include <string.h>
 #include <math.h>
 #include "Helmholtz_dsp.h"
 
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+	#include <xmmintrin.h>
+	#define HELMHOLTZ_SSE
+#endif
+
 
 Helmholtz::Helmholtz(int framearg, int overlaparg, t_float biasarg)
 {
     inputbuf = NULL;
     inputbuf2 = NULL;
     processbuf = NULL;
+    normbuf = NULL;
+    fftwork = NULL;
     
     setframesize(framearg);
     setoverlap(overlaparg);
     if(biasarg)setbias(biasarg);
     else biasfactor = DEFBIAS;
-    
-    inputbuf = (t_float*)calloc(framesize, sizeof(t_float));
-    inputbuf2 = (t_float*)calloc(framesize, sizeof(t_float));
-    processbuf = (t_float*)calloc(framesize * 2, sizeof(t_float));
         
     timeindex = 0;
     periodindex = 0;
@@ -39,12 +43,16 @@ Helmholtz::Helmholtz(int framearg, int overlaparg, t_float biasarg)
 
 Helmholtz::~Helmholtz()
 {
-    delete inputbuf;
+    free(inputbuf);
     inputbuf = NULL;
-    delete inputbuf2;
+    free(inputbuf2);
     inputbuf2 = NULL;
-    delete processbuf;
+    free(processbuf);
     processbuf = NULL;
+    free(normbuf);
+    normbuf = NULL;
+    free(fftwork);
+    fftwork = NULL;
 }
   
 /*********************************************************************************/
@@ -75,9 +83,18 @@ void Helmholtz::setframesize(int frame)
   frame = DEFFRAMESIZE;
   framesize = frame;
     
-    if(inputbuf) inputbuf = (t_float*)realloc(inputbuf, framesize * sizeof(t_float));
-    if(inputbuf2) inputbuf2 = (t_float*)realloc(inputbuf2, framesize * sizeof(t_float));
-    if(processbuf) processbuf = (t_float*)realloc(processbuf, framesize * 2 * sizeof(t_float));
+    fft = SimdFFT::plan(framesize * 2);
+    
+    free(inputbuf);
+    free(inputbuf2);
+    free(processbuf);
+    free(normbuf);
+    free(fftwork);
+    inputbuf = (t_float*)calloc(framesize, sizeof(t_float));
+    inputbuf2 = (t_float*)calloc(framesize, sizeof(t_float));
+    processbuf = (t_float*)calloc(framesize * 2, sizeof(t_float));
+    normbuf = (t_float*)calloc(framesize, sizeof(t_float));
+    fftwork = (t_float*)calloc(fft->worksize(), sizeof(t_float));
     
     timeindex = 0;
 }
@@ -127,18 +144,16 @@ t_float Helmholtz::getfidelity() const
 // main analysis function
 void Helmholtz::analyzeframe()
 {
-    int n, tindex = timeindex;
-    int mask = framesize - 1;
-    t_float norm = 1. / sqrt(t_float(framesize * 2));
+    int head = framesize - timeindex;
     
-    // copy input to processing buffer
-    for(n=0; n<framesize; n++) processbuf[n] = inputbuf[tindex++ & mask] * norm;
+    // unroll the input ring, oldest sample first, for the normalization
+    // function
+    memcpy(inputbuf2, inputbuf + timeindex, head * sizeof(t_float));
+    memcpy(inputbuf2 + head, inputbuf, timeindex * sizeof(t_float));
     
-    // copy for normalization function
-    for(n=0; n<framesize; n++) inputbuf2[n] = inputbuf[tindex++ & mask];
-    
-    // zeropadding
-    for(n=framesize; n<(framesize<<1); n++) processbuf[n] = 0.;
+    // copy to processing buffer, with zeropadding
+    memcpy(processbuf, inputbuf2, framesize * sizeof(t_float));
+    memset(processbuf + framesize, 0, framesize * sizeof(t_float));
     
     // call analysis procedures
     autocorrelation();
@@ -150,24 +165,44 @@ void Helmholtz::analyzeframe()
 
 void Helmholtz::autocorrelation()
 {
-    int n;
+    int n = 1;
     int fftsize = framesize * 2;
     
-    REALFFT(fftsize, processbuf);
+    // the spectrum comes normalized by 1 / fftsize and the inverse is not,
+    // so scaling the power by fftsize leaves the raw autocorrelation
+    t_float scale = (t_float)fftsize;
+    
+    fft->r2c(processbuf, processbuf, fftwork);
     
-    // compute power spectrum
-    processbuf[0] *= processbuf[0]; // DC
-    processbuf[framesize] *= processbuf[framesize]; // Nyquist
+    // compute power spectrum; the layout is
+    // re(0), re(nyquist), re(1), im(1), re(2), im(2) ...
+    processbuf[0] *= processbuf[0] * scale; // DC
+    processbuf[1] *= processbuf[1] * scale; // Nyquist
     
-    for(n=1; n<framesize; n++)                                  
+#ifdef HELMHOLTZ_SSE
+    const __m128 vscale = _mm_set1_ps(scale);
+    const __m128 zero = _mm_setzero_ps();
+    for(; n+4<=framesize; n+=4)
     {
-        processbuf[n] = processbuf[n] * processbuf[n]
-           + processbuf[fftsize-n] * processbuf[fftsize-n]; // imag coefficients appear reversed
-        processbuf[fftsize-n] = 0.;
-        
+        t_float *bin = processbuf + 2 * n;
+        __m128 a = _mm_loadu_ps(bin), b = _mm_loadu_ps(bin + 4);
+        a = _mm_mul_ps(a, a);
+        b = _mm_mul_ps(b, b);
+        __m128 power = _mm_mul_ps(_mm_add_ps(
+            _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)),
+            _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1))), vscale);
+        _mm_storeu_ps(bin, _mm_unpacklo_ps(power, zero));
+        _mm_storeu_ps(bin + 4, _mm_unpackhi_ps(power, zero));
+    }
+#endif
+    for(; n<framesize; n++)
+    {
+        t_float re = processbuf[2*n], im = processbuf[2*n+1];
+        processbuf[2*n] = (re * re + im * im) * scale;
+        processbuf[2*n+1] = 0.;
     }
     
-    REALIFFT(fftsize, processbuf);
+    fft->c2r(processbuf, processbuf, fftwork);
 }
 
 
@@ -185,15 +220,23 @@ void Helmholtz::normalize()
     if(rzero < minrzero) rzero = minrzero;
     double normintegral = rzero * 2.;
     
-    // normalize biased autocorrelation function
+    // normalize biased autocorrelation function; the running integral is
+    // serial, so gather its values first and divide in a separate pass
     processbuf[0] = 1.;
     for(n=1; n<seek; n++)
     {
        signal1 = inputbuf2[n-1];
        signal2 = inputbuf2[framesize-n];
        normintegral -= (double)(signal1 * signal1 + signal2 * signal2);
-       processbuf[n] /= (t_float)normintegral * 0.5;
+       normbuf[n] = (t_float)normintegral * 0.5;
     }
+    n = 1;
+#ifdef HELMHOLTZ_SSE
+    for(; n+4<=seek; n+=4)
+        _mm_storeu_ps(processbuf + n, _mm_div_ps(_mm_loadu_ps(processbuf + n),
+                                                 _mm_loadu_ps(normbuf + n)));
+#endif
+    for(; n<seek; n++) processbuf[n] /= normbuf[n];
     
     // flush instable function tail
     for(n = seek; n<framesize; n++) processbuf[n] = 0.;
@@ -29,9 +29,9 @@ Function getfidelity() returns a value between 0. and 1. indicating
 to which extent the input signal is periodic. A fidelity of ~0.95 can
 be considered to indicate a periodic signal.
 
-Class Helmholtz needs mayer_realfft() and mayer_realifft() or similar
-fft functions. Note that Ron Mayer's functions for real fft have a
-peculiar organisation of imaginary coefficients (reversed order, sign flipped).
+Class Helmholtz computes the autocorrelation with SimdFFT, a real fft
+vectorized with SSE where available. The fft plan and all buffers are
+made by setframesize(), so analysis itself never allocates.
 
 Class Helmholtz uses t_float for float or double. Depending on the context
 where the class is used, you may need to define t_float. If used with
@@ -46,25 +46,15 @@ Katja Vetter, Feb 2012.
 ***********************************************************************/
 
 /* This section includes the Pure Data API header. If you build Helmholtz
-against another DSP framework, you need to define t_float, and you need to
-include Ron Mayer's fft or similar functionality. */
+against another DSP framework, you need to define t_float. SimdFFT works
+on float, so t_float must be float. */
 
-//#include "fft_mayer.c"
+#include "SimdFFT.h"
 #define t_float float
-#define REALFFT mayer_realfft
-#define REALIFFT mayer_realifft
-
-extern "C"
-{
-  void REALFFT (int, float*);
-  void REALIFFT (int, float*);
-}  
 
 #ifdef PD
 #include "m_pd.h"
 #define t_float float
-#define REALFFT mayer_realfft
-#define REALIFFT mayer_realifft
 #endif
 
 /***********************************************************************/
@@ -106,6 +96,9 @@ private:
     t_float *inputbuf;
     t_float *inputbuf2;
     t_float *processbuf;
+    t_float *normbuf;           // normalization denominators
+    t_float *fftwork;
+    std::shared_ptr<const SimdFFT> fft;
     
     // state variables
     int timeindex;
@@ -10,6 +10,12 @@
 // general includes
 #include <stdio.h>
 #include <limits.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
 
 #define DEF_FIDELITY 0.95
 #define DEF_SENSITIVITY 0.003
@@ -34,13 +40,48 @@ CK_DLL_MFUN(pitchtrack_setFrame);
 CK_DLL_MFUN(pitchtrack_getFrame);
 CK_DLL_MFUN(pitchtrack_setBias);
 CK_DLL_MFUN(pitchtrack_getBias);
+CK_DLL_MFUN(pitchtrack_setThreaded);
+CK_DLL_MFUN(pitchtrack_getThreaded);
+CK_DLL_MFUN(pitchtrack_getEvent);
+CK_DLL_MFUN(pitchtrack_getChanFreq);
+CK_DLL_MFUN(pitchtrack_getPitches);
+CK_DLL_MFUN(pitchtrack_getChannels);
 
 // for Chugins extending UGen, this is mono synthesis function for 1 sample
 CK_DLL_TICK(pitchtrack_tick);
 
+// PitchTrack2, 4, 8 and 16: multichannel PitchTracks
+CK_DLL_CTOR(pitchtrack2_ctor);
+CK_DLL_CTOR(pitchtrack4_ctor);
+CK_DLL_CTOR(pitchtrack8_ctor);
+CK_DLL_CTOR(pitchtrack16_ctor);
+CK_DLL_TICKF(pitchtrack_tickf);
+
 // this is a special offset reserved for Chugin internal data
 t_CKINT pitchtrack_data_offset = 0;
 
+// worker thread job states
+static const int kJobIdle = 0;
+static const int kJobQueued = 1;
+
+// Channels are analyzed in groups of up to this many, sharing a frame
+// boundary so their transforms run back to back.
+static const int kBatch = 4;
+// PitchTrack16 is the widest
+static const int kMaxChannels = 16;
+static const int kMaxGroups = kMaxChannels / kBatch;
+
+// One tracked channel: its own Helmholtz state, input ring and result.
+struct PitchTrackChannel
+{
+  Helmholtz *helmholtz;
+  float *buffer;                // input ring, written at PitchTrack::_index
+  float *work_buffer;           // frame being analyzed
+  t_float period;               // last analysis
+  t_float periodFidelity;
+  t_CKFLOAT freq;               // last accepted frequency
+};
+
 // class definition for internal Chugin data
 // (note: this isn't strictly necessary, but serves as example
 // of one recommended approach)
@@ -48,63 +89,139 @@ t_CKINT pitchtrack_data_offset = 0;
 class PitchTrack
 {
 public:
-  PitchTrack( t_CKFLOAT fs)
+  PitchTrack( t_CKFLOAT fs, Chuck_VM *vm, CK_DL_API api)
   {
+    _vm = vm;
+    _api = api;
+    _event = NULL;
+    _eventBuffer = NULL;
     _SR = fs;
-    _freq = 0;
     _fidelity = DEF_FIDELITY;
     _sensitivity = DEF_SENSITIVITY;
     _overlap = DEF_OVERLAP;
     _bias = DEF_BIAS;
     _frame = DEF_FRAME;
     
-    _buffer = new float[_frame];
-    _null_buffer = new float[_frame];
-    _index = 0;
-    
-    for (int i = 0; i < _frame; i++)
-      {
-	_buffer[i] = 0.0;
-	_null_buffer[i] = 0.0;
-      }
-    
-    _helmholtz = new Helmholtz();
-    _helmholtz->setbias(DEF_BIAS);
-    _helmholtz->setoverlap(DEF_OVERLAP);
-    _helmholtz->setminRMS(DEF_SENSITIVITY);
+    _nchans = 0;
+    _channels = NULL;
+    _null_buffer = NULL;
+    allocChannels(1);
+
+    _threaded = false;
+    _workerQuit = false;
+    for (int g = 0; g < kMaxGroups; g++)
+      _jobState[g].store(kJobIdle);
   }
 
   ~PitchTrack ()
   {
-    free(_buffer);
-    free(_null_buffer);
-    delete _helmholtz;
+    setThreaded(false);
+    if (_event)
+      _api->object->release((Chuck_Object *)_event);
+    freeChannels();
   }
 
   // for Chugins extending UGen
   SAMPLE tick( SAMPLE in )
   {
-    _buffer[_index] = in;
-    _index = (_index + 1) % _frame;
-    if (_index == 0)
+    SAMPLE out;
+    tick(&in, &out, 1);
+    return out;
+  }
+
+  // <nframes> frames of one sample per channel, interleaved
+  void tick( SAMPLE *in, SAMPLE *out, int nframes )
+  {
+    for (int f = 0; f < nframes; f++)
       {
-	_helmholtz->iosamples(_buffer, _null_buffer, _frame);
-	
-	float testfreq = _SR / (float)_helmholtz->getperiod();
-	float testfidelity = (float) _helmholtz->getfidelity();
-	if (testfidelity >= _fidelity)
+	for (int c = 0; c < _nchans; c++)
 	  {
-	    _freq = testfreq;
+	    _channels[c].buffer[_index] = in[c];
+	    out[c] = in[c];
 	  }
+	in += _nchans;
+	out += _nchans;
+	_index = (_index + 1) % _frame;
+	// group g's frames end at g/ngroups of the way through the ring
+	if (_index % _stride == 0)
+	  frameDone(_index / _stride);
       }
-    return in;
   }
   
   float getFreq()
   {
-	return _freq;
+	return _channels[0].freq;
+  }
+
+  float getFreq( t_CKINT chan )
+  {
+    if (chan < 0 || chan >= _nchans)
+      return 0;
+    return _channels[chan].freq;
+  }
+
+  // Fill <freqs> with every channel's frequency; returns the channel count.
+  t_CKINT getPitches( Chuck_ArrayFloat *freqs )
+  {
+    if (freqs)
+      {
+	_api->object->array_float_clear(freqs);
+	for (int c = 0; c < _nchans; c++)
+	  _api->object->array_float_push_back(freqs, _channels[c].freq);
+      }
+    return _nchans;
   }
 
+  int getChannels() { return _nchans; }
+
+  // Track <n> channels with the same settings; each starts over.
+  void setChannels( int n )
+  {
+    sync();
+    allocChannels(n);
+  }
+
+  // The Event broadcast whenever the pitch changes, made on first use.
+  Chuck_Event *getEvent()
+  {
+    if (!_event)
+      {
+	_event = (Chuck_Event *)_api->object->create_without_shred(_vm,
+	  _api->type->lookup(_vm, "Event"), TRUE);
+	_eventBuffer = _api->vm->create_event_buffer(_vm);
+      }
+    return _event;
+  }
+
+  int setThreaded (t_CKINT i)
+  {
+    bool on = i != 0;
+#ifdef __EMSCRIPTEN__
+    on = false;
+#endif
+    if (on == _threaded)
+      return _threaded;
+    if (on)
+      {
+	_workerQuit = false;
+	_worker = std::thread(&PitchTrack::workerLoop, this);
+      }
+    else
+      {
+	sync();
+	{
+	  std::lock_guard<std::mutex> lock(_workerMutex);
+	  _workerQuit = true;
+	}
+	_workerWake.notify_one();
+	_worker.join();
+      }
+    _threaded = on;
+    return _threaded;
+  }
+
+  int getThreaded () { return _threaded; }
+
   float setFidelity (t_CKFLOAT f)
   {
     _fidelity = f;
@@ -116,7 +233,9 @@ public:
   float setSensitivity (t_CKFLOAT f)
   {
 	_sensitivity = f;
-	_helmholtz->setminRMS(_sensitivity);
+	sync();
+	for (int c = 0; c < _nchans; c++)
+	  _channels[c].helmholtz->setminRMS(_sensitivity);
 	return f;
   }
 
@@ -125,7 +244,9 @@ public:
   int setOverlap (t_CKINT i)
   {
 	_overlap = i;
-	_helmholtz->setoverlap(i);
+	sync();
+	for (int c = 0; c < _nchans; c++)
+	  _channels[c].helmholtz->setoverlap(i);
 	return i;
   }
 
@@ -135,18 +256,9 @@ public:
   {
     int pow2 = 128;
     while (pow2 < i) pow2 *= 2;
+    sync();
     _frame = pow2;
-    delete _buffer;
-    delete _null_buffer;
-    _buffer = new float[_frame];
-    _null_buffer = new float[_frame];
-    _index = 0;
-    
-    for (int i = 0; i < _frame; i++)
-      {
-	_buffer[i] = 0.0;
-	_null_buffer[i] = 0.0;
-      }    
+    allocBuffers();
     return _frame;
   }
 
@@ -155,25 +267,205 @@ public:
   float setBias (t_CKFLOAT f)
   {
 	_bias = f;
-	_helmholtz->setbias(f);
+	sync();
+	for (int c = 0; c < _nchans; c++)
+	  _channels[c].helmholtz->setbias(f);
 	return f;
   }
 
   float getBias () { return _bias; }
 
 private:
+  // Make <n> channels with the current settings; only called with the
+  // worker idle.
+  void allocChannels( int n )
+  {
+    freeChannels();
+    _nchans = n;
+    _ngroups = (n + kBatch - 1) / kBatch;
+    _channels = new PitchTrackChannel[n];
+    for (int c = 0; c < n; c++)
+      {
+	PitchTrackChannel &ch = _channels[c];
+	ch.helmholtz = new Helmholtz();
+	ch.helmholtz->setbias(_bias);
+	ch.helmholtz->setoverlap((int)_overlap);
+	ch.helmholtz->setminRMS(_sensitivity);
+	ch.buffer = NULL;
+	ch.work_buffer = NULL;
+	ch.period = 0;
+	ch.periodFidelity = 0;
+	ch.freq = 0;
+      }
+    allocBuffers();
+  }
+
+  void freeChannels()
+  {
+    for (int c = 0; c < _nchans; c++)
+      {
+	delete _channels[c].helmholtz;
+	delete[] _channels[c].buffer;
+	delete[] _channels[c].work_buffer;
+      }
+    delete[] _channels;
+    delete[] _null_buffer;
+    _channels = NULL;
+    _null_buffer = NULL;
+    _nchans = 0;
+  }
+
+  // (Re)allocate the frame buffers, zeroed; only called with the worker idle.
+  void allocBuffers()
+  {
+    for (int c = 0; c < _nchans; c++)
+      {
+	PitchTrackChannel &ch = _channels[c];
+	delete[] ch.buffer;
+	delete[] ch.work_buffer;
+	ch.buffer = new float[_frame]();
+	ch.work_buffer = new float[_frame]();
+      }
+    delete[] _null_buffer;
+    _null_buffer = new float[_frame]();
+    _index = 0;
+    _stride = _frame / _ngroups;
+  }
+
+  // The frames of group <g> just filled.
+  void frameDone( int g )
+  {
+    if (!_threaded)
+      {
+	unrollFrames(g);
+	analyze(g);
+	update(g);
+      }
+    // take this group's last result and queue its new frames for the
+    // worker; they are only dropped if the worker hasn't got through this
+    // group's previous frames yet
+    else if (_jobState[g].load(std::memory_order_acquire) == kJobIdle)
+      {
+	update(g);
+	unrollFrames(g);
+	{
+	  std::lock_guard<std::mutex> lock(_workerMutex);
+	  _jobState[g].store(kJobQueued, std::memory_order_release);
+	}
+	_workerWake.notify_one();
+      }
+  }
+
+  int groupEnd( int g ) { return std::min(_nchans, (g + 1) * kBatch); }
+
+  // Copy group <g>'s rings, oldest sample first, to their work buffers.
+  void unrollFrames( int g )
+  {
+    int head = _frame - _index;
+    for (int c = g * kBatch; c < groupEnd(g); c++)
+      {
+	PitchTrackChannel &ch = _channels[c];
+	memcpy(ch.work_buffer, ch.buffer + _index, head * sizeof(float));
+	memcpy(ch.work_buffer + head, ch.buffer, _index * sizeof(float));
+      }
+  }
+
+  // Analyze group <g>'s work buffers.  Runs on the worker thread when
+  // threaded, else in the tick; the periods and fidelities it leaves are
+  // published together by the store that ends the job.
+  void analyze( int g )
+  {
+    for (int c = g * kBatch; c < groupEnd(g); c++)
+      {
+	PitchTrackChannel &ch = _channels[c];
+	ch.helmholtz->iosamples(ch.work_buffer, _null_buffer, _frame);
+	ch.period = ch.helmholtz->getperiod();
+	ch.periodFidelity = ch.helmholtz->getfidelity();
+      }
+  }
+
+  // Take group <g>'s last analysis, and let waiting shreds know if a
+  // pitch changed.
+  void update( int g )
+  {
+    bool changed = false;
+    for (int c = g * kBatch; c < groupEnd(g); c++)
+      {
+	PitchTrackChannel &ch = _channels[c];
+	float testfreq = _SR / (float)ch.period;
+	float testfidelity = (float) ch.periodFidelity;
+	if (testfidelity >= _fidelity && testfreq != ch.freq)
+	  {
+	    ch.freq = testfreq;
+	    changed = true;
+	  }
+      }
+    if (changed && _event)
+      _api->vm->queue_event(_vm, _event, 1, _eventBuffer);
+  }
+
+  // Wait for the worker to finish the frames it has, if any.
+  void sync()
+  {
+    for (int g = 0; g < kMaxGroups; g++)
+      while (_jobState[g].load(std::memory_order_acquire) == kJobQueued)
+	std::this_thread::yield();
+  }
+
+  bool anyQueued()
+  {
+    for (int g = 0; g < kMaxGroups; g++)
+      if (_jobState[g].load(std::memory_order_acquire) == kJobQueued)
+	return true;
+    return false;
+  }
+
+  // The group boundaries of a whole audio buffer come in a burst, so
+  // several groups can be queued at once; each pass analyzes all of them.
+  void workerLoop()
+  {
+    std::unique_lock<std::mutex> lock(_workerMutex);
+    for (;;)
+      {
+	_workerWake.wait(lock, [this] { return _workerQuit || anyQueued(); });
+	if (_workerQuit)
+	  break;
+	lock.unlock();
+	for (int g = 0; g < kMaxGroups; g++)
+	  if (_jobState[g].load(std::memory_order_acquire) == kJobQueued)
+	    {
+	      analyze(g);
+	      _jobState[g].store(kJobIdle, std::memory_order_release);
+	    }
+	lock.lock();
+      }
+  }
+
   // instance data
-  t_CKFLOAT _freq;
+  Chuck_VM *_vm;
+  CK_DL_API _api;
+  Chuck_Event *_event;          // broadcast when a pitch changes, or NULL
+  CBufferSimple *_eventBuffer;
   t_CKFLOAT _fidelity;
   t_CKFLOAT _sensitivity;
   t_CKFLOAT _overlap;
   t_CKFLOAT _bias;
-  float *_buffer;
+  PitchTrackChannel *_channels; // [_nchans]
+  int _nchans;
+  int _ngroups;                 // channel groups, kBatch channels each
+  int _stride;                  // samples between group boundaries
   float *_null_buffer;
-  t_CKINT _index;
+  t_CKINT _index;               // ring write position, shared by channels
   t_CKINT _frame;
-  Helmholtz *_helmholtz;
   t_CKFLOAT _SR;
+
+  // worker thread
+  bool _threaded;
+  std::atomic<int> _jobState[kMaxGroups]; // per channel group
+  std::thread _worker;
+  std::mutex _workerMutex;
+  std::condition_variable _workerWake;
+  bool _workerQuit;
 };
 
 
@@ -243,6 +535,27 @@ CK_DLL_QUERY( PitchTrack )
     QUERY->add_mfun(QUERY, pitchtrack_getFreq, "float", "get");
     QUERY->doc_func(QUERY, "Get calculated frequency.");
 
+    QUERY->add_mfun(QUERY, pitchtrack_getChanFreq, "float", "get");
+    QUERY->add_arg(QUERY, "int", "chan");
+    QUERY->doc_func(QUERY, "Get calculated frequency of one channel of a multichannel PitchTrack.");
+
+    QUERY->add_mfun(QUERY, pitchtrack_getPitches, "int", "pitches");
+    QUERY->add_arg(QUERY, "float[]", "freqs");
+    QUERY->doc_func(QUERY, "Fill freqs with the calculated frequency of every channel, resizing it to fit. Returns the number of channels.");
+
+    QUERY->add_mfun(QUERY, pitchtrack_getChannels, "int", "channels");
+    QUERY->doc_func(QUERY, "Get the number of channels tracked.");
+
+    QUERY->add_mfun(QUERY, pitchtrack_getEvent, "Event", "event");
+    QUERY->doc_func(QUERY, "Get an Event that is broadcast each time the calculated frequency (of any channel) changes, so a shred can wait on it (pitch.event() => now;) instead of polling get().");
+
+    QUERY->add_mfun(QUERY, pitchtrack_setThreaded, "int", "threaded");
+    QUERY->add_arg(QUERY, "int", "arg");
+    QUERY->doc_func(QUERY, "Set to 1 to run the analysis on a worker thread instead of inside the tick where the frame fills, which removes the CPU spike at every frame. Results then arrive one frame later; if a channel's previous analysis is still running when its next frame is full, that frame is skipped. Default 0.");
+
+    QUERY->add_mfun(QUERY, pitchtrack_getThreaded, "int", "threaded");
+    QUERY->doc_func(QUERY, "Get whether the analysis runs on a worker thread.");
+
     QUERY->add_mfun(QUERY, pitchtrack_getFidelity, "float", "fidelity");
     QUERY->doc_func(QUERY, "Get the threshold for certainty about the result. A highly periodic signal (i.e. one that has a strong pitch center) should produce a result with a high fidelity, which a non-periodic signal (eg noise) will have a very low fidelity. Setting this parameter close to 1 should reduce the number of inaccurate reports. [0-1], default 0.95.");
 
@@ -267,6 +580,32 @@ CK_DLL_QUERY( PitchTrack )
     // IMPORTANT: this MUST be called!
     QUERY->end_class(QUERY);
 
+    // Multichannel PitchTracks inherit everything but the constructor and
+    // the channel count.
+    QUERY->begin_class(QUERY, "PitchTrack2", "PitchTrack");
+    QUERY->add_ctor(QUERY, pitchtrack2_ctor);
+    QUERY->doc_class(QUERY, "Two-channel PitchTrack. Each channel is tracked separately, with one set of settings; get(chan) or pitches() reads the results.");
+    QUERY->add_ugen_funcf(QUERY, pitchtrack_tickf, NULL, 2, 2);
+    QUERY->end_class(QUERY);
+
+    QUERY->begin_class(QUERY, "PitchTrack4", "PitchTrack");
+    QUERY->add_ctor(QUERY, pitchtrack4_ctor);
+    QUERY->doc_class(QUERY, "Four-channel PitchTrack. Each channel is tracked separately, with one set of settings; get(chan) or pitches() reads the results. The channels' frames end together and are analyzed in one batch.");
+    QUERY->add_ugen_funcf(QUERY, pitchtrack_tickf, NULL, 4, 4);
+    QUERY->end_class(QUERY);
+
+    QUERY->begin_class(QUERY, "PitchTrack8", "PitchTrack");
+    QUERY->add_ctor(QUERY, pitchtrack8_ctor);
+    QUERY->doc_class(QUERY, "Eight-channel PitchTrack, e.g. for a hexaphonic pickup. Each channel is tracked separately, with one set of settings; get(chan) or pitches() reads the results. Channels are analyzed in batches of four, half a frame apart, to spread the CPU load.");
+    QUERY->add_ugen_funcf(QUERY, pitchtrack_tickf, NULL, 8, 8);
+    QUERY->end_class(QUERY);
+
+    QUERY->begin_class(QUERY, "PitchTrack16", "PitchTrack");
+    QUERY->add_ctor(QUERY, pitchtrack16_ctor);
+    QUERY->doc_class(QUERY, "Sixteen-channel PitchTrack. Each channel is tracked separately, with one set of settings; get(chan) or pitches() reads the results. Channels are analyzed in batches of four, a quarter frame apart, to spread the CPU load.");
+    QUERY->add_ugen_funcf(QUERY, pitchtrack_tickf, NULL, 16, 16);
+    QUERY->end_class(QUERY);
+
     // wasn't that a breeze?
     return TRUE;
 }
@@ -279,7 +618,7 @@ CK_DLL_CTOR(pitchtrack_ctor)
     OBJ_MEMBER_INT(SELF, pitchtrack_data_offset) = 0;
     
     // instantiate our internal c++ class representation
-    PitchTrack * bcdata = new PitchTrack(API->vm->srate(VM));
+    PitchTrack * bcdata = new PitchTrack(API->vm->srate(VM), VM, API);
     
     // store the pointer in the ChucK object member
     OBJ_MEMBER_INT(SELF, pitchtrack_data_offset) = (t_CKINT) bcdata;
@@ -302,6 +641,32 @@ CK_DLL_DTOR(pitchtrack_dtor)
 }
 
 
+// constructors for the multichannel PitchTracks; PitchTrack's runs first
+CK_DLL_CTOR(pitchtrack2_ctor)
+{
+    PitchTrack * bcdata = (PitchTrack *) OBJ_MEMBER_INT(SELF, pitchtrack_data_offset);
+    if( bcdata ) bcdata->setChannels(2);
+}
+
+CK_DLL_CTOR(pitchtrack4_ctor)
+{
+    PitchTrack * bcdata = (PitchTrack *) OBJ_MEMBER_INT(SELF, pitchtrack_data_offset);
+    if( bcdata ) bcdata->setChannels(4);
+}
+
+CK_DLL_CTOR(pitchtrack8_ctor)
+{
+    PitchTrack * bcdata = (PitchTrack *) OBJ_MEMBER_INT(SELF, pitchtrack_data_offset);
+    if( bcdata ) bcdata->setChannels(8);
+}
+
+CK_DLL_CTOR(pitchtrack16_ctor)
+{
+    PitchTrack * bcdata = (PitchTrack *) OBJ_MEMBER_INT(SELF, pitchtrack_data_offset);
+    if( bcdata ) bcdata->setChannels(16);
+}
+
+
 // implementation for tick function
 CK_DLL_TICK(pitchtrack_tick)
 {
@@ -315,6 +680,19 @@ CK_DLL_TICK(pitchtrack_tick)
     return TRUE;
 }
 
+// implementation for the multichannel tick function
+CK_DLL_TICKF(pitchtrack_tickf)
+{
+    // get our c++ class pointer
+    PitchTrack * c = (PitchTrack *) OBJ_MEMBER_INT(SELF, pitchtrack_data_offset);
+
+    // invoke our tick function on the interleaved frames
+    if(c) c->tick(in, out, nframes);
+
+    // yes
+    return TRUE;
+}
+
 // example implementation for setter
 CK_DLL_MFUN(pitchtrack_setFidelity)
 {
@@ -413,3 +791,52 @@ CK_DLL_MFUN(pitchtrack_getFrame)
     RETURN->v_int = bcdata->getFrame();
 }
 
+
+CK_DLL_MFUN(pitchtrack_setThreaded)
+{
+    // get our c++ class pointer
+    PitchTrack * bcdata = (PitchTrack *) OBJ_MEMBER_INT(SELF, pitchtrack_data_offset);
+    // set the return value
+    RETURN->v_int = bcdata->setThreaded(GET_NEXT_INT(ARGS));
+}
+
+CK_DLL_MFUN(pitchtrack_getThreaded)
+{
+    // get our c++ class pointer
+    PitchTrack * bcdata = (PitchTrack *) OBJ_MEMBER_INT(SELF, pitchtrack_data_offset);
+    // set the return value
+    RETURN->v_int = bcdata->getThreaded();
+}
+
+CK_DLL_MFUN(pitchtrack_getEvent)
+{
+    // get our c++ class pointer
+    PitchTrack * bcdata = (PitchTrack *) OBJ_MEMBER_INT(SELF, pitchtrack_data_offset);
+    // set the return value
+    RETURN->v_object = (Chuck_Object *)bcdata->getEvent();
+}
+
+CK_DLL_MFUN(pitchtrack_getChanFreq)
+{
+    // get our c++ class pointer
+    PitchTrack * bcdata = (PitchTrack *) OBJ_MEMBER_INT(SELF, pitchtrack_data_offset);
+    // set the return value
+    RETURN->v_float = bcdata->getFreq(GET_NEXT_INT(ARGS));
+}
+
+CK_DLL_MFUN(pitchtrack_getPitches)
+{
+    // get our c++ class pointer
+    PitchTrack * bcdata = (PitchTrack *) OBJ_MEMBER_INT(SELF, pitchtrack_data_offset);
+    Chuck_ArrayFloat * freqs = (Chuck_ArrayFloat *) GET_NEXT_OBJECT(ARGS);
+    // set the return value
+    RETURN->v_int = bcdata->getPitches(freqs);
+}
+
+CK_DLL_MFUN(pitchtrack_getChannels)
+{
+    // get our c++ class pointer
+    PitchTrack * bcdata = (PitchTrack *) OBJ_MEMBER_INT(SELF, pitchtrack_data_offset);
+    // set the return value
+    RETURN->v_int = bcdata->getChannels();
+}
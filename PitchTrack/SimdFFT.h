@@ -0,0 +1,55 @@
+// SimdFFT - a real FFT, vectorized with SSE where available.  A copy of
+// Spectacle's genlib/SimdFFT; Helmholtz_dsp uses it for its autocorrelation.
+//
+// The real input of length <len> is transformed as a complex sequence of
+// length <len>/2 (even samples as real parts, odd samples as imaginary parts)
+// by a radix-2 Stockham FFT on split real/imaginary arrays, so every
+// butterfly pass reads and writes contiguous memory, four lanes at a time.
+// The complex result is then untangled into the spectrum of the real input.
+//
+// A SimdFFT holds only read-only tables (twiddle factors), so one plan per
+// length is shared by every user in the process; get one with plan().
+
+#ifndef _SIMDFFT_H_
+#define _SIMDFFT_H_ 1
+
+#include <memory>
+#include <vector>
+
+class SimdFFT {
+public:
+	// Shared plan for FFTs of length <len> (a power of 2, at least 4).
+	static std::shared_ptr<const SimdFFT> plan(int len);
+
+	explicit SimdFFT(int len);
+
+	int length() const { return _len; }
+
+	// Scratch space r2c and c2r need, in floats.
+	int worksize() const { return 2 * _len; }
+
+	// <in> has <len> real samples; <out> receives the spectrum as
+	// re(0), re(len/2), re(1), im(1) ... re(len/2-1), im(len/2-1),
+	// normalized by 1 / len.  Imaginary parts use the exp(+i) convention
+	// (FFTReal's and mayer_realfft's), the negation of FFTW's.  <in> and
+	// <out> may be the same buffer.
+	void r2c(const float *in, float *out, float *work) const;
+
+	// The inverse of r2c, without normalization.  <in> and <out> may be the
+	// same buffer.
+	void c2r(const float *in, float *out, float *work) const;
+
+private:
+	// Complex FFT of length _len / 2, exp(-i) convention, on split arrays.
+	// Uses (xr, xi) and (yr, yi) as ping-pong buffers; returns true if the
+	// result ended up in (yr, yi).
+	bool fft(float *xr, float *xi, float *yr, float *yi) const;
+
+	int _len, _n;
+	// twiddle factors for each pass, in the order the pass reads them
+	std::vector<std::vector<float> > _stage_wr, _stage_wi;
+	// cos, sin (2 pi k / len) for untangling the real spectrum
+	std::vector<float> _cos, _sin;
+};
+
+#endif // _SIMDFFT_H_
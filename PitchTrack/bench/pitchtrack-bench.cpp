@@ -0,0 +1,115 @@
+// pitchtrack-bench - time Helmholtz's analysis and compare it with the
+// mayer_realfft version it replaced.
+//
+// For each frame size, checks that the SNAC function Helmholtz computes
+// with SimdFFT matches the one the mayer_realfft code gave (kept below as a
+// reference), times one analysis each way, and prints the share of one core
+// that 64 voices, each analyzing once per frame, would take.
+// Build with "make bench".
+
+#include "Helmholtz_dsp.h"
+
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+extern "C"
+{
+  void mayer_realfft(int, float *);
+  void mayer_realifft(int, float *);
+}
+
+static double now()
+{
+  using namespace std::chrono;
+  return duration<double>(steady_clock::now().time_since_epoch()).count();
+}
+
+// Helmholtz's autocorrelation and normalization as they were, for one frame
+static void snac_mayer(const float *in, int framesize, float minrms,
+		       std::vector<float> &buf)
+{
+  int n, fftsize = framesize * 2, seek = framesize * SEEK;
+  float norm = 1. / sqrt(float(fftsize));
+  buf.assign(fftsize, 0.f);
+  for (n = 0; n < framesize; n++)
+    buf[n] = in[n] * norm;
+
+  mayer_realfft(fftsize, &buf[0]);
+  buf[0] *= buf[0];
+  buf[framesize] *= buf[framesize];
+  for (n = 1; n < framesize; n++)
+    {
+      buf[n] = buf[n] * buf[n] + buf[fftsize - n] * buf[fftsize - n];
+      buf[fftsize - n] = 0.;
+    }
+  mayer_realifft(fftsize, &buf[0]);
+
+  float rms = minrms / sqrt(1. / (float)framesize);
+  float minrzero = rms * rms;
+  float rzero = buf[0];
+  if (rzero < minrzero)
+    rzero = minrzero;
+  double normintegral = rzero * 2.;
+  buf[0] = 1.;
+  for (n = 1; n < seek; n++)
+    {
+      float signal1 = in[n - 1], signal2 = in[framesize - n];
+      normintegral -= (double)(signal1 * signal1 + signal2 * signal2);
+      buf[n] /= (float)normintegral * 0.5;
+    }
+  for (n = seek; n < framesize; n++)
+    buf[n] = 0.;
+}
+
+int main(int argc, char *argv[])
+{
+  const int reps = (argc > 1) ? atoi(argv[1]) : 2000;
+  const int voices = 64;
+  const float srate = 44100;
+
+  printf("%6s %10s %10s %9s %8s %12s\n", "frame", "snac err", "mayer us",
+	 "Simd us", "speedup", "64 voices");
+
+  for (int framesize = 128; framesize <= 2048; framesize *= 2)
+    {
+      std::vector<float> in(framesize), out(framesize), ref;
+      srand(framesize);
+      for (int i = 0; i < framesize; i++)
+	{
+	  float x = 0;
+	  for (int h = 1; h <= 6; h++)
+	    x += sin(2 * M_PI * 220.0 * h * i / srate) / h;
+	  in[i] = 0.5 * x + 0.02f * (float(rand()) / RAND_MAX - 0.5f);
+	}
+
+      // accuracy: the first call fills the frame, the second analyzes it
+      // and outputs the SNAC function
+      Helmholtz h(framesize, 1);
+      h.iosamples(&in[0], &out[0], framesize);
+      h.iosamples(&in[0], &out[0], framesize);
+      snac_mayer(&in[0], framesize, DEFMINRMS, ref);
+      double err = 0.0;
+      for (int n = 0; n < framesize; n++)
+	err = fmax(err, fabs(out[n] - ref[n]));
+
+      // speed: scaled so each size does roughly the same amount of work
+      const int count = reps * 1024 / framesize + 1;
+      double t0 = now();
+      for (int r = 0; r < count; r++)
+	snac_mayer(&in[0], framesize, DEFMINRMS, ref);
+      double t1 = now();
+      for (int r = 0; r < count; r++)
+	h.iosamples(&in[0], &out[0], framesize);
+      double t2 = now();
+
+      const double us_mayer = (t1 - t0) * 1e6 / count;
+      const double us_simd = (t2 - t1) * 1e6 / count;
+      const double load = voices * (srate / framesize) * us_simd * 1e-6;
+      printf("%6d %10.3g %10.2f %9.2f %7.2fx %11.1f%%\n", framesize, err,
+	     us_mayer, us_simd, us_mayer / us_simd, 100 * load);
+    }
+  return 0;
+}
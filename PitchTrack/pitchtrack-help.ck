@@ -8,6 +8,10 @@
 // Options
 // get(): (read only) get calculated frequency
 //
+// event(): (read only) an Event broadcast each time the calculated
+//   frequency changes; a shred can wait on it (pitch.event() => now;)
+//   instead of polling get().
+//
 // fidelity: (float) [0-1], default 0.95
 //   This is a threshold for certainty about the result. A highly periodic
 //   signal (ie one that has a strong pitch center) should produce a result
@@ -34,6 +38,32 @@
 // bias (float) [0-1], default 0.2
 //   Katja's pitch tracker introduces a small bias to help with the tracking.
 //   (See the link above.) I don't know how this parameter affects the output.
+//
+// threaded (int) [0 or 1], default 0
+//   Set to 1 to analyze each frame on a worker thread instead of inside
+//   the tick where the frame fills, which removes the CPU spike at every
+//   frame. Results then arrive one frame later. If a channel's previous
+//   analysis is still running when its next frame is full, that frame is
+//   skipped.
+
+// Multichannel
+// PitchTrack2, PitchTrack4, PitchTrack8 and PitchTrack16 track each of
+// their input channels separately, with the settings above shared, e.g.
+// for a hexaphonic pickup:
+//
+//   adc => PitchTrack8 strings => blackhole;   // chans 0-5 used
+//   float freqs[0];
+//   strings.pitches(freqs);   // fill freqs with every channel's pitch
+//   strings.get(3);           // or read one channel
+//
+// Channels are analyzed in batches of four that share a frame boundary,
+// and the batches are spread evenly across the frame, so 16 channels
+// cost four small spikes per frame instead of one large one.
+//
+// get(int chan): calculated frequency of one channel
+// pitches(float[] freqs): fill freqs with every channel's frequency,
+//   returning the number of channels
+// channels(): number of channels tracked
 
 // Example
 SinOsc osc => dac; // create an oscillator
@@ -52,3 +82,15 @@ while (true)
 	<<< "Difference:",Math.fabs(osc.freq() - pitch.get()),"Hz\n" >>>;
 	2::second => now;
 }
+
+// To react to each new pitch instead of polling, wait on the event:
+//
+// spork ~ follow();
+// fun void follow()
+// {
+//     while (true)
+//     {
+//         pitch.event() => now;
+//         <<< "new pitch:", pitch.get(), "Hz" >>>;
+//     }
+// }
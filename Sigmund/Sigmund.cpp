@@ -9,6 +9,13 @@
 
 // general includes
 #include <math.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 // declaration of chugin constructor
 CK_DLL_CTOR(sigmund_ctor);
@@ -31,14 +38,46 @@ CK_DLL_MFUN(sigmund_setParam1);
 CK_DLL_MFUN(sigmund_setParam2);
 CK_DLL_MFUN(sigmund_setParam3);
 
+CK_DLL_MFUN(sigmund_setThreaded);
+CK_DLL_MFUN(sigmund_getThreaded);
+CK_DLL_MFUN(sigmund_getAge);
+CK_DLL_MFUN(sigmund_setHop);
+CK_DLL_MFUN(sigmund_getHop);
+CK_DLL_MFUN(sigmund_getEvent);
+CK_DLL_MFUN(sigmund_getPeaks);
+CK_DLL_MFUN(sigmund_getTracks);
 
 
 // for Chugins extending UGen, this is mono synthesis function for 1 sample
 CK_DLL_TICK(sigmund_tick);
+// SigmundOut: the input, pitch and env as three output channels
+CK_DLL_TICKF(sigmundout_tick);
 
 // this is a special offset reserved for Chugin internal data
 t_CKINT sigmund_data_offset = 0;
 
+// The results of one analysis.  Getters read a whole frame, so they never
+// mix the pitch of one window with the peaks of another.
+struct SigmundFrame
+{
+  SigmundFrame() : freq(0), power(0), nfound(0), tracked(false), end(0) {}
+  t_float freq, power;
+  int nfound;
+  bool tracked;                 // whether tracks were updated
+  std::vector<t_peak> peaks;    // [npeak], also the analysis scratch
+  std::vector<t_peak> tracks;   // [npeak], copy of trackv when tracking
+  unsigned long end;            // sample count at the end of the window
+};
+
+// The settings one analysis runs with, taken when it is due, so a
+// shred changing them doesn't race with the worker thread.
+struct SigmundJob
+{
+  t_float maxfreq, param1, param2;
+  bool dopitch, dotracks;
+  unsigned long end;
+};
+
 // class definition for internal Chugin data
 // (note: this isn't strictly necessary, but serves as example
 // of one recommended approach)
@@ -46,8 +85,12 @@ class Sigmund
 {
 public:
   // constructor
-  Sigmund( t_CKFLOAT fs)
+  Sigmund( t_CKFLOAT fs, Chuck_VM *vm, CK_DL_API api)
   {
+    this->vm = vm;
+    this->api = api;
+    event = NULL;
+    eventBuffer = NULL;
     npts = NPOINTS_DEF;
     param1 = 6;
     param2 = 0.5;
@@ -61,54 +104,84 @@ public:
     maxfreq = 1000000;
     loud = 0;
     srate = fs;
-    trackv = 0;
     dopitch = true;
     dotracks = false;
-    nfound = 0;
     inbufIndex = 0;
+    hop = 0;
+    hopIndex = 0;
+    nsamps = 0;
     freq = 0;
-	power = 0;
 	note = 0;
     inbuf = new SAMPLE[npts];
+    anabuf = new SAMPLE[npts];
     for (int i=0; i<npts; i++)
-      inbuf[i] = 0;
-	peakv = new t_peak[npeak];
+      inbuf[i] = anabuf[i] = 0;
 	trackv = new t_peak[npeak];
+	memset(trackv, 0, npeak * sizeof(t_peak));
+	work = sigmund_work_new((int)npts, (int)npeak);
+	resizeFrames();
+	framesBack = 0;
+	framesFront = 1;
+	framesMiddle.store(2);
+	threaded = false;
+	workerQuit = false;
+	jobState.store(kJobIdle);
   }
   
   ~Sigmund()
   {
-    delete inbuf;
-	delete peakv;
-	delete trackv;
+	setThreaded(false);
+	if (event)
+	  api->object->release((Chuck_Object *)event);
+    delete[] inbuf;
+    delete[] anabuf;
+	delete[] trackv;
+	sigmund_work_free(work);
   }
     
   // for Chugins extending UGen
   SAMPLE tick ( SAMPLE in )
   {
     // default: this passes whatever input is patched into Chugin
-    // fill sample buffer
+    // fill sample buffer, a ring holding the last npts samples
     inbuf[inbufIndex++] = in;
     if (inbufIndex >= npts)
+      inbufIndex = 0;
+    nsamps++;
+    if (++hopIndex >= getHop())
       {
-	inbufIndex = 0;
-	// THE MAGIC HAPPENS!!
-	sigmund_getrawpeaks((int)npts, inbuf, (int)npeak, peakv,
-						&nfound, &power, srate, loud, maxfreq);
-	if (dopitch)
-	  sigmund_getpitch(nfound, peakv, &freq, npts, srate, 
-					   param1, param2, loud);
-	if (dotracks)
-	  sigmund_peaktrack(nfound, peakv, (int)npeak, trackv, loud);
+	hopIndex = 0;
+	SigmundJob next = { maxfreq, param1, param2, dopitch, dotracks, nsamps };
+	if (!threaded)
+	  {
+		unrollWindow();
+		job = next;
+		analyze(anabuf);
+	  }
+	// hand the window to the worker; if it is still busy with the last
+	// one, drop this one (age() will show it)
+	else if (jobState.load(std::memory_order_acquire) == kJobIdle)
+	  {
+		unrollWindow();
+		job = next;
+		{
+		  std::lock_guard<std::mutex> lock(workerMutex);
+		  jobState.store(kJobQueued, std::memory_order_release);
+		}
+		workerWake.notify_one();
+	  }
       }
+	// let waiting shreds know about new results
+	if (acquireFrame() && event)
+	  api->vm->queue_event(vm, event, 1, eventBuffer);
 	return in;
   }
     
   // get parameter example
-  float getFreq() { return freq; }
+  float getFreq() { return frames[framesFront].freq; }
 
   // get parameter example
-  float getPower() { return sigmund_powtodb(power); }
+  float getPower() { return sigmund_powtodb(frames[framesFront].power); }
 
   float getPeak( t_CKINT x)
   {
@@ -117,12 +190,13 @@ public:
 	printf("Sigmund error: peak number must be between 0 and %ld.\n", (long)npeak-1); // 1.5.0.7 (ge) cast to long
 	return 0;
       }
-    if (x < nfound)
+    const SigmundFrame &f = frames[framesFront];
+    if (x < f.nfound)
     {
 	  if (dotracks)
-		return trackv[x].p_freq;
+		return f.tracks[x].p_freq;
 	  else
-		return peakv[x].p_freq;
+		return f.peaks[x].p_freq;
     }
 	return 0;
   }
@@ -134,16 +208,51 @@ public:
 	printf("Sigmund error: amp number must be between 0 and %ld.\n", (long)npeak-1); // 1.5.0.7 (ge) cast to long
 	return 0;
       }
-    if (x < nfound)
+    const SigmundFrame &f = frames[framesFront];
+    if (x < f.nfound)
     {
 	  if (dotracks)
-		return trackv[x].p_amp;
+		return f.tracks[x].p_amp;
 	  else
-		return peakv[x].p_amp;
+		return f.peaks[x].p_amp;
     }
 	return 0;
   }
 
+  // samples between the end of the window the current results came from
+  // and now
+  t_CKDUR getAge() { return (t_CKDUR)(nsamps - frames[framesFront].end); }
+
+  // The Event broadcast whenever new results are ready, made on first use.
+  Chuck_Event *getEvent()
+  {
+	if (!event)
+	  {
+		event = (Chuck_Event *)api->object->create_without_shred(vm,
+		  api->type->lookup(vm, "Event"), TRUE);
+		eventBuffer = api->vm->create_event_buffer(vm);
+	  }
+	return event;
+  }
+
+  // Fill <freqs> and <amps> with the peaks found, strongest first.
+  t_CKINT getPeaks( Chuck_ArrayFloat *freqs, Chuck_ArrayFloat *amps)
+  {
+	const SigmundFrame &f = frames[framesFront];
+	fillArrays(&f.peaks[0], f.nfound, freqs, amps);
+	return f.nfound;
+  }
+
+  // Fill <freqs> and <amps> with every track, npeak of them; a track not
+  // currently sounding has amp 0.  Empty unless tracks are on.
+  t_CKINT getTracks( Chuck_ArrayFloat *freqs, Chuck_ArrayFloat *amps)
+  {
+	const SigmundFrame &f = frames[framesFront];
+	int n = f.tracked ? (int)f.tracks.size() : 0;
+	fillArrays(n ? &f.tracks[0] : NULL, n, freqs, amps);
+	return n;
+  }
+
   t_CKINT setTracks ( t_CKINT x)
   {
 	if (x) dotracks = true;
@@ -153,56 +262,80 @@ public:
 
   void clear()
   {
-    npts = NPOINTS_DEF;
+	sync();
     param1 = 6;
     param2 = 0.5;
     param3 = 0;
     mode = MODE_STREAM;
-    npeak = NPEAK_DEF;
     vibrato = VIBRATO_DEF;
     stabletime = STABLETIME_DEF;
     growth = GROWTH_DEF;
     minpower = MINPOWER_DEF;
     maxfreq = 1000000;
     loud = 0;
-    trackv = 0;
     dopitch = true;
     dotracks = false;
-    nfound = 0;
     freq = 0;
-	power = 0;
 	note = 0;
+	setNpts(NPOINTS_DEF);
+	setNpeak(NPEAK_DEF);
 	for (int i=0; i<npts; i++)
 	  inbuf[i] = 0;
 	inbufIndex = 0;
+	hop = 0;
+	hopIndex = 0;
+	memset(trackv, 0, npeak * sizeof(t_peak));
+	// drop any results not yet picked up, then empty every frame
+	framesMiddle.store(framesMiddle.load() & kFramesSlotMask);
+	for (int i = 0; i < 3; i++)
+	  {
+		frames[i].freq = frames[i].power = 0;
+		frames[i].nfound = 0;
+		frames[i].end = nsamps;
+	  }
   }
 
   float setNpts ( t_CKINT x)
   {
-	float nwas = npts;
+	sync();
+	t_CKINT nwas = npts;
 	npts = x;
 	if (npts < NPOINTS_MIN)
 	  npts = NPOINTS_MIN;
 	if (npts != (1LL << sigmund_ilog2((int)npts)))
 	  printf("Sigmund: adjusting analysis size to %ld points\n", (long)((npts = (1LL << sigmund_ilog2((int)npts)))));
 	if (npts != nwas)
-	  inbufIndex = 0;
-	if (mode==MODE_STREAM)
 	  {
-		if (inbuf)
-		  {
-			delete inbuf;
-		  }
+		inbufIndex = 0;
+		hopIndex = 0;
+		delete[] inbuf;
+		delete[] anabuf;
 		inbuf = new SAMPLE[npts];
+		anabuf = new SAMPLE[npts];
+		for (int i=0; i<npts; i++)
+		  inbuf[i] = anabuf[i] = 0;
+		sigmund_work_free(work);
+		work = sigmund_work_new((int)npts, (int)npeak);
 	  }
-	else inbuf = 0;
 	return x;
   }
 
   float setNpeak ( t_CKINT x)
   {
+	sync();
+	t_CKINT nwas = npeak;
 	npeak = x;
 	if (npeak < 1) npeak = 1;
+	if (npeak != nwas)
+	  {
+		// tracks restart from nothing
+		delete[] trackv;
+		trackv = new t_peak[npeak];
+		memset(trackv, 0, npeak * sizeof(t_peak));
+		sigmund_work_free(work);
+		work = sigmund_work_new((int)npts, (int)npeak);
+		resizeFrames();
+	  }
 	return x;
   }
 
@@ -221,7 +354,7 @@ public:
 
   float setMinpower ( t_CKFLOAT x)
   {
-	minpower = 0;
+	minpower = x;
 	if (minpower < 0) minpower = 0;
 	return x;
   }
@@ -257,6 +390,44 @@ public:
 	else dotracks = false;
 	return x;
   }
+
+  t_CKINT setThreaded ( t_CKINT x)
+  {
+	bool on = x != 0;
+#ifdef __EMSCRIPTEN__
+	on = false;
+#endif
+	if (on == threaded)
+	  return threaded;
+	if (on)
+	  {
+		workerQuit = false;
+		worker = std::thread(&Sigmund::workerLoop, this);
+	  }
+	else
+	  {
+		sync();
+		{
+		  std::lock_guard<std::mutex> lock(workerMutex);
+		  workerQuit = true;
+		}
+		workerWake.notify_one();
+		worker.join();
+	  }
+	threaded = on;
+	return threaded;
+  }
+
+  t_CKINT getThreaded() { return threaded; }
+
+  // samples between analyses; 0 means npts
+  t_CKINT setHop ( t_CKINT x)
+  {
+	hop = x < 0 ? 0 : x;
+	return hop;
+  }
+
+  t_CKINT getHop() { return hop > 0 ? hop : npts; }
   
 private:
 
@@ -270,7 +441,106 @@ private:
 	  }
   }
 
+  // Analyze one window of npts samples with the settings in <job> and
+  // publish the results.  Runs on the worker thread when threaded, else
+  // in tick.
+  void analyze(SAMPLE *buf)
+  {
+	SigmundFrame &f = frames[framesBack];
+	t_peak *peakv = &f.peaks[0];
+	// THE MAGIC HAPPENS!!
+	sigmund_getrawpeaks(work, (int)npts, buf, (int)npeak, peakv,
+						&f.nfound, &f.power, srate, loud, job.maxfreq);
+	if (job.dopitch)
+	  sigmund_getpitch(work, f.nfound, peakv, &freq, npts, srate,
+					   job.param1, job.param2, loud);
+	if (job.dotracks)
+	  {
+		sigmund_peaktrack(work, f.nfound, peakv, (int)npeak, trackv, loud);
+		std::copy(trackv, trackv + npeak, f.tracks.begin());
+	  }
+	f.tracked = job.dotracks;
+	f.freq = freq;
+	f.end = job.end;
+	framesBack = framesMiddle.exchange(framesBack | kFramesFresh,
+	  std::memory_order_acq_rel) & kFramesSlotMask;
+  }
+
+  void fillArrays( const t_peak *peaks, int n, Chuck_ArrayFloat *freqs,
+				   Chuck_ArrayFloat *amps)
+  {
+	if (freqs)
+	  {
+		api->object->array_float_clear(freqs);
+		for (int i = 0; i < n; i++)
+		  api->object->array_float_push_back(freqs, peaks[i].p_freq);
+	  }
+	if (amps)
+	  {
+		api->object->array_float_clear(amps);
+		for (int i = 0; i < n; i++)
+		  api->object->array_float_push_back(amps, peaks[i].p_amp);
+	  }
+  }
+
+  // Copy the ring into anabuf, oldest sample first.
+  void unrollWindow()
+  {
+	memcpy(anabuf, inbuf + inbufIndex, (npts - inbufIndex) * sizeof(SAMPLE));
+	memcpy(anabuf + npts - inbufIndex, inbuf, inbufIndex * sizeof(SAMPLE));
+  }
+
+  // Pick up the newest published frame, if any; true if there was one.
+  bool acquireFrame()
+  {
+	if (!(framesMiddle.load(std::memory_order_relaxed) & kFramesFresh))
+	  return false;
+	framesFront = framesMiddle.exchange(framesFront,
+	  std::memory_order_acq_rel) & kFramesSlotMask;
+	return true;
+  }
+
+  // Size every frame for npeak; only called with the worker idle.
+  void resizeFrames()
+  {
+	for (int i = 0; i < 3; i++)
+	  {
+		frames[i].peaks.assign(npeak, t_peak());
+		frames[i].tracks.assign(npeak, t_peak());
+		frames[i].nfound = std::min(frames[i].nfound, (int)npeak);
+	  }
+  }
+
+  // Wait for the worker to finish the window it has, if any.
+  void sync()
+  {
+	while (jobState.load(std::memory_order_acquire) == kJobQueued)
+	  std::this_thread::yield();
+  }
+
+  void workerLoop()
+  {
+	std::unique_lock<std::mutex> lock(workerMutex);
+	for (;;)
+	  {
+		workerWake.wait(lock, [this] {
+		  return workerQuit
+			|| jobState.load(std::memory_order_acquire) == kJobQueued;
+		});
+		if (workerQuit)
+		  break;
+		lock.unlock();
+		analyze(anabuf);
+		jobState.store(kJobIdle, std::memory_order_release);
+		lock.lock();
+	  }
+  }
+
   // instance data
+  Chuck_VM *vm;
+  CK_DL_API api;
+  Chuck_Event *event;          // broadcast on new results, or NULL
+  CBufferSimple *eventBuffer;
   t_float srate;       // sample rate 
   int mode;         // MODE_STREAM, etc. 
   t_CKINT npts;         // number of points in analysis window
@@ -288,12 +558,34 @@ private:
   t_float param3;
   t_notefinder notefinder;  // note parsing state 
   t_peak *trackv;           // peak tracking state 
-  t_peak *peakv;
+  t_sigmund_work *work;     // analysis scratch, sized on npts and npeak
   bool dopitch, dotracks;
-  t_float freq, power, note;
-  SAMPLE* inbuf;
-  unsigned int inbufIndex;
-  int nfound;        // number of tracks found?
+  t_float freq, note;       // freq: last pitch found, kept when dopitch is off
+  SAMPLE* inbuf;            // ring of the last npts samples
+  SAMPLE* anabuf;           // the window being analyzed, in order
+  unsigned int inbufIndex;  // next write position in inbuf
+  t_CKINT hop;              // samples between analyses, 0 for npts
+  t_CKINT hopIndex;         // samples since the last analysis
+  unsigned long nsamps;     // samples ticked so far
+
+  // results, triple buffered between the analysis and the getters: the
+  // analysis fills frames[framesBack], getters read frames[framesFront],
+  // and framesMiddle holds the slot in between plus a "fresh" flag
+  static const int kFramesSlotMask = 3;
+  static const int kFramesFresh = 4;
+  SigmundFrame frames[3];
+  int framesBack, framesFront;
+  std::atomic<int> framesMiddle;
+
+  // worker thread
+  enum { kJobIdle, kJobQueued };
+  bool threaded;
+  SigmundJob job;
+  std::atomic<int> jobState;
+  std::thread worker;
+  std::mutex workerMutex;
+  std::condition_variable workerWake;
+  bool workerQuit;
 };
 
 // query function: chuck calls this when loading the Chugin
@@ -380,6 +672,36 @@ CK_DLL_QUERY( Sigmund )
   QUERY->add_mfun(QUERY, sigmund_setParam3, "float", "param3");
   QUERY->add_arg(QUERY, "float", "arg");
   QUERY->doc_func(QUERY, "Mysterious setting...");
+
+  QUERY->add_mfun(QUERY, sigmund_setThreaded, "int", "threaded");
+  QUERY->add_arg(QUERY, "int", "arg");
+  QUERY->doc_func(QUERY, "Set to 1 to run the analysis on a worker thread instead of inside the tick where the window fills, which removes the CPU spike at every analysis. Results then arrive up to one hop later; if an analysis is still running when the next one is due, that one is skipped. Default 0.");
+
+  QUERY->add_mfun(QUERY, sigmund_getThreaded, "int", "threaded");
+  QUERY->doc_func(QUERY, "Get whether the analysis runs on a worker thread.");
+
+  QUERY->add_mfun(QUERY, sigmund_setHop, "int", "hop");
+  QUERY->add_arg(QUERY, "int", "hop");
+  QUERY->doc_func(QUERY, "Set the number of samples between analyses. Each analysis still looks at the last npts samples, so a hop below npts gives overlapping windows and more frequent updates without losing frequency resolution; CPU cost grows as npts / hop. 0 means npts (no overlap). Default: 0.");
+
+  QUERY->add_mfun(QUERY, sigmund_getHop, "int", "hop");
+  QUERY->doc_func(QUERY, "Get the number of samples between analyses.");
+
+  QUERY->add_mfun(QUERY, sigmund_getEvent, "Event", "event");
+  QUERY->doc_func(QUERY, "Get an Event that is broadcast each time new results are ready, so a shred can wait on it (siggy.event() => now;) instead of polling.");
+
+  QUERY->add_mfun(QUERY, sigmund_getPeaks, "int", "peaks");
+  QUERY->add_arg(QUERY, "float[]", "freqs");
+  QUERY->add_arg(QUERY, "float[]", "amps");
+  QUERY->doc_func(QUERY, "Fill freqs and amps with the frequency and amplitude of every peak found, strongest first, resizing them to fit. Returns the number of peaks.");
+
+  QUERY->add_mfun(QUERY, sigmund_getTracks, "int", "tracks");
+  QUERY->add_arg(QUERY, "float[]", "freqs");
+  QUERY->add_arg(QUERY, "float[]", "amps");
+  QUERY->doc_func(QUERY, "Fill freqs and amps with the frequency and amplitude of every track (npeak of them), resizing them to fit. A track that isn't sounding has amplitude 0. Returns the number of tracks, 0 unless tracks is on.");
+
+  QUERY->add_mfun(QUERY, sigmund_getAge, "dur", "age");
+  QUERY->doc_func(QUERY, "Get how old the current results are: the time since the end of the window they were computed from. All results (freq, env, peak, amp) always come from the same window.");
   
   // this reserves a variable in the ChucK internal class to store 
   // referene to the c++ class we defined above
@@ -388,6 +710,11 @@ CK_DLL_QUERY( Sigmund )
   // end the class definition
   // IMPORTANT: this MUST be called!
   QUERY->end_class(QUERY);
+
+  QUERY->begin_class(QUERY, "SigmundOut", "Sigmund");
+  QUERY->doc_class(QUERY, "Sigmund with its results as signals, for UGens to follow without a polling shred. Output channel 0 passes the input through, channel 1 is the pitch (freq) in Hz and channel 2 the envelope (env) in dB, each holding its value until the next analysis. For example, siggy.chan(1) => SinOsc s; with 0 => s.sync; makes s follow the pitch.");
+  QUERY->add_ugen_funcf(QUERY, sigmundout_tick, NULL, 1, 3);
+  QUERY->end_class(QUERY);
   
   // wasn't that a breeze?
   return TRUE;
@@ -401,7 +728,7 @@ CK_DLL_CTOR(sigmund_ctor)
   OBJ_MEMBER_INT(SELF, sigmund_data_offset) = 0;
   
   // instantiate our internal c++ class representation
-  Sigmund * bcdata = new Sigmund(API->vm->srate(VM));
+  Sigmund * bcdata = new Sigmund(API->vm->srate(VM), VM, API);
   
   // store the pointer in the ChucK object member
   OBJ_MEMBER_INT(SELF, sigmund_data_offset) = (t_CKINT) bcdata;
@@ -437,6 +764,23 @@ CK_DLL_TICK(sigmund_tick)
   return TRUE;
 }
 
+// implementation for SigmundOut's tick function
+CK_DLL_TICKF(sigmundout_tick)
+{
+  // get our c++ class pointer
+  Sigmund * c = (Sigmund *) OBJ_MEMBER_INT(SELF, sigmund_data_offset);
+  if (!c) return FALSE;
+
+  for (t_CKUINT i = 0; i < nframes; i++)
+    {
+      out[3*i] = c->tick(in[i]);
+      out[3*i+1] = c->getFreq();
+      out[3*i+2] = c->getPower();
+    }
+  
+  return TRUE;
+}
+
 // example implementation for getter
 CK_DLL_MFUN(sigmund_getFreq)
 {
@@ -553,3 +897,71 @@ CK_DLL_MFUN(sigmund_clear)
   // set the return value
   bcdata->clear();
 }
+
+CK_DLL_MFUN(sigmund_setThreaded)
+{
+  // get our c++ class pointer
+  Sigmund * bcdata = (Sigmund *) OBJ_MEMBER_INT(SELF, sigmund_data_offset);
+  // set the return value
+  RETURN->v_int = bcdata->setThreaded(GET_NEXT_INT(ARGS));
+}
+
+CK_DLL_MFUN(sigmund_getThreaded)
+{
+  // get our c++ class pointer
+  Sigmund * bcdata = (Sigmund *) OBJ_MEMBER_INT(SELF, sigmund_data_offset);
+  // set the return value
+  RETURN->v_int = bcdata->getThreaded();
+}
+
+CK_DLL_MFUN(sigmund_getAge)
+{
+  // get our c++ class pointer
+  Sigmund * bcdata = (Sigmund *) OBJ_MEMBER_INT(SELF, sigmund_data_offset);
+  // set the return value
+  RETURN->v_dur = bcdata->getAge();
+}
+
+CK_DLL_MFUN(sigmund_setHop)
+{
+  // get our c++ class pointer
+  Sigmund * bcdata = (Sigmund *) OBJ_MEMBER_INT(SELF, sigmund_data_offset);
+  // set the return value
+  RETURN->v_int = bcdata->setHop(GET_NEXT_INT(ARGS));
+}
+
+CK_DLL_MFUN(sigmund_getHop)
+{
+  // get our c++ class pointer
+  Sigmund * bcdata = (Sigmund *) OBJ_MEMBER_INT(SELF, sigmund_data_offset);
+  // set the return value
+  RETURN->v_int = bcdata->getHop();
+}
+
+CK_DLL_MFUN(sigmund_getEvent)
+{
+  // get our c++ class pointer
+  Sigmund * bcdata = (Sigmund *) OBJ_MEMBER_INT(SELF, sigmund_data_offset);
+  // set the return value
+  RETURN->v_object = (Chuck_Object *)bcdata->getEvent();
+}
+
+CK_DLL_MFUN(sigmund_getPeaks)
+{
+  // get our c++ class pointer
+  Sigmund * bcdata = (Sigmund *) OBJ_MEMBER_INT(SELF, sigmund_data_offset);
+  Chuck_ArrayFloat * freqs = (Chuck_ArrayFloat *) GET_NEXT_OBJECT(ARGS);
+  Chuck_ArrayFloat * amps = (Chuck_ArrayFloat *) GET_NEXT_OBJECT(ARGS);
+  // set the return value
+  RETURN->v_int = bcdata->getPeaks(freqs, amps);
+}
+
+CK_DLL_MFUN(sigmund_getTracks)
+{
+  // get our c++ class pointer
+  Sigmund * bcdata = (Sigmund *) OBJ_MEMBER_INT(SELF, sigmund_data_offset);
+  Chuck_ArrayFloat * freqs = (Chuck_ArrayFloat *) GET_NEXT_OBJECT(ARGS);
+  Chuck_ArrayFloat * amps = (Chuck_ArrayFloat *) GET_NEXT_OBJECT(ARGS);
+  // set the return value
+  RETURN->v_int = bcdata->getTracks(freqs, amps);
+}
@@ -57,21 +57,52 @@ typedef struct _notefinder
   int n_histphase;
 } t_notefinder;
 
+#define SUBHARMONICS 16
+
+/* scratch space for analyzing windows of up to w_npts points into up to
+   w_npeak peaks, allocated once so that analysis neither allocates nor
+   grows the stack */
+typedef struct _sigmund_work
+{
+  int w_npts;
+  int w_npeak;
+  void *w_fft;               /* real FFT plan of length 2*npts */
+  t_float *w_fftin;          /* zero-padded FFT input, 2*npts */
+  t_float *w_fftwork;        /* FFT scratch */
+  t_float *w_bigbuf;         /* FFT output, power and raw spectrum */
+  int *w_cand;               /* candidate peak bins */
+  int *w_pickedbin;          /* bins and powers of the peaks found so far */
+  t_float *w_pickedpower;
+  t_peak **w_peakptrs;       /* peaks sorted by frequency, for tweaking */
+  t_peak **w_trackptrs;      /* tracks sorted by frequency */
+  t_float *w_weights;        /* pitch histogram */
+  double w_suboffset[SUBHARMONICS];  /* (48/log 2) log(j+1), the pitch
+					offset of subharmonic j, in 1/48
+					octaves */
+} t_sigmund_work;
+
 #ifdef __cplusplus
 extern "C"
 {
 #endif // __cplusplus
   extern void mayer_fft(int n, t_sample *real, t_sample *imag);
   extern void mayer_realfft(int n, t_sample *real);
-  void sigmund_getrawpeaks(int npts, t_float *insamps,
+  void *sigmund_fft_new(int n);
+  void sigmund_fft_free(void *fft);
+  int sigmund_fft_worksize(void *fft);
+  void sigmund_fft_r2c(void *fft, const t_float *in, t_float *out,
+		       t_float *work);
+  t_sigmund_work *sigmund_work_new(int npts, int npeak);
+  void sigmund_work_free(t_sigmund_work *w);
+  void sigmund_getrawpeaks(t_sigmund_work *w, int npts, t_float *insamps,
 			   int npeak, t_peak *peakv, int *nfound, t_float *power, t_float srate, int loud,
 			   t_float hifreq);
-  void sigmund_getpitch(int npeak, t_peak *peakv, t_float *freqp,
+  void sigmund_getpitch(t_sigmund_work *w, int npeak, t_peak *peakv, t_float *freqp,
 			t_float npts, t_float srate, t_float nharmonics, t_float amppower, int loud);
   void notefinder_doit(t_notefinder *x, t_float freq, t_float power,
 		       t_float *note, t_float vibrato, int stableperiod, t_float powerthresh,
 		       t_float growththresh, int loud);
-  void sigmund_peaktrack(int ninpeak, t_peak *inpeakv, 
+  void sigmund_peaktrack(t_sigmund_work *w, int ninpeak, t_peak *inpeakv, 
 			 int noutpeak, t_peak *outpeakv, int loud);
   int sigmund_ilog2(int n);
 #ifdef __cplusplus
@@ -0,0 +1,241 @@
+// SimdFFT - see SimdFFT.h.
+
+#define _USE_MATH_DEFINES // for Visual Studio
+#include "SimdFFT.h"
+#include <math.h>
+#include <map>
+#include <mutex>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+	#include <xmmintrin.h>
+	#define SIMDFFT_SSE
+#endif
+
+
+std::shared_ptr<const SimdFFT> SimdFFT::plan(int len)
+{
+	static std::mutex mutex;
+	static std::map<int, std::weak_ptr<const SimdFFT> > plans;
+
+	std::lock_guard<std::mutex> lock(mutex);
+	std::shared_ptr<const SimdFFT> p = plans[len].lock();
+	if (!p) {
+		p = std::make_shared<SimdFFT>(len);
+		plans[len] = p;
+	}
+	return p;
+}
+
+
+SimdFFT::SimdFFT(int len)
+	: _len(len), _n(len / 2)
+{
+	// Pass k has sub-transforms of length n / 2^k, with stride s = 2^k.
+	// Its twiddles are exp(-2 pi i p / (n / s)) for p < n / (2 s).  The
+	// s == 2 pass reads each twiddle for two adjacent lanes, so store it
+	// twice.
+	for (int s = 1, ncur = _n; ncur > 1; s *= 2, ncur /= 2) {
+		const int m = ncur / 2;
+		const int reps = (s == 2) ? 2 : 1;
+		std::vector<float> wr, wi;
+		for (int p = 0; p < m; p++) {
+			const double theta = 2.0 * M_PI * p / ncur;
+			for (int r = 0; r < reps; r++) {
+				wr.push_back(float(cos(theta)));
+				wi.push_back(float(-sin(theta)));
+			}
+		}
+		_stage_wr.push_back(wr);
+		_stage_wi.push_back(wi);
+	}
+
+	for (int k = 0; k < _n; k++) {
+		const double theta = 2.0 * M_PI * k / _len;
+		_cos.push_back(float(cos(theta)));
+		_sin.push_back(float(sin(theta)));
+	}
+}
+
+
+bool SimdFFT::fft(float *xr, float *xi, float *yr, float *yi) const
+{
+	bool swapped = false;
+	int stage = 0;
+	for (int s = 1, ncur = _n; ncur > 1; s *= 2, ncur /= 2, stage++) {
+		const int m = ncur / 2;
+		const float *wr = &_stage_wr[stage][0];
+		const float *wi = &_stage_wi[stage][0];
+		bool done = false;
+
+#ifdef SIMDFFT_SSE
+		if (s == 1 && m >= 4) {
+			// y[2p] = a + b, y[2p + 1] = (a - b) w[p]; vectorize over p
+			for (int p = 0; p < m; p += 4) {
+				const __m128 ar = _mm_loadu_ps(xr + p), ai = _mm_loadu_ps(xi + p);
+				const __m128 br = _mm_loadu_ps(xr + p + m), bi = _mm_loadu_ps(xi + p + m);
+				const __m128 w_r = _mm_loadu_ps(wr + p), w_i = _mm_loadu_ps(wi + p);
+				const __m128 sr = _mm_add_ps(ar, br), si = _mm_add_ps(ai, bi);
+				const __m128 dr = _mm_sub_ps(ar, br), di = _mm_sub_ps(ai, bi);
+				const __m128 tr = _mm_sub_ps(_mm_mul_ps(dr, w_r), _mm_mul_ps(di, w_i));
+				const __m128 ti = _mm_add_ps(_mm_mul_ps(dr, w_i), _mm_mul_ps(di, w_r));
+				_mm_storeu_ps(yr + 2 * p, _mm_unpacklo_ps(sr, tr));
+				_mm_storeu_ps(yr + 2 * p + 4, _mm_unpackhi_ps(sr, tr));
+				_mm_storeu_ps(yi + 2 * p, _mm_unpacklo_ps(si, ti));
+				_mm_storeu_ps(yi + 2 * p + 4, _mm_unpackhi_ps(si, ti));
+			}
+			done = true;
+		}
+		else if (s == 2 && m >= 2) {
+			// lanes are (p, q=0), (p, q=1), (p+1, q=0), (p+1, q=1)
+			for (int p = 0; p < m; p += 2) {
+				const __m128 ar = _mm_loadu_ps(xr + 2 * p), ai = _mm_loadu_ps(xi + 2 * p);
+				const __m128 br = _mm_loadu_ps(xr + 2 * (p + m)), bi = _mm_loadu_ps(xi + 2 * (p + m));
+				const __m128 w_r = _mm_loadu_ps(wr + 2 * p), w_i = _mm_loadu_ps(wi + 2 * p);
+				const __m128 sr = _mm_add_ps(ar, br), si = _mm_add_ps(ai, bi);
+				const __m128 dr = _mm_sub_ps(ar, br), di = _mm_sub_ps(ai, bi);
+				const __m128 tr = _mm_sub_ps(_mm_mul_ps(dr, w_r), _mm_mul_ps(di, w_i));
+				const __m128 ti = _mm_add_ps(_mm_mul_ps(dr, w_i), _mm_mul_ps(di, w_r));
+				_mm_storeu_ps(yr + 4 * p, _mm_movelh_ps(sr, tr));
+				_mm_storeu_ps(yr + 4 * p + 4, _mm_movehl_ps(tr, sr));
+				_mm_storeu_ps(yi + 4 * p, _mm_movelh_ps(si, ti));
+				_mm_storeu_ps(yi + 4 * p + 4, _mm_movehl_ps(ti, si));
+			}
+			done = true;
+		}
+		else if (s >= 4) {
+			// vectorize over q, the twiddle is the same for all lanes
+			for (int p = 0; p < m; p++) {
+				const __m128 w_r = _mm_set1_ps(wr[p]), w_i = _mm_set1_ps(wi[p]);
+				const float *a_r = xr + s * p, *a_i = xi + s * p;
+				const float *b_r = xr + s * (p + m), *b_i = xi + s * (p + m);
+				float *y0r = yr + s * 2 * p, *y0i = yi + s * 2 * p;
+				float *y1r = y0r + s, *y1i = y0i + s;
+				for (int q = 0; q < s; q += 4) {
+					const __m128 ar = _mm_loadu_ps(a_r + q), ai = _mm_loadu_ps(a_i + q);
+					const __m128 br = _mm_loadu_ps(b_r + q), bi = _mm_loadu_ps(b_i + q);
+					const __m128 dr = _mm_sub_ps(ar, br), di = _mm_sub_ps(ai, bi);
+					_mm_storeu_ps(y0r + q, _mm_add_ps(ar, br));
+					_mm_storeu_ps(y0i + q, _mm_add_ps(ai, bi));
+					_mm_storeu_ps(y1r + q, _mm_sub_ps(_mm_mul_ps(dr, w_r), _mm_mul_ps(di, w_i)));
+					_mm_storeu_ps(y1i + q, _mm_add_ps(_mm_mul_ps(dr, w_i), _mm_mul_ps(di, w_r)));
+				}
+			}
+			done = true;
+		}
+#endif
+
+		if (!done) {
+			const int wstep = (s == 2) ? 2 : 1;
+			for (int p = 0; p < m; p++) {
+				const float w_r = wr[p * wstep], w_i = wi[p * wstep];
+				for (int q = 0; q < s; q++) {
+					const float ar = xr[q + s * p], ai = xi[q + s * p];
+					const float br = xr[q + s * (p + m)], bi = xi[q + s * (p + m)];
+					const float dr = ar - br, di = ai - bi;
+					yr[q + s * 2 * p] = ar + br;
+					yi[q + s * 2 * p] = ai + bi;
+					yr[q + s * (2 * p + 1)] = dr * w_r - di * w_i;
+					yi[q + s * (2 * p + 1)] = dr * w_i + di * w_r;
+				}
+			}
+		}
+
+		float *t = xr; xr = yr; yr = t;
+		t = xi; xi = yi; yi = t;
+		swapped = !swapped;
+	}
+	return swapped;
+}
+
+
+void SimdFFT::r2c(const float *in, float *out, float *work) const
+{
+	const int n = _n;
+	float *xr = work, *xi = work + n, *yr = work + 2 * n, *yi = work + 3 * n;
+
+	// even samples -> real parts, odd samples -> imaginary parts
+	int k = 0;
+#ifdef SIMDFFT_SSE
+	for (; k + 4 <= n; k += 4) {
+		const __m128 a = _mm_loadu_ps(in + 2 * k), b = _mm_loadu_ps(in + 2 * k + 4);
+		_mm_storeu_ps(xr + k, _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+		_mm_storeu_ps(xi + k, _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+	}
+#endif
+	for (; k < n; k++) {
+		xr[k] = in[2 * k];
+		xi[k] = in[2 * k + 1];
+	}
+
+	if (fft(xr, xi, yr, yi)) {
+		float *t = xr; xr = yr; yr = t;
+		t = xi; xi = yi; yi = t;
+	}
+
+	// Untangle: X[k] = E[k] + W^k O[k], with E and O the spectra of the even
+	// and odd samples, E[k] = (Z[k] + Z*[n-k]) / 2, O[k] = (Z[k] - Z*[n-k]) / 2i.
+	// Store conj(X[k]), matching FFTReal's sign.
+	const float scale = 1.0f / _len;
+	const float r0 = xr[0], i0 = xi[0];
+	for (k = 1; k < n; k++) {
+		const float ar = xr[k], ai = xi[k];
+		const float br = xr[n - k], bi = xi[n - k];
+		const float er = 0.5f * (ar + br), ei = 0.5f * (ai - bi);
+		const float or_ = 0.5f * (ai + bi), oi = -0.5f * (ar - br);
+		const float c = _cos[k], s = _sin[k];
+		// W^k = c - i s
+		yr[k] = (er + c * or_ + s * oi) * scale;
+		yi[k] = -(ei + c * oi - s * or_) * scale;
+	}
+	// <out> may alias <in>, which we're done reading
+	out[0] = (r0 + i0) * scale;
+	out[1] = (r0 - i0) * scale;
+	for (k = 1; k < n; k++) {
+		out[2 * k] = yr[k];
+		out[2 * k + 1] = yi[k];
+	}
+}
+
+
+void SimdFFT::c2r(const float *in, float *out, float *work) const
+{
+	const int n = _n;
+	float *xr = work, *xi = work + n, *yr = work + 2 * n, *yi = work + 3 * n;
+
+	// Retangle into Z[k] = 2 (E[k] + i O[k]), conjugated so that the forward
+	// FFT computes the inverse.  Input imaginary parts have FFTReal's sign.
+	xr[0] = in[0] + in[1];
+	xi[0] = -(in[0] - in[1]);
+	for (int k = 1; k < n; k++) {
+		const float ar = in[2 * k], ai = -in[2 * k + 1];
+		const float br = in[2 * (n - k)], bi = -in[2 * (n - k) + 1];
+		const float pr = ar + br, pi = ai - bi;
+		const float qr = ar - br, qi = ai + bi;
+		const float c = _cos[k], s = _sin[k];
+		// W^-k = c + i s
+		const float rr = c * qr - s * qi, ri = c * qi + s * qr;
+		xr[k] = pr - ri;
+		xi[k] = -(pi + rr);
+	}
+
+	if (fft(xr, xi, yr, yi)) {
+		xr = yr;
+		xi = yi;
+	}
+
+	// conjugate back and interleave
+	int k = 0;
+#ifdef SIMDFFT_SSE
+	const __m128 neg = _mm_set1_ps(-1.0f);
+	for (; k + 4 <= n; k += 4) {
+		const __m128 re = _mm_loadu_ps(xr + k);
+		const __m128 im = _mm_mul_ps(_mm_loadu_ps(xi + k), neg);
+		_mm_storeu_ps(out + 2 * k, _mm_unpacklo_ps(re, im));
+		_mm_storeu_ps(out + 2 * k + 4, _mm_unpackhi_ps(re, im));
+	}
+#endif
+	for (; k < n; k++) {
+		out[2 * k] = xr[k];
+		out[2 * k + 1] = -xi[k];
+	}
+}
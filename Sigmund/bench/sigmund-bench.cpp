@@ -0,0 +1,244 @@
+// sigmund-bench - time Sigmund's analysis and compare its FFT, SimdFFT,
+// against mayer_realfft, which it used before.
+//
+// For each analysis size, checks that SimdFFT's spectrum matches
+// mayer_realfft's (unpacked and scaled as sigmund_getrawpeaks does), times
+// the zero-padded FFT each way, and times whole analyses
+// (sigmund_getrawpeaks + sigmund_getpitch) on a harmonic tone in noise.
+// Then, at several track counts, checks that sigmund_peaktrack assigns
+// peaks to tracks exactly as the quadratic scan it replaced did, and times
+// both.  Build with "make bench".
+
+#include "Sigmund.h"
+#include "SimdFFT.h"
+
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+static double now()
+{
+  using namespace std::chrono;
+  return duration<double>(steady_clock::now().time_since_epoch()).count();
+}
+
+// sigmund_peaktrack as it was: every peak against every track
+static void peaktrack_scan(int ninpeak, t_peak *inpeakv,
+			   int noutpeak, t_peak *outpeakv)
+{
+  int incnt, outcnt;
+  for (outcnt = 0; outcnt < noutpeak; outcnt++)
+    outpeakv[outcnt].p_tmp = -1;
+  for (incnt = 0; incnt < ninpeak; incnt++)
+    {
+      t_float besterror = 1e20f;
+      int bestcnt = -1;
+      inpeakv[incnt].p_tmp = -1;
+      for (outcnt = 0; outcnt < noutpeak; outcnt++)
+	{
+	  t_float thiserror =
+	    inpeakv[incnt].p_freq - outpeakv[outcnt].p_freq;
+	  if (thiserror < 0)
+	    thiserror = -thiserror;
+	  if (thiserror < besterror)
+	    {
+	      besterror = thiserror;
+	      bestcnt = outcnt;
+	    }
+	}
+      if (outpeakv[bestcnt].p_tmp < 0)
+	{
+	  outpeakv[bestcnt] = inpeakv[incnt];
+	  inpeakv[incnt].p_tmp = 0;
+	  outpeakv[bestcnt].p_tmp = 0;
+	}
+    }
+  for (incnt = 0; incnt < ninpeak; incnt++)
+    if (inpeakv[incnt].p_tmp < 0)
+      {
+	for (outcnt = 0; outcnt < noutpeak; outcnt++)
+	  if (outpeakv[outcnt].p_tmp < 0)
+	    {
+	      outpeakv[outcnt] = inpeakv[incnt];
+	      inpeakv[incnt].p_tmp = 0;
+	      outpeakv[outcnt].p_tmp = 1;
+	      break;
+	    }
+      }
+  for (outcnt = 0; outcnt < noutpeak; outcnt++)
+    if (outpeakv[outcnt].p_tmp == -1)
+      outpeakv[outcnt].p_amp = 0;
+}
+
+static int cmp_amp(const void *p1, const void *p2)
+{
+  t_float a1 = ((const t_peak *)p1)->p_amp, a2 = ((const t_peak *)p2)->p_amp;
+  return (a1 < a2) - (a1 > a2);
+}
+
+// Peak lists for nframes frames of npeak slowly drifting partials, each
+// sometimes missing, plus stray peaks, strongest first as
+// sigmund_getrawpeaks gives them.  Some frames round frequencies to whole
+// hertz so tracks tie.
+static std::vector<t_peak> make_frames(int npeak, int nframes)
+{
+  std::vector<t_peak> frames(npeak * nframes);
+  std::vector<double> partial(npeak);
+  for (int i = 0; i < npeak; i++)
+    partial[i] = 50.0 + 15000.0 * rand() / RAND_MAX;
+  for (int fr = 0; fr < nframes; fr++)
+    {
+      t_peak *pk = &frames[fr * npeak];
+      for (int i = 0; i < npeak; i++)
+	{
+	  partial[i] *= 1.0 + 0.002 * (double(rand()) / RAND_MAX - 0.5);
+	  double f = (rand() % 10) ? partial[i]
+	    : 50.0 + 15000.0 * rand() / RAND_MAX;
+	  if (fr % 7 == 3)
+	    f = floor(f);
+	  memset(&pk[i], 0, sizeof(pk[i]));
+	  pk[i].p_freq = f;
+	  pk[i].p_amp = float(rand()) / RAND_MAX;
+	  pk[i].p_ampreal = pk[i].p_amp;
+	}
+      qsort(pk, npeak, sizeof(t_peak), cmp_amp);
+    }
+  return frames;
+}
+
+static void bench_tracks(int reps)
+{
+  printf("\n%6s %8s %10s %10s %8s\n", "npeak", "same", "scan us",
+	 "sorted us", "speedup");
+  const int npeaks[] = { 20, 100, 500 };
+  for (int npeak : npeaks)
+    {
+      const int nframes = 64;
+      srand(npeak);
+      std::vector<t_peak> frames = make_frames(npeak, nframes);
+      std::vector<t_peak> in(npeak), a(npeak), b(npeak);
+      t_sigmund_work *w = sigmund_work_new(NPOINTS_MIN, npeak);
+
+      // assignments, frame by frame, from empty tracks
+      bool same = true;
+      for (int fr = 0; fr < nframes; fr++)
+	{
+	  // peak counts vary from frame to frame as they do in use
+	  int nin = npeak - (fr % 5) * npeak / 8;
+	  memcpy(&in[0], &frames[fr * npeak], sizeof(t_peak) * nin);
+	  peaktrack_scan(nin, &in[0], npeak, &a[0]);
+	  memcpy(&in[0], &frames[fr * npeak], sizeof(t_peak) * nin);
+	  sigmund_peaktrack(w, nin, &in[0], npeak, &b[0], 0);
+	  same = same && !memcmp(&a[0], &b[0], sizeof(t_peak) * npeak);
+	}
+
+      // speed: scaled so each size does roughly the same amount of work
+      const int count = reps * 20 / npeak + 1;
+      double t0 = now();
+      for (int r = 0; r < count; r++)
+	for (int fr = 0; fr < nframes; fr++)
+	  {
+	    memcpy(&in[0], &frames[fr * npeak], sizeof(t_peak) * npeak);
+	    peaktrack_scan(npeak, &in[0], npeak, &a[0]);
+	  }
+      double t1 = now();
+      for (int r = 0; r < count; r++)
+	for (int fr = 0; fr < nframes; fr++)
+	  {
+	    memcpy(&in[0], &frames[fr * npeak], sizeof(t_peak) * npeak);
+	    sigmund_peaktrack(w, npeak, &in[0], npeak, &b[0], 0);
+	  }
+      double t2 = now();
+      sigmund_work_free(w);
+
+      const double us_scan = (t1 - t0) * 1e6 / (count * nframes);
+      const double us_sorted = (t2 - t1) * 1e6 / (count * nframes);
+      printf("%6d %8s %10.2f %10.2f %7.2fx\n", npeak, same ? "yes" : "NO",
+	     us_scan, us_sorted, us_scan / us_sorted);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+  const int reps = (argc > 1) ? atoi(argv[1]) : 2000;
+  const int npeak = (argc > 2) ? atoi(argv[2]) : NPEAK_DEF;
+  const t_float srate = 44100;
+
+  printf("%6s %10s %10s %9s %8s %12s\n", "npts", "spec err", "mayer us",
+	 "Simd us", "speedup", "analyses/s");
+
+  for (int npts = NPOINTS_MIN; npts <= 8192; npts *= 2)
+    {
+      const int n = 2 * npts;
+      std::shared_ptr<const SimdFFT> simd = SimdFFT::plan(n);
+      std::vector<float> in(npts), a(n), b(n), work(simd->worksize());
+      srand(npts);
+      for (int i = 0; i < npts; i++)
+	{
+	  float x = 0;
+	  for (int h = 1; h <= 10; h++)
+	    x += sin(2 * M_PI * 196.0 * h * i / srate) / h;
+	  in[i] = x + 0.05f * (float(rand()) / RAND_MAX - 0.5f);
+	}
+
+      // accuracy, relative to the largest bin
+      memcpy(&a[0], &in[0], sizeof(float) * npts);
+      memset(&a[npts], 0, sizeof(float) * npts);
+      mayer_realfft(n, &a[0]);
+      memcpy(&b[0], &a[0], sizeof(float) * npts);
+      memset(&b[npts], 0, sizeof(float) * npts);
+      memcpy(&b[0], &in[0], sizeof(float) * npts);
+      simd->r2c(&b[0], &b[0], &work[0]);
+      double peak = 0.0, specerr = 0.0;
+      for (int k = 1; k < npts; k++)
+	{
+	  double re = a[k], im = a[n - k];
+	  peak = fmax(peak, fmax(fabs(re), fabs(im)));
+	  specerr = fmax(specerr, fmax(fabs(re - b[2 * k] * n),
+				       fabs(im - b[2 * k + 1] * n)));
+	}
+      specerr /= peak;
+
+      // speed: scaled so each size does roughly the same amount of work
+      const int count = reps * 1024 / npts + 1;
+      double t0 = now();
+      for (int r = 0; r < count; r++)
+	{
+	  memcpy(&a[0], &in[0], sizeof(float) * npts);
+	  memset(&a[npts], 0, sizeof(float) * npts);
+	  mayer_realfft(n, &a[0]);
+	}
+      double t1 = now();
+      for (int r = 0; r < count; r++)
+	{
+	  memcpy(&b[0], &in[0], sizeof(float) * npts);
+	  memset(&b[npts], 0, sizeof(float) * npts);
+	  simd->r2c(&b[0], &b[0], &work[0]);
+	}
+      double t2 = now();
+
+      t_sigmund_work *w = sigmund_work_new(npts, npeak);
+      std::vector<t_peak> peakv(npeak);
+      int nfound;
+      t_float power, freq;
+      double t3 = now();
+      for (int r = 0; r < count; r++)
+	{
+	  sigmund_getrawpeaks(w, npts, &in[0], npeak, &peakv[0], &nfound,
+			      &power, srate, 0, 1000000);
+	  sigmund_getpitch(w, nfound, &peakv[0], &freq, npts, srate, 6, 0.5, 0);
+	}
+      double t4 = now();
+      sigmund_work_free(w);
+
+      const double us_mayer = (t1 - t0) * 1e6 / count;
+      const double us_simd = (t2 - t1) * 1e6 / count;
+      printf("%6d %10.3g %10.2f %9.2f %7.2fx %12.0f\n", npts, specerr,
+	     us_mayer, us_simd, us_mayer / us_simd, count / (t4 - t3));
+    }
+  bench_tracks(reps);
+  return 0;
+}
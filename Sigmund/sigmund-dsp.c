@@ -7,12 +7,6 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#ifdef _MSC_VER
-#include <malloc.h>
-#define alloca _alloca
-#else
-#include <alloca.h>
-#endif
 
 int sigmund_ilog2(int n)
 {
@@ -81,9 +75,9 @@ t_float sigmund_powtodb(t_float f)
   }
   
   void sigmund_tweak(int npts, t_float *ftreal, t_float *ftimag,
-			    int npeak, t_peak *peaks, t_float fperbin, int loud)
+			    int npeak, t_peak *peaks, t_float fperbin, int loud,
+			    t_peak **peakptrs)
   {
-    t_peak **peakptrs = (t_peak **)alloca(sizeof (*peakptrs) * (npeak+1));
     t_peak negpeak;
     int peaki, j, k;
     t_float ampreal[3], ampimag[3];
@@ -172,28 +166,102 @@ t_float sigmund_powtodb(t_float f)
       }
   }
   
-  void sigmund_remask(int maxbin, int bestindex, t_float powmask, 
-			     t_float maxpower, t_float *maskbuf)
+#define PEAKMASKFACTOR 1.
+#define PEAKTHRESHFACTOR 0.6
+  
+  /* The mask a peak at <bestindex> puts on <bin>, exactly as the old
+     sigmund_remask() stored it in a mask buffer.  Rather than writing a
+     mask over ~maxbin bins per peak found, we evaluate it on demand for the
+     few candidate bins we actually look at. */
+  static int sigmund_masked(int bin, t_float pow1, int npicked,
+			    int *pickedbin, t_float *pickedpower)
   {
-    int bin;
-    int bin1 = (bestindex > 52 ? bestindex-50:2);
-    int bin2 = (maxbin < bestindex + 50 ? bestindex + 50 : maxbin);
-    for (bin = bin1; bin < bin2; bin++)
+    int i;
+    for (i = 0; i < npicked; i++)
       {
+        int bestindex = pickedbin[i];
+        t_float maxpower = pickedpower[i];
+        t_float powmask = maxpower * PEAKMASKFACTOR;
         t_float bindiff = bin - bestindex;
         t_float mymask;
+        if (bin < (bestindex > 52 ? bestindex-50:2))
+	  continue;
         mymask = powmask/ (1. + bindiff * bindiff * bindiff * bindiff);
         if (bindiff < 2 && bindiff > -2)
 	  mymask = 2*maxpower;
-        if (mymask > maskbuf[bin])
-	  maskbuf[bin] = mymask;
-      } 
+        if (!(pow1 > mymask))
+	  return (1);
+      }
+    return (0);
+  }
+
+  /* candidate bins form a heap ordered by power, then by bin number, so
+     they come out in the order the old linear scan would have chosen them */
+  static int sigmund_candbefore(const t_float *powbuf, int a, int b)
+  {
+    return (powbuf[a] > powbuf[b] || (powbuf[a] == powbuf[b] && a < b));
+  }
+
+  static void sigmund_candsift(const t_float *powbuf, int *cand, int ncand,
+			       int i)
+  {
+    for (;;)
+      {
+        int best = i, l = 2*i+1, r = l+1, tmp;
+        if (l < ncand && sigmund_candbefore(powbuf, cand[l], cand[best]))
+	  best = l;
+        if (r < ncand && sigmund_candbefore(powbuf, cand[r], cand[best]))
+	  best = r;
+        if (best == i)
+	  return;
+        tmp = cand[i], cand[i] = cand[best], cand[best] = tmp;
+        i = best;
+      }
   }
   
-#define PEAKMASKFACTOR 1.
-#define PEAKTHRESHFACTOR 0.6
-  
-  void sigmund_getrawpeaks(int npts, t_float *insamps,
+  /********************* scratch space for the analysis *****************/
+
+  t_sigmund_work *sigmund_work_new(int npts, int npeak)
+  {
+    t_sigmund_work *w = (t_sigmund_work *)calloc(1, sizeof(*w));
+    int npit = 48 * sigmund_ilog2(npts), j;
+    w->w_npts = npts;
+    w->w_npeak = npeak;
+    w->w_fft = sigmund_fft_new(2*npts);
+    /* the upper half of the input stays zero */
+    w->w_fftin = (t_float *)calloc(2*npts, sizeof(t_float));
+    w->w_fftwork = (t_float *)malloc(sizeof(t_float) *
+				     sigmund_fft_worksize(w->w_fft));
+    w->w_bigbuf = (t_float *)malloc(sizeof(t_float) * (2*NEGBINS + 5*npts));
+    w->w_cand = (int *)malloc(sizeof(int) * npts);
+    w->w_pickedbin = (int *)malloc(sizeof(int) * npeak);
+    w->w_pickedpower = (t_float *)malloc(sizeof(t_float) * npeak);
+    w->w_peakptrs = (t_peak **)malloc(sizeof(t_peak *) * (npeak+1));
+    w->w_trackptrs = (t_peak **)malloc(sizeof(t_peak *) * npeak);
+    w->w_weights = (t_float *)malloc(sizeof(t_float) * npit);
+    for (j = 0; j < SUBHARMONICS; j++)
+      w->w_suboffset[j] = (48./LOG2) * log(j + 1.);
+    return (w);
+  }
+
+  void sigmund_work_free(t_sigmund_work *w)
+  {
+    if (!w)
+      return;
+    sigmund_fft_free(w->w_fft);
+    free(w->w_fftin);
+    free(w->w_fftwork);
+    free(w->w_bigbuf);
+    free(w->w_cand);
+    free(w->w_pickedbin);
+    free(w->w_pickedpower);
+    free(w->w_peakptrs);
+    free(w->w_trackptrs);
+    free(w->w_weights);
+    free(w);
+  }
+
+  void sigmund_getrawpeaks(t_sigmund_work *w, int npts, t_float *insamps,
 				  int npeak, t_peak *peakv, int *nfound, t_float *power, t_float srate, int loud,
 				  t_float hifreq)
   {
@@ -202,28 +270,26 @@ t_float sigmund_powtodb(t_float f)
     int npts2 = 2*npts, i, bin;
     int peakcount = 0;
     t_float *fp1, *fp2;
-    t_float *rawreal, *rawimag, *maskbuf, *powbuf;
-    t_float *bigbuf = (t_float*)alloca(sizeof (t_float ) * (2*NEGBINS + 6*npts));
+    t_float *rawreal, *rawimag, *powbuf;
+    t_float *bigbuf = w->w_bigbuf;
+    int *cand = w->w_cand, ncand = 0, *pickedbin = w->w_pickedbin;
+    t_float *pickedpower = w->w_pickedpower;
     int maxbin = hifreq/fperbin;
     if (maxbin > npts - NEGBINS)
       maxbin = npts - NEGBINS;
     /* if (loud) post("tweak %d", tweak); */
-    maskbuf = bigbuf + npts2;
-    powbuf = maskbuf + npts;
+    powbuf = bigbuf + npts2;
     rawreal = powbuf + npts+NEGBINS;
     rawimag = rawreal+npts+NEGBINS;
-    for (i = 0; i < npts; i++)
-      maskbuf[i] = 0;
-    
-    for (i = 0; i < npts; i++)
-      bigbuf[i] = insamps[i];
-    for (i = npts; i < 2*npts; i++)
-      bigbuf[i] = 0;
-    mayer_realfft(npts2, bigbuf);
-    for (i = 0; i < npts; i++)
-      rawreal[i] = bigbuf[i];
+    /* the FFT comes back packed as re(0), re(npts), re(1), im(1), ... and
+       scaled by 1/npts2; unpack and undo the scaling */
+    memcpy(w->w_fftin, insamps, sizeof(t_float) * npts);
+    sigmund_fft_r2c(w->w_fft, w->w_fftin, bigbuf, w->w_fftwork);
+    rawreal[0] = bigbuf[0] * npts2;
+    for (i = 1; i < npts; i++)
+      rawreal[i] = bigbuf[2*i] * npts2;
     for (i = 1; i < npts-1; i++)
-      rawimag[i] = bigbuf[npts2-i];
+      rawimag[i] = bigbuf[2*i+1] * npts2;
     rawreal[-1] = rawreal[1];
     rawreal[-2] = rawreal[2];
     rawreal[-3] = rawreal[3];
@@ -243,22 +309,36 @@ t_float sigmund_powtodb(t_float f)
     powbuf[maxbin] = powbuf[maxbin+1] = 0;
     *power = 0.5 * totalpower *oneovern * oneovern;
 #endif
+    /* A bin can only ever be chosen as a peak if it stands out from its
+       neighbors two bins away; collect those once.  Each peak is then the
+       strongest remaining candidate that isn't masked by the peaks already
+       found.  Masks only grow, so a candidate found masked is dropped. */
+    for (bin = 2; bin < maxbin; bin++)
+      {
+        t_float pow1 = powbuf[bin];
+        t_float thresh = PEAKTHRESHFACTOR * (powbuf[bin-2]+powbuf[bin+2]);
+        if (pow1 > 0 && pow1 > thresh)
+	  cand[ncand++] = bin;
+      }
+    for (i = ncand/2 - 1; i >= 0; i--)
+      sigmund_candsift(powbuf, cand, ncand, i);
     for (peakcount = 0; peakcount < npeak; peakcount++)
       {
-        t_float pow1, maxpower = 0, windreal, windimag, windpower,
+        t_float maxpower = 0, windreal, windimag, windpower,
 	  detune, pidetune, sinpidetune, cospidetune, ampcorrect, ampout,
-	  ampoutreal, ampoutimag, freqout, powmask;
+	  ampoutreal, ampoutimag, freqout;
         int bestindex = -1;
 	
-        for (bin = 2, fp1 = rawreal+2, fp2 = rawimag+2;
-	     bin < maxbin; bin++, fp1++, fp2++)
+        while (ncand > 0)
 	  {
-            pow1 = powbuf[bin];
-            if (pow1 > maxpower && pow1 > maskbuf[bin])
+            bin = cand[0];
+            cand[0] = cand[--ncand];
+            sigmund_candsift(powbuf, cand, ncand, 0);
+            if (!sigmund_masked(bin, powbuf[bin], peakcount,
+				pickedbin, pickedpower))
 	      {
-                t_float thresh = PEAKTHRESHFACTOR * (powbuf[bin-2]+powbuf[bin+2]);
-                if (pow1 > thresh)
-		  maxpower = pow1, bestindex = bin;
+                maxpower = powbuf[bin], bestindex = bin;
+                break;
 	      }
 	  }
 	
@@ -266,11 +346,8 @@ t_float sigmund_powtodb(t_float f)
 	  break;
         fp1 = rawreal+bestindex;
         fp2 = rawimag+bestindex;
-        powmask = maxpower * PEAKMASKFACTOR;
-        /* if (loud > 2)
-	   post("maxpower %f, powmask %f, param1 %f",
-	   maxpower, powmask, param1); */
-        sigmund_remask(maxbin, bestindex, powmask, maxpower, maskbuf);
+        pickedbin[peakcount] = bestindex;
+        pickedpower[peakcount] = maxpower;
         
         /* if (loud > 1)
 	   post("best index %d, total power %f", bestindex, totalpower); */
@@ -306,8 +383,10 @@ t_float sigmund_powtodb(t_float f)
         peakv[peakcount].p_ampreal = oneovern * ampoutreal;
         peakv[peakcount].p_ampimag = oneovern * ampoutimag;
       }
-    sigmund_tweak(npts, rawreal, rawimag, peakcount, peakv, fperbin, loud);
-    sigmund_tweak(npts, rawreal, rawimag, peakcount, peakv, fperbin, loud);
+    sigmund_tweak(npts, rawreal, rawimag, peakcount, peakv, fperbin, loud,
+		  w->w_peakptrs);
+    sigmund_tweak(npts, rawreal, rawimag, peakcount, peakv, fperbin, loud,
+		  w->w_peakptrs);
     for (i = 0; i < peakcount; i++)
       {
         peakv[i].p_pit = sigmund_ftom(peakv[i].p_freq);
@@ -320,16 +399,15 @@ t_float sigmund_powtodb(t_float f)
   
 #define PITCHNPEAK 12
 #define HALFTONEINC 0.059
-#define SUBHARMONICS 16
 #define DBPERHALFTONE 0.0
   
-void sigmund_getpitch(int npeak, t_peak *peakv, t_float *freqp,
+void sigmund_getpitch(t_sigmund_work *w, int npeak, t_peak *peakv, t_float *freqp,
 		      t_float npts, t_float srate, t_float nharmonics, t_float amppower, int loud)
 {
   t_float fperbin = 0.5 * srate / npts;
   int npit = 48 * sigmund_ilog2(npts), i, j, k, nsalient;
   t_float bestbin, bestweight, sumamp, sumweight, sumfreq, freq;
-  t_float *weights =  (t_float *)alloca(sizeof(t_float) * npit);
+  t_float *weights = w->w_weights;
   t_peak *bigpeaks[PITCHNPEAK];
   if (npeak < 1)
     {
@@ -369,8 +447,7 @@ void sigmund_getpitch(int npeak, t_peak *peakv, t_float *freqp,
       /* post("index %f, uncertainty %f", weightindex, pitchuncertainty); */
       for (j = 0; j < SUBHARMONICS; j++)
 	{
-	  t_float subindex = weightindex -
-	    (48./LOG2) * log(j + 1.);
+	  t_float subindex = weightindex - w->w_suboffset[j];
 	  int loindex = subindex - 0.5;
 	  int hiindex = loindex+2;
 	  if (hiindex < 0)
@@ -441,45 +518,140 @@ void sigmund_getpitch(int npeak, t_peak *peakv, t_float *freqp,
 
 /*************** gather peak lists into sinusoidal tracks *************/
 
-void sigmund_peaktrack(int ninpeak, t_peak *inpeakv, 
+/* order tracks by frequency, and equal frequencies by slot */
+static int sigmund_cmp_track(const void *p1, const void *p2)
+{
+  t_peak *t1 = *(t_peak **)p1, *t2 = *(t_peak **)p2;
+  if (t1->p_freq > t2->p_freq)
+    return (1);
+  else if (t1->p_freq < t2->p_freq)
+    return (-1);
+  else return (t1 > t2 ? 1 : (t1 < t2 ? -1 : 0));
+}
+
+/* first position in sorted[0..n) whose frequency is at least freq */
+static int sigmund_track_lower(t_peak **sorted, int n, t_float freq)
+{
+  int lo = 0, hi = n;
+  while (lo < hi)
+    {
+      int mid = (lo + hi) / 2;
+      if (sorted[mid]->p_freq < freq)
+	lo = mid + 1;
+      else hi = mid;
+    }
+  return (lo);
+}
+
+/* first position in sorted[0..n) whose frequency is above freq */
+static int sigmund_track_upper(t_peak **sorted, int n, t_float freq)
+{
+  int lo = 0, hi = n;
+  while (lo < hi)
+    {
+      int mid = (lo + hi) / 2;
+      if (sorted[mid]->p_freq <= freq)
+	lo = mid + 1;
+      else hi = mid;
+    }
+  return (lo);
+}
+
+/* Find the track closest in frequency to freq, and of those equally close,
+   the lowest-numbered one, as a scan over all tracks would.  Tracks of one
+   frequency sit together in sorted[], lowest-numbered first, and distances
+   only grow away from freq, so only the nearest group on either side (or
+   more, when float rounding makes distances tie) needs a look.  Returns
+   the track's position in sorted[]. */
+static int sigmund_track_closest(t_peak **sorted, int n, t_float freq)
+{
+  int hi = sigmund_track_lower(sorted, n, freq), lo, best = -1, pos;
+  t_float besterror = 1e20f, thiserror;
+  /* nearest error on either side */
+  for (pos = hi - 1; pos <= hi; pos++)
+    if (pos >= 0 && pos < n)
+      {
+	thiserror = freq - sorted[pos]->p_freq;
+	if (thiserror < 0)
+	  thiserror = -thiserror;
+	if (thiserror < besterror)
+	  besterror = thiserror;
+      }
+  /* every group at that error, upward... */
+  for (pos = hi; pos < n; )
+    {
+      thiserror = sorted[pos]->p_freq - freq;
+      if (!(thiserror <= besterror))
+	break;
+      if (best < 0 || sorted[pos] < sorted[best])
+	best = pos;
+      if (pos + 1 < n && sorted[pos+1]->p_freq != sorted[pos]->p_freq)
+	pos++;
+      else pos = sigmund_track_upper(sorted, n, sorted[pos]->p_freq);
+    }
+  /* ...and downward */
+  for (lo = hi - 1; lo >= 0; lo = pos - 1)
+    {
+      if (lo > 0 && sorted[lo-1]->p_freq == sorted[lo]->p_freq)
+	pos = sigmund_track_lower(sorted, lo, sorted[lo]->p_freq);
+      else pos = lo;
+      thiserror = freq - sorted[pos]->p_freq;
+      if (!(thiserror <= besterror))
+	break;
+      if (best < 0 || sorted[pos] < sorted[best])
+	best = pos;
+    }
+  return (best);
+}
+
+void sigmund_peaktrack(t_sigmund_work *w, int ninpeak, t_peak *inpeakv, 
 		       int noutpeak, t_peak *outpeakv, int loud)
 {
-  int incnt, outcnt;
+  t_peak **sorted = w->w_trackptrs;
+  int incnt, outcnt, pos;
   for (outcnt = 0; outcnt < noutpeak; outcnt++)
-    outpeakv[outcnt].p_tmp = -1;
+    {
+      outpeakv[outcnt].p_tmp = -1;
+      sorted[outcnt] = &outpeakv[outcnt];
+    }
+  qsort(sorted, noutpeak, sizeof (*sorted), sigmund_cmp_track);
   
   /* first pass. Match each "in" peak with the closest previous
      "out" peak, but no two to the same one. */
   for (incnt = 0; incnt < ninpeak; incnt++)
     {
-      t_float besterror = 1e20f;
-      int bestcnt = -1;
+      t_peak *best;
       inpeakv[incnt].p_tmp = -1;
-      for (outcnt = 0; outcnt < noutpeak; outcnt++)
+      pos = sigmund_track_closest(sorted, noutpeak, inpeakv[incnt].p_freq);
+      if (pos < 0)
+	continue;
+      best = sorted[pos];
+      if (best->p_tmp < 0)
 	{
-	  t_float thiserror =
-	    inpeakv[incnt].p_freq - outpeakv[outcnt].p_freq;
-	  if (thiserror < 0)
-	    thiserror = -thiserror;
-	  if (thiserror < besterror)
+	  *best = inpeakv[incnt];
+	  inpeakv[incnt].p_tmp = 0;
+	  best->p_tmp = 0;
+	  /* the new frequency was closest to the old one, so the track
+	     rarely moves; keep sorted[] in order when it does */
+	  while (pos > 0 && sigmund_cmp_track(&sorted[pos-1], &sorted[pos]) > 0)
 	    {
-	      besterror = thiserror;
-	      bestcnt = outcnt;
+	      sorted[pos] = sorted[pos-1];
+	      sorted[--pos] = best;
+	    }
+	  while (pos < noutpeak-1 &&
+		 sigmund_cmp_track(&sorted[pos], &sorted[pos+1]) > 0)
+	    {
+	      sorted[pos] = sorted[pos+1];
+	      sorted[++pos] = best;
 	    }
-	}
-      if (outpeakv[bestcnt].p_tmp < 0)
-	{
-	  outpeakv[bestcnt] = inpeakv[incnt];
-	  inpeakv[incnt].p_tmp = 0;
-	  outpeakv[bestcnt].p_tmp = 0;
 	}
     }
   /* second pass.  Unmatched "in" peaks assigned to free "out"
      peaks */
-  for (incnt = 0; incnt < ninpeak; incnt++)
+  for (incnt = 0, outcnt = 0; incnt < ninpeak; incnt++)
     if (inpeakv[incnt].p_tmp < 0)
       {
-	for (outcnt = 0; outcnt < noutpeak; outcnt++)
+	for (; outcnt < noutpeak; outcnt++)
 	  if (outpeakv[outcnt].p_tmp < 0)
 	    {
 	      outpeakv[outcnt] = inpeakv[incnt];
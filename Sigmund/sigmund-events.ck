@@ -0,0 +1,67 @@
+// Sigmund results without polling: event() and tracks()
+//
+// Instead of reading peak(i)/amp(i) on a timer, wait on
+// event(), which fires whenever a new analysis is ready,
+// and read every track of that analysis in one call.
+// (sigmund-tracks-test.ck does the same resynthesis by
+// polling.)
+
+// Analyze audio file
+SndBuf obama => Sigmund siggy => blackhole;
+// change this to the path to your audio file
+"../PitchTrack/data/obama.wav" => obama.read;
+0 => obama.pos;
+true => siggy.tracks; // sort sinusoids into tracks
+128 => Std.mtof => siggy.maxfreq; // don't track high freqs
+
+10 => int numTracks;
+
+numTracks => siggy.npeak; // set max number of peaks
+2048 => siggy.npts; // larger analysis window
+
+// resynthesize sound based on sinusoidal tracking
+Envelope freq[numTracks]; // envelopes help smooth results
+Envelope amp[numTracks];
+SinOsc resynth[numTracks];
+for (int i; i<numTracks; i++)
+{
+	resynth[i] => amp[i] => dac;
+	freq[i] => blackhole;
+	10::ms => freq[i].duration; // increase this for portamento
+	10::ms => amp[i].duration;
+}
+
+obama.length() => dur len;
+now + len => time end;
+
+spork ~ updateFreqs();
+
+// filled (and resized) by tracks()
+float trackFreqs[0];
+float trackAmps[0];
+
+while (now < end)
+{
+	// wait for the next analysis, then read all tracks at once;
+	// a track that isn't sounding has amp 0
+	siggy.event() => now;
+	siggy.tracks(trackFreqs, trackAmps);
+	for (int i; i<numTracks; i++)
+	{
+		trackFreqs[i] => freq[i].target;
+		trackAmps[i] => amp[i].target;
+	}
+}
+
+// freq envelope used to set resynth frequencies smoothly
+fun void updateFreqs()
+{
+	while (true)
+	{
+		for (int i; i<numTracks; i++)
+		{
+			freq[i].value() => resynth[i].freq;
+		}
+		ms => now;
+	}
+}
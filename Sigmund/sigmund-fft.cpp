@@ -0,0 +1,28 @@
+// C entry points to SimdFFT for sigmund-dsp.c.
+
+#include "Sigmund.h"
+#include "SimdFFT.h"
+
+extern "C"
+{
+  void *sigmund_fft_new(int n)
+  {
+    return new std::shared_ptr<const SimdFFT>(SimdFFT::plan(n));
+  }
+
+  void sigmund_fft_free(void *fft)
+  {
+    delete (std::shared_ptr<const SimdFFT> *)fft;
+  }
+
+  int sigmund_fft_worksize(void *fft)
+  {
+    return (*(std::shared_ptr<const SimdFFT> *)fft)->worksize();
+  }
+
+  void sigmund_fft_r2c(void *fft, const t_float *in, t_float *out,
+		       t_float *work)
+  {
+    (*(std::shared_ptr<const SimdFFT> *)fft)->r2c(in, out, work);
+  }
+}
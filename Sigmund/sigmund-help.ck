@@ -12,6 +12,14 @@
 //     about 2 * samplerate / npts
 //     default: 1024
 //
+// hop (int): number of samples between analyses.
+//     Each analysis still looks at the last npts
+//     samples, so a hop below npts gives overlapping
+//     windows and more frequent updates without
+//     losing frequency resolution. CPU cost grows
+//     as npts / hop. 0 means npts (no overlap).
+//     default: 0
+//
 // npeak (int): maximum number of sinusoidal peaks
 //     to look for. The computation time is
 //     quadratic in the number of peaks actually
@@ -45,22 +53,54 @@
 //     sorted in order of amplitude or organized into
 //     tracks
 //
+// peaks(float[] freqs, float[] amps): fill both
+//     arrays with every peak found, strongest first;
+//     returns the number of peaks
+//
+// tracks(float[] freqs, float[] amps): fill both
+//     arrays with every track (npeak of them, amp 0
+//     when not sounding); returns 0 unless tracks
+//     is on
+//
+// event() (read-only): an Event broadcast whenever
+//     new results are ready, to wait on instead of
+//     polling: siggy.event() => now; see
+//     sigmund-events.ck
+//
 // clear(): clear buffers and reset
 //
+// threaded (0/1): run the analysis on a worker
+//     thread instead of inside the tick where it
+//     is due, which removes the CPU spike
+//     at every analysis. Results arrive up to one
+//     hop later.
+//     default: 0
+//
+// age() (read-only): how old the current results
+//     are, i.e. the time since the end of the window
+//     they were computed from. freq, env, peak and
+//     amp always come from the same window.
+//
 // param1, param2, param3 (float): mysterious settings...
+//
+// SigmundOut is a Sigmund with three output channels:
+// the input, freq (Hz) and env (dB) as signals. See
+// sigmundout-help.ck.
 
 // must connect to blackhole to perform DSP
 TriOsc foo => Sigmund siggy => blackhole;
 
 4096 => siggy.npts;
+512 => siggy.hop;
 20 => siggy.npeak;
 1000 => siggy.maxfreq;
 25 => siggy.minpower;
+1 => siggy.threaded;
 
 while (true)
 {
 	Math.random2f(5,300) => foo.freq;
 	Math.random2f(0,1) => foo.gain;
 	second => now;
-	<<< "Real frequency:",foo.freq(),"real gain:",foo.gain(),"Sigmund found this:",siggy.freq(), "power:", siggy.env() >>>;
+	<<< "Real frequency:",foo.freq(),"real gain:",foo.gain(),"Sigmund found this:",siggy.freq(), "power:", siggy.env(), "age (ms):", siggy.age() / ms >>>;
 }
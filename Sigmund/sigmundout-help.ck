@@ -0,0 +1,26 @@
+// SigmundOut: Sigmund's pitch and envelope as signals
+//
+// Output channel 0 passes the input through, channel 1
+// is the pitch (freq) in Hz and channel 2 the envelope
+// (env) in dB. Each holds its value until the next
+// analysis, so UGens can follow them without a polling
+// shred.
+
+// a wandering source to follow
+TriOsc src => SigmundOut siggy => blackhole;
+0.5 => src.gain;
+1024 => siggy.npts;
+256 => siggy.hop; // update four times per window
+
+// a sine that follows the pitch: with sync 0, SinOsc
+// takes its frequency from its input
+siggy.chan(1) => SinOsc follower => dac;
+0 => follower.sync;
+0.2 => follower.gain;
+
+while (true)
+{
+	Math.random2f(100, 600) => src.freq;
+	500::ms => now;
+	<<< "source:", src.freq(), "follower:", siggy.freq() >>>;
+}
@@ -27,6 +27,7 @@ SpectEQ::SpectEQ()
 // ----------------------------------------------------------------- ~SpectEQ --
 SpectEQ::~SpectEQ()
 {
+	stop_processing();
 	// We don't own eq table.
 }
 
@@ -35,9 +36,10 @@ SpectEQ::~SpectEQ()
 // Invoke base init, and perform any initialization specific to this subclass.
 // Return 0 if okay, -1 if not.
 
-int SpectEQ::init(int fftlen, int windowlen, int overlap, float srate)
+int SpectEQ::init(int fftlen, int windowlen, int overlap, float srate,
+	int nchans)
 {
-	return SpectacleBase::init(fftlen, windowlen, overlap, srate);
+	return SpectacleBase::init(fftlen, windowlen, overlap, srate, nchans);
 }
 
 
@@ -51,6 +53,7 @@ void SpectEQ::set_srate(float srate)
 // -------------------------------------------------------------- set_eqtable --
 void SpectEQ::set_eqtable(float *table, int len)
 {
+	sync();
 	if (len == 0) {	// no table set yet by caller
 		_eqconst = 0.0;
 		_eqtable = NULL;
@@ -80,6 +83,7 @@ void SpectEQ::set_eqtable(float *table, int len)
 
 void SpectEQ::set_binmap_table(int *table, int len)
 {
+	sync();
 	if (len != _control_table_size)
 		_binmaptable = NULL;
 	else
@@ -97,9 +101,11 @@ void SpectEQ::modify_analysis(bool)
 	// NB: check EQ table size, rather than table pointer, to determine whether
 	// we should use an EQ constant. Otherwise, there's a danger we could read
 	// a null EQ table pointer, if set_eqtable called by non-perf thread.
+	const int fftlen = get_fftlen();
+	const int nchans = get_nchans();
 	if (_control_table_size == 0) {		// constant gain across bins
 		const float eq = _ampdb(_eqconst);
-		const int len = get_fftlen();
+		const int len = fftlen * nchans;
 		for (int i = 0; i < len; i++)
 			_fft_buf[i] *= eq;
 	}
@@ -107,11 +113,15 @@ void SpectEQ::modify_analysis(bool)
 		for (int i = 0; i < _half_fftlen; i++) {
 			const float eq = _ampdb(_eqtable[_bin_groups[i]]);
 			const int index = i << 1;
-			_fft_buf[index] *= eq;			// real
-			_fft_buf[index + 1] *= eq;		// imag
+			for (int c = 0; c < nchans; c++) {
+				float *bin = _fft_buf + c * fftlen + index;
+				bin[0] *= eq;			// real
+				bin[1] *= eq;			// imag
+			}
 		}
 	}
-	_fft_buf[1] = 0.0f;	// clear Nyquist real value
+	for (int c = 0; c < nchans; c++)
+		_fft_buf[c * fftlen + 1] = 0.0f;	// clear Nyquist real value
 }
 
 
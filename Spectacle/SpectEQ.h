@@ -20,7 +20,8 @@ class SpectEQ : public SpectacleBase {
 public:
 	SpectEQ();
 	virtual ~SpectEQ();
-	int init(int fftlen, int windowlen, int overlap, float srate);
+	int init(int fftlen, int windowlen, int overlap, float srate,
+		int nchans = 1);
 	void set_srate(float srate);
 	void set_eqtable(float *table, int len);
 	void set_binmap_table(int *table, int len);
@@ -17,6 +17,12 @@
 #include "Spectacle-dsp.h"
 #include <float.h>
 #include <cstddef>
+#include <string.h>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+	#include <xmmintrin.h>
+	#define SPECTACLE_SSE
+#endif
 
 //#define DEBUG
 //#define PRINT_DELTIMES
@@ -34,10 +40,12 @@ const float kMaxDelayTime = 20.0f;
 
 // ---------------------------------------------------------------- Spectacle_dsp --
 Spectacle_dsp::Spectacle_dsp()
-	: _maxdelsamps(0L), _maxdeltime(0.0f), _eqconst(0.0f), _deltimeconst(0.0f),
-	  _feedbackconst(0.0f), _delay_minfreq(-FLT_MAX), _delay_maxfreq(-FLT_MAX),
-	  _eqtable(NULL), _deltimetable(NULL), _feedbacktable(NULL),
-	  _delay_bin_groups(NULL), _delay_binmap_table(NULL), _delay_table_size(0)
+	: _maxdelsamps(0L), _maxdeltime(0.0f),
+	  _delay_minfreq(-FLT_MAX), _delay_maxfreq(-FLT_MAX),
+	  _delay_bin_groups(NULL), _delay_binmap_table(NULL), _delay_table_size(0),
+	  _tables_back(0), _tables_front(1), _tables_middle(2),
+	  _delay_matrix(NULL), _delay_rows(0L), _delay_rowlen(0L), _delay_inrow(0L),
+	  _bin_eq(NULL), _bin_feedback(NULL), _bin_dry(NULL), _bin_lag(NULL)
 {
 #ifdef ANTI_DENORM
 	_antidenorm_offset = kAntiDenormConstant;
@@ -48,15 +56,13 @@ Spectacle_dsp::Spectacle_dsp()
 // --------------------------------------------------------------- ~Spectacle_dsp --
 Spectacle_dsp::~Spectacle_dsp()
 {
-	// NB: we don't own the EQ, delay time, and feedback tables.
-
-	for (int i = 0; i < _half_fftlen; i++) {
-		if (_real_delay[i])
-			delete _real_delay[i];
-		if (_imag_delay[i])
-			delete _imag_delay[i];
-	}
+	stop_processing();
 
+	delete [] _delay_matrix;
+	delete [] _bin_eq;
+	delete [] _bin_feedback;
+	delete [] _bin_dry;
+	delete [] _bin_lag;
 	delete [] _delay_bin_groups;
 }
 
@@ -66,49 +72,62 @@ Spectacle_dsp::~Spectacle_dsp()
 // Return 0 if okay, -1 if not.
 
 int Spectacle_dsp::init(int fftlen, int windowlen, int overlap, float srate,
-	float maxdeltime)
+	float maxdeltime, int nchans)
 {
-	if (SpectacleBase::init(fftlen, windowlen, overlap, srate) != 0)
+	if (SpectacleBase::init(fftlen, windowlen, overlap, srate, nchans) != 0)
 		return -1;
 
 	// Compute maximum delay lag and create delay lines for FFT real and
 	// imaginary values.  Remember that these delays function at the decimation
 	// rate, not at the audio rate, so the memory footprint is not as large
-	// as you would expect -- about 44100 samples per second at fftlen=1024,
-	// overlap=2 and SR=44100.
+	// as you would expect -- about 44100 samples per second per channel at
+	// fftlen=1024, overlap=2 and SR=44100.
 
 	_maxdeltime = maxdeltime;
 	_maxdelsamps = long(maxdeltime * get_srate() / float(_decimation) + 0.5);
 
-	for (int i = 0; i < _half_fftlen; i++) {
-		Odelay *delay = new Odelay(_maxdelsamps);
-		if (delay == NULL)
-			goto bad_alloc;
-		_real_delay[i] = delay;
-		delay = new Odelay(_maxdelsamps);
-		if (delay == NULL)
-			goto bad_alloc;
-		_imag_delay[i] = delay;
-	}
-
+	// init may be called again to change fftlen, overlap or channels
+	const int nvals = _half_fftlen * 2;
+	delete [] _bin_eq;
+	delete [] _bin_feedback;
+	delete [] _bin_dry;
+	delete [] _bin_lag;
+	delete [] _delay_bin_groups;
+	_bin_eq = new float [nvals];
+	_bin_feedback = new float [nvals];
+	_bin_dry = new float [nvals * get_nchans()];
+	_bin_lag = new long [_half_fftlen];
 	_delay_bin_groups = new int [_half_fftlen];
 
+	alloc_delay_matrix();
+
+	// force the bin groups to be recomputed for the new fftlen
+	_delay_minfreq = _delay_maxfreq = -FLT_MAX;
 	set_delay_freqrange(0.0f, 0.0f);
 
 	return 0;
-bad_alloc:
-	//error("%s: Not enough memory for delay lines.", instname());
-	return -1;
+}
+
+
+// -------------------------------------------------------- alloc_delay_matrix --
+// (Re)allocate the delay matrix for _maxdelsamps frames, cleared.
+void Spectacle_dsp::alloc_delay_matrix()
+{
+	delete [] _delay_matrix;
+	_delay_rows = _maxdelsamps > 0 ? _maxdelsamps : 1;
+	_delay_rowlen = long(_half_fftlen * 2) * get_nchans();
+	_delay_matrix = new float [_delay_rows * _delay_rowlen];
+	memset(_delay_matrix, 0, sizeof(float) * _delay_rows * _delay_rowlen);
+	_delay_inrow = 0;
 }
 
 
 // -------------------------------------------------------------------- clear --
 void Spectacle_dsp::clear()
 {
-	for (int i = 0; i < _half_fftlen; i++) {
-		_real_delay[i]->clear();
-		_imag_delay[i]->clear();
-	}
+	sync();
+	if (_delay_matrix)
+		memset(_delay_matrix, 0, sizeof(float) * _delay_rows * _delay_rowlen);
 	SpectacleBase::clear();
 }
 
@@ -116,6 +135,7 @@ void Spectacle_dsp::clear()
 // ---------------------------------------------------------------- set_srate --
 void Spectacle_dsp::set_srate(float srate)
 {
+	sync();
 	if (_delay_maxfreq == _nyquist)
 		_delay_maxfreq = 0.0f;
 	SpectacleBase::set_srate(srate);
@@ -130,90 +150,156 @@ void Spectacle_dsp::set_srate(float srate)
 // ----------------------------------------------------------- set_maxdeltime --
 // Reset delay lines to accommodate a maximum delay of <time> seconds at the
 // current sampling rate.  Assumes that caller constrains all delay times to
-// fit this new maximum.
+// fit this new maximum.  The delay lines are cleared.
 void Spectacle_dsp::set_maxdeltime(float time)
 {
+	sync();
 	_maxdeltime = time;
-	_maxdelsamps = long(time * get_srate() / float(_decimation) + 0.5);
-	for (int i = 0; i < _half_fftlen; i++) {
-		_real_delay[i]->resize(_maxdelsamps);
-		_imag_delay[i]->resize(_maxdelsamps);
+	const long maxdelsamps = long(time * get_srate() / float(_decimation) + 0.5);
+	if (maxdelsamps != _maxdelsamps || _delay_matrix == NULL) {
+		_maxdelsamps = maxdelsamps;
+		if (_half_fftlen > 0)
+			alloc_delay_matrix();
 	}
 }
 
 
 // -------------------------------------------------------------- set_eqtable --
-void Spectacle_dsp::set_eqtable(float *table, int len)
+void Spectacle_dsp::set_eqtable(const float *table, int len)
 {
+	stage_eqtable(table, len);
+	publish_tables();
+}
+
+
+// ------------------------------------------------------------- set_deltable --
+void Spectacle_dsp::set_deltable(const float *table, int len)
+{
+	stage_deltable(table, len);
+	publish_tables();
+}
+
+
+// ------------------------------------------------------------ set_feedtable --
+void Spectacle_dsp::set_feedtable(const float *table, int len)
+{
+	stage_feedtable(table, len);
+	publish_tables();
+}
+
+
+// ------------------------------------------------------------ stage_eqtable --
+void Spectacle_dsp::stage_eqtable(const float *table, int len)
+{
+	SpectacleTables &t = _staged_tables;
 	if (len == 0) {	// no table set yet by caller
-		_eqconst = 0.0;
-		_eqtable = NULL;
-		_control_table_size = 0;
+		t.eqconst = 0.0;
+		t.eq.clear();
 	}
 	else if (len == 1) {
-		_eqconst = table[0];
-		_eqtable = NULL;
-		_control_table_size = 0;
+		t.eqconst = table[0];
+		t.eq.clear();
 	}
 	else {
-		_eqconst = 0.0;
-		_eqtable = table;
-		if (len != _control_table_size) {
-			_control_table_size = len;
+		t.eqconst = 0.0;
+		t.eq.assign(table, table + len);
+	}
+	const int size = int(t.eq.size());
+	if (size != _control_table_size) {
+		sync();
+		_control_table_size = size;
+		if (size > 0)
 			update_bin_groups(_bin_groups, NULL, get_minfreq(), get_maxfreq(),
-		                                                 _control_table_size);
-		}
+			                                             _control_table_size);
+		publish_tables();
 	}
 }
 
 
-// ------------------------------------------------------------- set_deltable --
-void Spectacle_dsp::set_deltable(float *table, int len)
+// ----------------------------------------------------------- stage_deltable --
+void Spectacle_dsp::stage_deltable(const float *table, int len)
 {
+	SpectacleTables &t = _staged_tables;
 	if (len == 0) {	// no table set yet by caller
-		_deltimeconst = 0.0;
-		_deltimetable = NULL;
+		t.deltimeconst = 0.0;
+		t.deltime.clear();
 	}
 	else if (len == 1) {
-		_deltimeconst = table[0];
-		_deltimetable = NULL;
+		t.deltimeconst = table[0];
+		t.deltime.clear();
 		// NB: don't set _delay_table_size to zero
 	}
 	else {
-		_deltimeconst = 0.0;
-		_deltimetable = table;
+		t.deltimeconst = 0.0;
+		t.deltime.assign(table, table + len);
 		if (len != _delay_table_size) {
+			sync();
 			_delay_table_size = len;
 			update_bin_groups(_delay_bin_groups, _delay_binmap_table, 
 			                  _delay_minfreq, _delay_maxfreq, _delay_table_size);
+			// the feedback table shares the delay bin groups
+			if (!t.feedback.empty())
+				t.feedback.resize(len, t.feedback.back());
+			publish_tables();
 		}
 	}
 }
 
 
-// ------------------------------------------------------------ set_feedtable --
-void Spectacle_dsp::set_feedtable(float *table, int len)
+// ---------------------------------------------------------- stage_feedtable --
+void Spectacle_dsp::stage_feedtable(const float *table, int len)
 {
+	SpectacleTables &t = _staged_tables;
 	if (len == 0) {	// no table set yet by caller
-		_feedbackconst = 0.0;
-		_feedbacktable = NULL;
+		t.feedbackconst = 0.0;
+		t.feedback.clear();
 	}
 	else if (len == 1) {
-		_feedbackconst = table[0];
-		_feedbacktable = NULL;
+		t.feedbackconst = table[0];
+		t.feedback.clear();
 	}
 	else if (len == _delay_table_size) {
-		_feedbackconst = 0.0;
-		_feedbacktable = table;
+		t.feedbackconst = 0.0;
+		t.feedback.assign(table, table + len);
 	}
 	// else don't do anything -- spectacle_fb_msg insures we never get here
 }
 
 
+// ----------------------------------------------------------- publish_tables --
+// Copy the staged tables into the back slot and swap it into the middle,
+// where the next frame will find it.  The slot we get back is either the one
+// modify_analysis let go of or an unread one, so we never write a slot that
+// is being read.
+
+void Spectacle_dsp::publish_tables()
+{
+	_tables[_tables_back] = _staged_tables;
+	_tables_back = _tables_middle.exchange(_tables_back | kTablesFresh,
+	                                       std::memory_order_acq_rel)
+	               & kTablesSlotMask;
+}
+
+
+// ----------------------------------------------------------- acquire_tables --
+// Called at the start of each frame: take the latest published tables, if
+// any, and use them for the whole frame.
+
+const SpectacleTables &Spectacle_dsp::acquire_tables()
+{
+	if (_tables_middle.load(std::memory_order_relaxed) & kTablesFresh)
+		_tables_front = _tables_middle.exchange(_tables_front,
+		                                        std::memory_order_acq_rel)
+		                & kTablesSlotMask;
+	return _tables[_tables_front];
+}
+
+
 // ------------------------------------------------------ set_delay_freqrange --
 // Similar to set_freqrange in base class, but for _delay_bin_groups.
 bool Spectacle_dsp::set_delay_freqrange(float min, float max)
 {
+	sync();
 	if (min != _delay_minfreq || max != _delay_maxfreq) {
 		if (max == 0.0f)
 			max = _nyquist;
@@ -238,6 +324,7 @@ bool Spectacle_dsp::set_delay_freqrange(float min, float max)
 
 void Spectacle_dsp::set_binmap_table(int *table, int len)
 {
+	sync();
 	if (table == NULL || len == 0 || len != _control_table_size)
 		_binmaptable = NULL;
 	else
@@ -254,6 +341,7 @@ void Spectacle_dsp::set_binmap_table(int *table, int len)
 
 void Spectacle_dsp::set_delay_binmap_table(int *table, int len)
 {
+	sync();
 	if (table == NULL || len == 0 || len != _delay_table_size)
 		_delay_binmap_table = NULL;
 	else
@@ -264,18 +352,31 @@ void Spectacle_dsp::set_delay_binmap_table(int *table, int len)
 
 
 // ---------------------------------------------------------- modify_analysis --
+// The work is split into passes over contiguous per-bin arrays: gather the
+// control table values for each bin, apply pre-EQ, read the delayed frame
+// out of the delay matrix, then write the new frame (input plus feedback)
+// and apply post-EQ.  All but the gather and the delay read are straight
+// vector loops.  The gather is done once per frame; the other passes take
+// every channel in turn with the same per-bin arrays.
+
 void Spectacle_dsp::modify_analysis(bool reading_input)
 {
 	DPRINT("modify_analysis: .....................");
 
+	// Take the control tables published since the last frame, if any.
+	const SpectacleTables &tables = acquire_tables();
+	const float *eqtable = tables.eq.empty() ? NULL : &tables.eq[0];
+	const float *deltimetable = tables.deltime.empty() ? NULL : &tables.deltime[0];
+	const float *feedbacktable = tables.feedback.empty() ? NULL : &tables.feedback[0];
+
 #ifdef PRINT_DELTIMES
 	static float *prevdeltimes = NULL;
 	if (prevdeltimes == NULL) {
 		prevdeltimes = new float [_delay_table_size];
 		post("\nmodify_analysis: delay times --------------------------");
 		for (int i = 0; i < _delay_table_size; i++) {
-			prevdeltimes[i] = _deltimetable[i];
-			post("[%d] %f", i, _deltimetable[i]);
+			prevdeltimes[i] = deltimetable[i];
+			post("[%d] %f", i, deltimetable[i]);
 		}
  #ifdef PRINT_DELTIME_CHANGES
 		post("\nmodify_analysis: delay time changes -------------------");
@@ -284,99 +385,150 @@ void Spectacle_dsp::modify_analysis(bool reading_input)
 #endif
 
 	const bool posteq = get_posteq();
-	float eq;
+	const int nvals = _half_fftlen * 2;
+	float eq = 1.0f;
 
-	// NB: check EQ table size, rather than table pointer, to determine whether
-	// we should use an EQ constant. Otherwise, there's a danger we could read
-	// a null EQ table pointer, if set_eqtable called by non-perf thread.
-	if (_control_table_size == 0)
-		eq = _ampdb(_eqconst);
+	if (eqtable == NULL)
+		eq = _ampdb(tables.eqconst);
 
+	// Gather per-bin EQ, delay and feedback.  Neighboring bins mostly fall in
+	// the same bin group, so only convert a table value when the group changes.
+	int prev_eqbg = -1, prev_delbg = -1;
+	long lag = 0;
+	float feedback = 0.0f;
 	for (int i = 0; i < _half_fftlen; i++) {
-		int index = i << 1;
+		const int index = i << 1;
 
-		if (_control_table_size > 0) {
+		if (eqtable) {
 			// EQ uses base class bin groups array.
 			const int bg = _bin_groups[i];
-			eq = _ampdb(_eqtable[bg]);
-		}
-
-		float real, imag;
-		if (reading_input) {
-		   if (posteq) {
-				real = _fft_buf[index];
-				imag = _fft_buf[index + 1];
-			}
-			else {
-				real = _fft_buf[index] * eq;
-				imag = _fft_buf[index + 1] * eq;
+			if (bg != prev_eqbg) {
+				eq = _ampdb(eqtable[bg]);
+				prev_eqbg = bg;
 			}
 		}
-		else {
-			real = 0.0f;
-			imag = 0.0f;
-		}
+		_bin_eq[index] = _bin_eq[index + 1] = eq;
 
 		const int bg = _delay_bin_groups[i];
-
-		// NB: caller must assure that deltime is in range
-		const float deltime = _deltimetable ? _deltimetable[bg] : _deltimeconst;
+		if (bg != prev_delbg) {
+			// NB: caller must assure that deltime is in range
+			const float deltime = deltimetable ? deltimetable[bg] : tables.deltimeconst;
 
 #ifdef PRINT_DELTIME_CHANGES
-		if (deltime != prevdeltimes[bg]) {
-			post("[%d] %f", bg, deltime);
-			prevdeltimes[bg] = deltime;
-		}
+			if (deltime != prevdeltimes[bg]) {
+				post("[%d] %f", bg, deltime);
+				prevdeltimes[bg] = deltime;
+			}
 #endif
 
-		if (deltime == 0.0f) {
-		   if (posteq) {
-				_fft_buf[index] = real * eq;
-				_fft_buf[index + 1] = imag * eq;
+			if (deltime == 0.0f) {
+				lag = 0;
+				feedback = 0.0f;
 			}
 			else {
-				_fft_buf[index] = real;
-				_fft_buf[index + 1] = imag;
+				lag = long((deltime * get_srate()) + 0.5) / _decimation;
+				// A delay shorter than one frame reads the oldest frame in the
+				// delay line, as the per-bin delay lines used to.
+				if (lag <= 0 || lag > _delay_rows)
+					lag = _delay_rows;
+				feedback = feedbacktable ? feedbacktable[bg] : tables.feedbackconst;
 			}
+			prev_delbg = bg;
+		}
+		_bin_lag[i] = lag;
+		_bin_feedback[index] = _bin_feedback[index + 1] = feedback;
+	}
+
+	// The passes below run over every channel with the same per-bin settings.
+	// Channel c's spectrum starts at c * nvals in _fft_buf, in _bin_dry and in
+	// each delay matrix row.
+	const int nchans = get_nchans();
+	const long rowlen = _delay_rowlen;
+
+	// Input, with pre-EQ.
+	float *dry = _bin_dry;
+	if (!reading_input)
+		memset(dry, 0, sizeof(float) * rowlen);
+	else if (posteq)
+		memcpy(dry, _fft_buf, sizeof(float) * rowlen);
+	else {
+		for (int c = 0; c < nchans; c++) {
+			const float *in = _fft_buf + c * nvals;
+			float *out = dry + c * nvals;
+			int k = 0;
+#ifdef SPECTACLE_SSE
+			for (; k + 4 <= nvals; k += 4)
+				_mm_storeu_ps(out + k, _mm_mul_ps(_mm_loadu_ps(in + k),
+				                                  _mm_loadu_ps(_bin_eq + k)));
+#endif
+			for (; k < nvals; k++)
+				out[k] = in[k] * _bin_eq[k];
+		}
+	}
+
+	// Delayed output for each bin; bins without delay pass the input through.
+	float *outrow = _delay_matrix + _delay_inrow * rowlen;
+	for (int i = 0; i < _half_fftlen; i++) {
+		const int index = i << 1;
+		const long lag = _bin_lag[i];
+		const float *src = dry + index;
+		if (lag != 0) {
+			long row = _delay_inrow - lag;
+			if (row < 0)
+				row += _delay_rows;
+			src = _delay_matrix + row * rowlen + index;
+		}
+		for (int c = 0; c < nchans; c++) {
+			float *dst = _fft_buf + c * nvals + index;
+			dst[0] = src[c * nvals];
+			dst[1] = src[c * nvals + 1];
+		}
+	}
+
+	// Write this frame into the delay matrix, then apply post-EQ.  Bins
+	// without delay have zero feedback, so they store their input, ready for
+	// when a delay time is set for them.
+#ifdef SPECTACLE_SSE
+ #ifdef ANTI_DENORM
+	const __m128 antidenorm = _mm_set1_ps(_antidenorm_offset);
+ #endif
+#endif
+	for (int c = 0; c < nchans; c++) {
+		float *wetbuf = _fft_buf + c * nvals;
+		const float *drybuf = dry + c * nvals;
+		float *outbuf = outrow + c * nvals;
+		int k = 0;
+#ifdef SPECTACLE_SSE
+		for (; k + 4 <= nvals; k += 4) {
+			const __m128 wet = _mm_loadu_ps(wetbuf + k);
+			__m128 fbsig = _mm_mul_ps(wet, _mm_loadu_ps(_bin_feedback + k));
+ #ifdef ANTI_DENORM
+			fbsig = _mm_add_ps(fbsig, antidenorm);
+ #endif
+			_mm_storeu_ps(outbuf + k, _mm_add_ps(_mm_loadu_ps(drybuf + k), fbsig));
+			if (posteq)
+				_mm_storeu_ps(wetbuf + k, _mm_mul_ps(wet, _mm_loadu_ps(_bin_eq + k)));
 		}
-		else {
-			const long delsamps = long((deltime * get_srate()) + 0.5)
-			                                                     / _decimation;
-			const float newreal = _real_delay[i]->getsamp(delsamps);
-			const float newimag = _imag_delay[i]->getsamp(delsamps);
-			const float feedback = _feedbacktable ? _feedbacktable[bg]
-			                                      : _feedbackconst;
-			if (feedback != 0.0) {
+#endif
+		for (; k < nvals; k++) {
+			const float wet = wetbuf[k];
 #ifdef ANTI_DENORM
-				float fbsig = (newreal * feedback) + _antidenorm_offset;
-				_real_delay[i]->putsamp(real + fbsig);
-				fbsig = (newimag * feedback) + _antidenorm_offset;
-				_imag_delay[i]->putsamp(imag + fbsig);
+			outbuf[k] = drybuf[k] + ((wet * _bin_feedback[k]) + _antidenorm_offset);
 #else
-				_real_delay[i]->putsamp(real + (newreal * feedback));
-				_imag_delay[i]->putsamp(imag + (newimag * feedback));
+			outbuf[k] = drybuf[k] + (wet * _bin_feedback[k]);
 #endif
-			}
-			else {
-				_real_delay[i]->putsamp(real);
-				_imag_delay[i]->putsamp(imag);
-			}
-		   if (posteq) {
-				_fft_buf[index] = newreal * eq;
-				_fft_buf[index + 1] = newimag * eq;
-			}
-			else {
-				_fft_buf[index] = newreal;
-				_fft_buf[index + 1] = newimag;
-			}
+			if (posteq)
+				wetbuf[k] = wet * _bin_eq[k];
 		}
 	}
 
-	_fft_buf[1] = 0.0f;	// clear Nyquist real value
+	if (++_delay_inrow == _delay_rows)
+		_delay_inrow = 0;
+
+	for (int c = 0; c < nchans; c++)
+		_fft_buf[c * nvals + 1] = 0.0f;	// clear Nyquist real value
 
 #ifdef ANTI_DENORM
 	_antidenorm_offset = -_antidenorm_offset;
 #endif
 }
-
-
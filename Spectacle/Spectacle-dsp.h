@@ -14,24 +14,43 @@
 //#define DEBUG
 
 #include "SpectacleBase.h"
+#include <atomic>
+#include <vector>
 
 #if defined(i386)
 	#define ANTI_DENORM
 #endif
 
+// One set of control tables.  An empty table means "use the constant".
+struct SpectacleTables {
+	SpectacleTables() : eqconst(0.0f), deltimeconst(0.0f), feedbackconst(0.0f) {}
+	std::vector<float> eq, deltime, feedback;
+	float eqconst, deltimeconst, feedbackconst;
+};
+
 class Spectacle_dsp : public SpectacleBase {
 
 public:
 	Spectacle_dsp();
 	virtual ~Spectacle_dsp();
 	int init(int fftlen, int windowlen, int overlap, float srate,
-		float maxdeltime);
+		float maxdeltime, int nchans = 1);
 	void clear();
 	void set_srate(float srate);
 	void set_maxdeltime(float time);
-	void set_eqtable(float *table, int len);
-	void set_deltable(float *table, int len);
-	void set_feedtable(float *table, int len);
+
+	// Control tables are copied in.  The stage_* calls change a staged copy,
+	// and publish_tables makes it visible to the next frame as a whole,
+	// without waiting for the frame in flight; set_* do both.  A change of
+	// table length also changes bin groups, so it waits for the frame in
+	// flight and publishes right away.
+	void set_eqtable(const float *table, int len);
+	void set_deltable(const float *table, int len);
+	void set_feedtable(const float *table, int len);
+	void stage_eqtable(const float *table, int len);
+	void stage_deltable(const float *table, int len);
+	void stage_feedtable(const float *table, int len);
+	void publish_tables();
 	void set_binmap_table(int *table, int len);
 	void set_delay_binmap_table(int *table, int len);
 	bool set_delay_freqrange(float min, float max);
@@ -43,12 +62,35 @@ protected:
 private:
 	long _maxdelsamps;
 	float _maxdeltime;
-	float _eqconst, _deltimeconst, _feedbackconst;
 	float _delay_minfreq, _delay_maxfreq;
-	float *_eqtable, *_deltimetable, *_feedbacktable;
 	int *_delay_bin_groups, *_delay_binmap_table, _delay_table_size;
-	Odelay *_real_delay[kMaxFFTLen / 2];
-	Odelay *_imag_delay[kMaxFFTLen / 2];
+
+	// Control tables, triple-buffered between the thread that sets them
+	// (back) and modify_analysis (front).  _tables_middle holds the index of
+	// the third slot, with kTablesFresh set if it was published since the
+	// front slot was taken.
+	enum { kTablesSlotMask = 3, kTablesFresh = 4 };
+	const SpectacleTables &acquire_tables();
+	SpectacleTables _staged_tables;
+	SpectacleTables _tables[3];
+	int _tables_back, _tables_front;
+	std::atomic<int> _tables_middle;
+
+	// Delay lines for the real and imaginary values of every bin, stored as
+	// one ring of whole spectral frames.  Row r holds _half_fftlen * 2 floats
+	// for each channel, laid out like _fft_buf, so writing a frame is one
+	// contiguous pass and bins that share a delay time read contiguous memory.
+	// This is the only per-channel state; the tables, bin groups and per-bin
+	// settings below serve every channel.
+	void alloc_delay_matrix();
+	float *_delay_matrix;
+	long _delay_rows, _delay_rowlen, _delay_inrow;
+
+	// Per-bin settings for the current frame, filled in from the control
+	// tables.  The float arrays have one value per real/imag pair member.
+	// _bin_dry holds the frame's input for every channel.
+	float *_bin_eq, *_bin_feedback, *_bin_dry;
+	long *_bin_lag;		// frames of delay, or 0 for none
 #ifdef ANTI_DENORM
 	float _antidenorm_offset;
 #endif
@@ -19,6 +19,7 @@
 // this should align with the correct versions of these ChucK files
 #include "chugin.h"
 #include "Spectacle-dsp.h"
+#include "SpectralBus.h"
 
 // general includes
 #include <stdio.h>
@@ -77,12 +78,39 @@ CK_DLL_MFUN(spectacle_setDelay);
 CK_DLL_MFUN(spectacle_setEQ);
 CK_DLL_MFUN(spectacle_setFB);
 
+CK_DLL_MFUN(spectacle_setDelays);
+CK_DLL_MFUN(spectacle_setEQs);
+CK_DLL_MFUN(spectacle_setFBs);
+
+CK_DLL_MFUN(spectacle_setThreaded);
+CK_DLL_MFUN(spectacle_getThreaded);
+
 // for Chugins extending UGen, this is mono synthesis function for 1 sample
 CK_DLL_TICKF(spectacle_tick);
 
+// Spectacle2, Spectacle4 and Spectacle8: linked multichannel Spectacles
+CK_DLL_CTOR(spectacle2_ctor);
+CK_DLL_CTOR(spectacle4_ctor);
+CK_DLL_CTOR(spectacle8_ctor);
+
 // this is a special offset reserved for Chugin internal data
 t_CKINT spectacle_data_offset = 0;
 
+// SpectacleBus: one STFT shared by several Spectacles
+CK_DLL_CTOR(spectaclebus_ctor);
+CK_DLL_DTOR(spectaclebus_dtor);
+CK_DLL_MFUN(spectaclebus_add);
+CK_DLL_MFUN(spectaclebus_remove);
+CK_DLL_MFUN(spectaclebus_size);
+CK_DLL_MFUN(spectaclebus_setFFTlen);
+CK_DLL_MFUN(spectaclebus_getFFTlen);
+CK_DLL_MFUN(spectaclebus_setOverlap);
+CK_DLL_MFUN(spectaclebus_getOverlap);
+CK_DLL_MFUN(spectaclebus_setThreaded);
+CK_DLL_MFUN(spectaclebus_getThreaded);
+CK_DLL_TICK(spectaclebus_tick);
+t_CKINT spectaclebus_data_offset = 0;
+
 #define CONFORM_INPUT
 #define CLIP(a, lo, hi) ( (a)>(lo)?( (a)<(hi)?(a):(hi) ):(lo) )
   
@@ -111,6 +139,7 @@ public:
     maxdeltime = CLIP(maxdeltime, kMinMaxDelTime, kMaxMaxDelTime);
 	mindeltime = 0.0;
     srate = fs;
+    nchans = 1;
     mix = 1.0;
     spectdelay = NULL;
     float *del = dttable;
@@ -141,7 +170,17 @@ public:
   // for Chugins extending UGen
   void tick( SAMPLE* in, SAMPLE* out, int nframes)
   {
+	if (nchans > 1)
+	  {
+		// linked channels: one interleaved sample per channel per frame
+		spectdelay->run(in, out, nframes);
+		for (int i=0; i<nframes*nchans; i++)
+		  out[i] = out[i] * mix + in[i] * (1-mix);
+		return;
+	  }
     memset (out, 0, sizeof(SAMPLE)*nframes);
+	// on a SpectacleBus, the bus does the processing
+	if (spectdelay->attached()) return;
 	for (int i=0; i<nframes; i+=2)
 	  {
 		spectdelay->run(in+i, out+i, 1);
@@ -171,6 +210,7 @@ public:
 			if (dttable[i] > dt)
 			  dttable[i] = dt;
 		  }
+		spectdelay->set_deltable(dttable,dttablen);
 		spectdelay->set_maxdeltime(dt);
 	  }
     maxdeltime = dt;
@@ -236,7 +276,7 @@ public:
 	while (newfft < p) newfft = newfft << 1;
 	fftlen = newfft;
 	windowlen = newfft * 2;
-    spectdelay->init(fftlen, windowlen, overlap, srate, maxdeltime);
+    spectdelay->init(fftlen, windowlen, overlap, srate, maxdeltime, nchans);
     return fftlen;
   }
 
@@ -247,12 +287,21 @@ public:
   {
 	clear();
 	overlap = p;
-    spectdelay->init(fftlen, windowlen, overlap, srate, maxdeltime);
+    spectdelay->init(fftlen, windowlen, overlap, srate, maxdeltime, nchans);
     return overlap;
   }
 
   int getOverlap() { return overlap; };
 
+  // Process <n> channels in lockstep with the same settings and tables;
+  // each channel has its own delay lines.
+  void setChannels( int n )
+  {
+	clear();
+	nchans = n;
+    spectdelay->init(fftlen, windowlen, overlap, srate, maxdeltime, nchans);
+  }
+
   float setMinFreq ( t_CKFLOAT p )
   {
 	float min = CLIP(p, 0.0, maxfreq);
@@ -324,6 +373,16 @@ public:
 
   int getTableLen() { return dttablen; };
 
+  int setThreaded( t_CKINT p )
+  {
+	spectdelay->set_threaded(p != 0);
+	return spectdelay->get_threaded();
+  }
+
+  int getThreaded() { return spectdelay->get_threaded(); }
+
+  Spectacle_dsp *dsp() { return spectdelay; }
+
   float setDelay (t_CKDUR p)
   {
 	float x = (p/srate);
@@ -355,6 +414,29 @@ public:
 	return x;
   }
 
+  // Bulk setters: one value per band.  Extra values are ignored; if there
+  // are fewer values than bands, the last one fills the rest.  Delay times
+  // are in seconds.
+  void setDelays ( Chuck_ArrayFloat * a, CK_DL_API api )
+  {
+	if (!fillTable(dttable, dttablen, a, api)) return;
+	for (int i = 0; i < dttablen; i++)
+	  dttable[i] = CLIP(dttable[i], 0.0f, maxdeltime);
+	spectdelay->set_deltable(dttable,dttablen);
+  }
+
+  void setEQs ( Chuck_ArrayFloat * a, CK_DL_API api )
+  {
+	if (!fillTable(eqtable, eqtablen, a, api)) return;
+	spectdelay->set_eqtable(eqtable,eqtablen);
+  }
+
+  void setFBs ( Chuck_ArrayFloat * a, CK_DL_API api )
+  {
+	if (!fillTable(fbtable, fbtablen, a, api)) return;
+	spectdelay->set_feedtable(fbtable,fbtablen);
+  }
+
   int setTable ( const char* p, const char* q )
   {
 	  if( !p || !q )
@@ -405,16 +487,18 @@ public:
 	if (table == 0 || table == 1) setDelayTable(type);
 	if (table == 0 || table == 2) setEQTable(type);
 	if (table == 0 || table == 3) setFBTable(type);
-	spectdelay->set_deltable(dttable,dttablen);
-	spectdelay->set_eqtable(eqtable,eqtablen);
-	spectdelay->set_feedtable(fbtable,fbtablen);
+	// publish all three together, so no frame sees half of the change
+	spectdelay->stage_deltable(dttable,dttablen);
+	spectdelay->stage_eqtable(eqtable,eqtablen);
+	spectdelay->stage_feedtable(fbtable,fbtablen);
+	spectdelay->publish_tables();
 
 	return 1;
   }
 		
   
 private:
-  int fftlen, windowlen, overlap;
+  int fftlen, windowlen, overlap, nchans;
   float srate, maxdeltime, mindeltime;
   Spectacle_dsp *spectdelay;
   float eqtable[kMaxTableLen];
@@ -479,6 +563,19 @@ private:
 	  }
   }
 
+  bool fillTable (float *table, int len, Chuck_ArrayFloat * a, CK_DL_API api)
+  {
+	const int n = a ? (int)api->object->array_float_size(a) : 0;
+	if (n == 0)
+	  {
+		printf("Spectacle: error: table array is empty\n");
+		return false;
+	  }
+	for (int i = 0; i < len; i++)
+	  table[i] = (float)api->object->array_float_get_idx(a, i < n ? i : n - 1);
+	return true;
+  }
+
   float rand2f (float min, float max)
   {
     return min + (max-min)*(::random()/(t_CKFLOAT)SPECTACLE_RAND_MAX);
@@ -654,6 +751,34 @@ CK_DLL_QUERY( Spectacle )
   QUERY->add_arg(QUERY, "float", "feedback");
   QUERY->doc_func(QUERY, "Set the same feedback value for all bands [-1.0 - 1.0].");
   
+  // example of adding setter method
+  QUERY->add_mfun(QUERY, spectacle_setDelays, "void", "delay");
+  // example of adding argument to the above method
+  QUERY->add_arg(QUERY, "float[]", "seconds");
+  QUERY->doc_func(QUERY, "Set the delay time of every band at once, in seconds, one value per band. If there are fewer values than bands, the last one fills the rest. Takes effect at the next FFT frame, all together.");
+
+  // example of adding setter method
+  QUERY->add_mfun(QUERY, spectacle_setEQs, "void", "eq");
+  // example of adding argument to the above method
+  QUERY->add_arg(QUERY, "float[]", "eq");
+  QUERY->doc_func(QUERY, "Set the EQ of every band at once (values are +/- dB), one value per band. If there are fewer values than bands, the last one fills the rest. Takes effect at the next FFT frame, all together.");
+
+  // example of adding setter method
+  QUERY->add_mfun(QUERY, spectacle_setFBs, "void", "feedback");
+  // example of adding argument to the above method
+  QUERY->add_arg(QUERY, "float[]", "feedback");
+  QUERY->doc_func(QUERY, "Set the feedback of every band at once [-1.0 - 1.0], one value per band. If there are fewer values than bands, the last one fills the rest. Takes effect at the next FFT frame, all together.");
+
+  // example of adding setter method
+  QUERY->add_mfun(QUERY, spectacle_setThreaded, "int", "threaded");
+  // example of adding argument to the above method
+  QUERY->add_arg(QUERY, "int", "arg");
+  QUERY->doc_func(QUERY, "Set to 1 to process FFT frames on a worker thread, which evens out CPU load at large FFT sizes at the cost of one extra hop (fftlen / overlap samples) of latency. Default 0.");
+
+  // example of adding getter method
+  QUERY->add_mfun(QUERY, spectacle_getThreaded, "int", "threaded");
+  QUERY->doc_func(QUERY, "Get whether FFT frames are processed on a worker thread.");
+  
   // this reserves a variable in the ChucK internal class to store 
   // referene to the c++ class we defined above
   spectacle_data_offset = QUERY->add_mvar(QUERY, "int", "@s_data", false);
@@ -661,6 +786,69 @@ CK_DLL_QUERY( Spectacle )
   // end the class definition
   // IMPORTANT: this MUST be called!
   QUERY->end_class(QUERY);
+
+  // Multichannel Spectacles inherit everything but the constructor and the
+  // channel count.
+  QUERY->begin_class(QUERY, "Spectacle2", "Spectacle");
+  QUERY->add_ctor(QUERY, spectacle2_ctor);
+  QUERY->doc_class(QUERY, "Stereo Spectacle. Both channels share one set of delay, EQ and feedback settings and are processed together, each with its own delays.");
+  QUERY->add_ugen_funcf(QUERY, spectacle_tick, NULL, 2, 2);
+  QUERY->end_class(QUERY);
+
+  QUERY->begin_class(QUERY, "Spectacle4", "Spectacle");
+  QUERY->add_ctor(QUERY, spectacle4_ctor);
+  QUERY->doc_class(QUERY, "Four-channel Spectacle. All channels share one set of delay, EQ and feedback settings and are processed together, each with its own delays.");
+  QUERY->add_ugen_funcf(QUERY, spectacle_tick, NULL, 4, 4);
+  QUERY->end_class(QUERY);
+
+  QUERY->begin_class(QUERY, "Spectacle8", "Spectacle");
+  QUERY->add_ctor(QUERY, spectacle8_ctor);
+  QUERY->doc_class(QUERY, "Eight-channel Spectacle. All channels share one set of delay, EQ and feedback settings and are processed together, each with its own delays.");
+  QUERY->add_ugen_funcf(QUERY, spectacle_tick, NULL, 8, 8);
+  QUERY->end_class(QUERY);
+
+  QUERY->begin_class(QUERY, "SpectacleBus", "UGen");
+  QUERY->add_ctor(QUERY, spectaclebus_ctor);
+  QUERY->add_dtor(QUERY, spectaclebus_dtor);
+
+  QUERY->doc_class(QUERY, "Runs one FFT analysis and one inverse FFT for several Spectacles processing the same input, and sums their output. Spectacles added to the bus go silent on their own outputs; use the bus output instead. They must use the bus's fftlen and overlap.");
+
+  QUERY->add_ugen_func(QUERY, spectaclebus_tick, NULL, 1, 1);
+
+  QUERY->add_mfun(QUERY, spectaclebus_add, "int", "add");
+  QUERY->add_arg(QUERY, "Spectacle", "spectacle");
+  QUERY->doc_func(QUERY, "Add a Spectacle to the bus. Returns 1 on success, 0 if it is already on a bus or its fftlen or overlap differ from the bus's.");
+
+  QUERY->add_mfun(QUERY, spectaclebus_remove, "void", "remove");
+  QUERY->add_arg(QUERY, "Spectacle", "spectacle");
+  QUERY->doc_func(QUERY, "Remove a Spectacle from the bus.");
+
+  QUERY->add_mfun(QUERY, spectaclebus_size, "int", "size");
+  QUERY->doc_func(QUERY, "Get the number of Spectacles on the bus.");
+
+  QUERY->add_mfun(QUERY, spectaclebus_setFFTlen, "int", "fftlen");
+  QUERY->add_arg(QUERY, "int", "arg");
+  QUERY->doc_func(QUERY, "Set FFT frame size (power of 2). Spectacles on the bus must match it to be heard.");
+
+  QUERY->add_mfun(QUERY, spectaclebus_getFFTlen, "int", "fftlen");
+  QUERY->doc_func(QUERY, "Get FFT frame size (power of 2).");
+
+  QUERY->add_mfun(QUERY, spectaclebus_setOverlap, "int", "overlap");
+  QUERY->add_arg(QUERY, "int", "arg");
+  QUERY->doc_func(QUERY, "Set frame overlap. Spectacles on the bus must match it to be heard.");
+
+  QUERY->add_mfun(QUERY, spectaclebus_getOverlap, "int", "overlap");
+  QUERY->doc_func(QUERY, "Get frame overlap.");
+
+  QUERY->add_mfun(QUERY, spectaclebus_setThreaded, "int", "threaded");
+  QUERY->add_arg(QUERY, "int", "arg");
+  QUERY->doc_func(QUERY, "Set to 1 to process FFT frames on a worker thread, at the cost of one extra hop of latency. Default 0.");
+
+  QUERY->add_mfun(QUERY, spectaclebus_getThreaded, "int", "threaded");
+  QUERY->doc_func(QUERY, "Get whether FFT frames are processed on a worker thread.");
+
+  spectaclebus_data_offset = QUERY->add_mvar(QUERY, "int", "@sb_data", false);
+  QUERY->end_class(QUERY);
   
   // wasn't that a breeze?
   return TRUE;
@@ -697,6 +885,26 @@ CK_DLL_DTOR(spectacle_dtor)
 }
 
 
+// constructors for the multichannel Spectacles; Spectacle's runs first
+CK_DLL_CTOR(spectacle2_ctor)
+{
+  Spectacle * bcdata = (Spectacle *) OBJ_MEMBER_INT(SELF, spectacle_data_offset);
+  if( bcdata ) bcdata->setChannels(2);
+}
+
+CK_DLL_CTOR(spectacle4_ctor)
+{
+  Spectacle * bcdata = (Spectacle *) OBJ_MEMBER_INT(SELF, spectacle_data_offset);
+  if( bcdata ) bcdata->setChannels(4);
+}
+
+CK_DLL_CTOR(spectacle8_ctor)
+{
+  Spectacle * bcdata = (Spectacle *) OBJ_MEMBER_INT(SELF, spectacle_data_offset);
+  if( bcdata ) bcdata->setChannels(8);
+}
+
+
 // implementation for tick function
 CK_DLL_TICKF(spectacle_tick)
 {
@@ -950,3 +1158,155 @@ CK_DLL_MFUN(spectacle_setFB)
   // set the return value
   RETURN->v_float = bcdata->setFB(GET_NEXT_FLOAT(ARGS));
 }
+
+// example implementation for setter
+CK_DLL_MFUN(spectacle_setDelays)
+{
+  // get our c++ class pointer
+  Spectacle * bcdata = (Spectacle *) OBJ_MEMBER_INT(SELF, spectacle_data_offset);
+  bcdata->setDelays((Chuck_ArrayFloat *) GET_NEXT_OBJECT(ARGS), API);
+}
+
+// example implementation for setter
+CK_DLL_MFUN(spectacle_setEQs)
+{
+  // get our c++ class pointer
+  Spectacle * bcdata = (Spectacle *) OBJ_MEMBER_INT(SELF, spectacle_data_offset);
+  bcdata->setEQs((Chuck_ArrayFloat *) GET_NEXT_OBJECT(ARGS), API);
+}
+
+// example implementation for setter
+CK_DLL_MFUN(spectacle_setFBs)
+{
+  // get our c++ class pointer
+  Spectacle * bcdata = (Spectacle *) OBJ_MEMBER_INT(SELF, spectacle_data_offset);
+  bcdata->setFBs((Chuck_ArrayFloat *) GET_NEXT_OBJECT(ARGS), API);
+}
+
+// example implementation for setter
+CK_DLL_MFUN(spectacle_setThreaded)
+{
+  // get our c++ class pointer
+  Spectacle * bcdata = (Spectacle *) OBJ_MEMBER_INT(SELF, spectacle_data_offset);
+  // set the return value
+  RETURN->v_int = bcdata->setThreaded(GET_NEXT_INT(ARGS));
+}
+
+// example implementation for getter
+CK_DLL_MFUN(spectacle_getThreaded)
+{
+  // get our c++ class pointer
+  Spectacle * bcdata = (Spectacle *) OBJ_MEMBER_INT(SELF, spectacle_data_offset);
+  // set the return value
+  RETURN->v_int = bcdata->getThreaded();
+}
+
+
+// ------------------------------------------------------------ SpectacleBus --
+// Holds a SpectralBus directly; settings are read back from it.
+
+static Spectacle_dsp *spectacle_dsp_of(Chuck_Object *obj, CK_DL_API API)
+{
+  Spectacle *s = obj ? (Spectacle *) OBJ_MEMBER_INT(obj, spectacle_data_offset) : NULL;
+  return s ? s->dsp() : NULL;
+}
+
+CK_DLL_CTOR(spectaclebus_ctor)
+{
+  OBJ_MEMBER_INT(SELF, spectaclebus_data_offset) = 0;
+  SpectralBus *bus = new SpectralBus();
+  bus->init(kDefaultFFTLen, kDefaultWindowLen, kDefaultOverlap, API->vm->srate(VM));
+  OBJ_MEMBER_INT(SELF, spectaclebus_data_offset) = (t_CKINT) bus;
+}
+
+CK_DLL_DTOR(spectaclebus_dtor)
+{
+  SpectralBus *bus = (SpectralBus *) OBJ_MEMBER_INT(SELF, spectaclebus_data_offset);
+  delete bus;
+  OBJ_MEMBER_INT(SELF, spectaclebus_data_offset) = 0;
+}
+
+CK_DLL_TICK(spectaclebus_tick)
+{
+  SpectralBus *bus = (SpectralBus *) OBJ_MEMBER_INT(SELF, spectaclebus_data_offset);
+  float x = in, y = 0.0f;
+  if (bus) bus->run(&x, &y, 1);
+  *out = y;
+  return TRUE;
+}
+
+CK_DLL_MFUN(spectaclebus_add)
+{
+  SpectralBus *bus = (SpectralBus *) OBJ_MEMBER_INT(SELF, spectaclebus_data_offset);
+  Spectacle_dsp *dsp = spectacle_dsp_of((Chuck_Object *) GET_NEXT_OBJECT(ARGS), API);
+  if (!dsp)
+    {
+      RETURN->v_int = 0;
+      return;
+    }
+  if (dsp->attached())
+    printf("SpectacleBus: error: that Spectacle is already on a bus.\n");
+  else if (dsp->get_nchans() != bus->get_nchans())
+    printf("SpectacleBus: error: only mono Spectacles can be added.\n");
+  else if (dsp->get_fftlen() != bus->get_fftlen() || dsp->get_overlap() != bus->get_overlap())
+    printf("SpectacleBus: error: Spectacle fftlen/overlap (%d/%d) must match the bus (%d/%d).\n",
+           dsp->get_fftlen(), dsp->get_overlap(), bus->get_fftlen(), bus->get_overlap());
+  RETURN->v_int = bus->add(dsp) ? 1 : 0;
+}
+
+CK_DLL_MFUN(spectaclebus_remove)
+{
+  SpectralBus *bus = (SpectralBus *) OBJ_MEMBER_INT(SELF, spectaclebus_data_offset);
+  Spectacle_dsp *dsp = spectacle_dsp_of((Chuck_Object *) GET_NEXT_OBJECT(ARGS), API);
+  if (dsp) bus->remove(dsp);
+}
+
+CK_DLL_MFUN(spectaclebus_size)
+{
+  SpectralBus *bus = (SpectralBus *) OBJ_MEMBER_INT(SELF, spectaclebus_data_offset);
+  RETURN->v_int = bus->count();
+}
+
+CK_DLL_MFUN(spectaclebus_setFFTlen)
+{
+  SpectralBus *bus = (SpectralBus *) OBJ_MEMBER_INT(SELF, spectaclebus_data_offset);
+  t_CKINT p = GET_NEXT_INT(ARGS);
+  int newfft = 1;
+  // ensure it's a power of 2
+  while (newfft < p) newfft = newfft << 1;
+  bus->init(newfft, newfft * 2, bus->get_overlap(), API->vm->srate(VM));
+  RETURN->v_int = bus->get_fftlen();
+}
+
+CK_DLL_MFUN(spectaclebus_getFFTlen)
+{
+  SpectralBus *bus = (SpectralBus *) OBJ_MEMBER_INT(SELF, spectaclebus_data_offset);
+  RETURN->v_int = bus->get_fftlen();
+}
+
+CK_DLL_MFUN(spectaclebus_setOverlap)
+{
+  SpectralBus *bus = (SpectralBus *) OBJ_MEMBER_INT(SELF, spectaclebus_data_offset);
+  t_CKINT p = GET_NEXT_INT(ARGS);
+  bus->init(bus->get_fftlen(), bus->get_window_len(), p, API->vm->srate(VM));
+  RETURN->v_int = bus->get_overlap();
+}
+
+CK_DLL_MFUN(spectaclebus_getOverlap)
+{
+  SpectralBus *bus = (SpectralBus *) OBJ_MEMBER_INT(SELF, spectaclebus_data_offset);
+  RETURN->v_int = bus->get_overlap();
+}
+
+CK_DLL_MFUN(spectaclebus_setThreaded)
+{
+  SpectralBus *bus = (SpectralBus *) OBJ_MEMBER_INT(SELF, spectaclebus_data_offset);
+  bus->set_threaded(GET_NEXT_INT(ARGS) != 0);
+  RETURN->v_int = bus->get_threaded();
+}
+
+CK_DLL_MFUN(spectaclebus_getThreaded)
+{
+  SpectralBus *bus = (SpectralBus *) OBJ_MEMBER_INT(SELF, spectaclebus_data_offset);
+  RETURN->v_int = bus->get_threaded();
+}
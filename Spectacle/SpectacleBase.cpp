@@ -20,10 +20,14 @@
 //#define CHECK_BINGROUPS
 
 #include "SpectacleBase.h"
-#define _USE_MATH_DEFINES // for Visual Studio
+#include "SpectralBus.h"
+#define _USE_MATH_DEFINES // for Visual Studio
 #include <math.h>
 #include <float.h>
 #include <cstddef>
+#include <map>
+#include <mutex>
+#include <tuple>
 
 #ifndef cosf
 #define cosf(x) cos((x))
@@ -51,13 +55,20 @@ SpectacleBase::SpectacleBase() :
   _print_stats(false),
   _reading_input(true),
   _posteq(false),
+  _nchans(1),
   _prev_bg_ignorevals(-1),
   _srate(-FLT_MAX),
   _minfreq(-FLT_MAX), _maxfreq(-FLT_MAX),
   _anal_window(NULL), _synth_window(NULL),
   _input(NULL), _output(NULL),
   _outbuf(NULL),
+  _frames(NULL),
   _cursamp(0L),
+  _frame_samp(0L),
+  _hop_in(NULL), _hop_out(NULL),
+  _threaded(false), _worker_quit(false), _frame_reading(true),
+  _frame_state(kFrameIdle),
+  _host(NULL),
   _fft(NULL),
   _bucket(NULL)
 {
@@ -67,37 +78,71 @@ SpectacleBase::SpectacleBase() :
 // ----------------------------------------------------------- ~SpectacleBase --
 SpectacleBase::~SpectacleBase()
 {
+  // Subclasses must call stop_processing in their destructors, since the
+  // worker and the bus call their modify_analysis; this is a backstop.
+  stop_processing();
   delete [] _outbuf;
+  delete [] _hop_in;
+  delete [] _hop_out;
   delete [] _input;
   delete [] _output;
-  delete [] _anal_window;
-  delete [] _synth_window;
+  delete [] _frames;
   delete [] _bin_groups;
   delete _bucket;
   delete _fft;
 }
 
 
+// -------------------------------------------------------------- get_windows --
+// Return the windows for these settings, computing them only if no other
+// instance holds them already.
+std::shared_ptr<const SpectacleWindows>
+SpectacleBase::get_windows(int fftlen, int window_len, int overlap)
+{
+  typedef std::tuple<int, int, int> Key;
+  static std::mutex mutex;
+  static std::map<Key, std::weak_ptr<const SpectacleWindows> > cache;
+  
+  std::lock_guard<std::mutex> lock(mutex);
+  std::weak_ptr<const SpectacleWindows> &entry
+    = cache[Key(fftlen, window_len, overlap)];
+  std::shared_ptr<const SpectacleWindows> windows = entry.lock();
+  if (!windows) {
+    std::shared_ptr<SpectacleWindows> w = std::make_shared<SpectacleWindows>();
+    make_windows(*w, fftlen, window_len, fftlen / overlap);
+    windows = w;
+    entry = windows;
+  }
+  return windows;
+}
+
+
 // ------------------------------------------------------------- make_windows --
-int SpectacleBase::make_windows()
+void SpectacleBase::make_windows(SpectacleWindows &windows, int fftlen,
+				 int window_len, int decimation)
 {
+  windows.anal.resize(window_len);
+  windows.synth.resize(window_len);
+  float *anal_window = &windows.anal[0];
+  float *synth_window = &windows.synth[0];
+  
   // Hamming window
-  for (int i = 0; i < _window_len; i++)
-    _anal_window[i] = _synth_window[i] = 0.54f - 0.46f
-      * cosf(2.0f * M_PI * i / (_window_len - 1));
+  for (int i = 0; i < window_len; i++)
+    anal_window[i] = synth_window[i] = 0.54f - 0.46f
+      * cosf(2.0f * M_PI * i / (window_len - 1));
   
-  // When _window_len > _fftlen, also apply interpolating (sinc) windows to
-  // ensure that window is 0 at increments of _fftlen away from the center
+  // When window_len > fftlen, also apply interpolating (sinc) windows to
+  // ensure that window is 0 at increments of fftlen away from the center
   // of the analysis window and of decimation away from the center of the
   // synthesis window.
   
-  if (_window_len > _fftlen) {
-    float x = -(_window_len - 1) / 2.0;
-    for (int i = 0; i < _window_len; i++, x += 1.0f)
+  if (window_len > fftlen) {
+    float x = -(window_len - 1) / 2.0;
+    for (int i = 0; i < window_len; i++, x += 1.0f)
       if (x != 0.0f) {
-	_anal_window[i] *= _fftlen * sin(M_PI * x / _fftlen) / (M_PI * x);
-	if (_decimation)
-	  _synth_window[i] *= _decimation * sin(M_PI * x / _decimation)
+	anal_window[i] *= fftlen * sin(M_PI * x / fftlen) / (M_PI * x);
+	if (decimation)
+	  synth_window[i] *= decimation * sin(M_PI * x / decimation)
 	    / (M_PI * x);
       }
   }
@@ -106,26 +151,24 @@ int SpectacleBase::make_windows()
   // analysis-synthesis procedure.
   
   float sum = 0.0f;
-  for (int i = 0; i < _window_len; i++)
-    sum += _anal_window[i];
+  for (int i = 0; i < window_len; i++)
+    sum += anal_window[i];
   
-  for (int i = 0; i < _window_len; i++) {
+  for (int i = 0; i < window_len; i++) {
     float afac = 2.0f / sum;
-    float sfac = _window_len > _fftlen ? 1.0f / afac : afac;
-    _anal_window[i] *= afac;
-    _synth_window[i] *= sfac;
+    float sfac = window_len > fftlen ? 1.0f / afac : afac;
+    anal_window[i] *= afac;
+    synth_window[i] *= sfac;
   }
   
-  if (_window_len <= _fftlen && _decimation) {
+  if (window_len <= fftlen && decimation) {
     sum = 0.0f;
-    for (int i = 0; i < _window_len; i += _decimation)
-      sum += _synth_window[i] * _synth_window[i];
+    for (int i = 0; i < window_len; i += decimation)
+      sum += synth_window[i] * synth_window[i];
     sum = 1.0f / sum;
-    for (int i = 0; i < _window_len; i++)
-      _synth_window[i] *= sum;
+    for (int i = 0; i < window_len; i++)
+      synth_window[i] *= sum;
   }
-  
-  return 0;
 }
 
 
@@ -133,6 +176,7 @@ int SpectacleBase::make_windows()
 // Must call this before anything that updates bin groups in subclass.
 void SpectacleBase::set_srate(float srate)
 {
+  sync();
   if (srate != _srate) {
     _srate = srate;
     if (_maxfreq == _nyquist)
@@ -148,11 +192,17 @@ void SpectacleBase::set_srate(float srate)
 
 
 // --------------------------------------------------------------------- init --
-int SpectacleBase::init(int fftlen, int windowlen, int overlap, float srate)
+int SpectacleBase::init(int fftlen, int windowlen, int overlap, float srate,
+			int nchans)
 {
+  // Drop the frame in flight, if any; it was made with the old settings.
+  sync();
+  _frame_state.store(kFrameIdle);
+  
   _fftlen = fftlen;
   _window_len = windowlen;
   _overlap = overlap;
+  _nchans = nchans > 0 ? nchans : 1;
   
   // Make sure FFT length is a power of 2 <= kMaxFFTLen.
   bool valid = false;
@@ -200,6 +250,17 @@ int SpectacleBase::init(int fftlen, int windowlen, int overlap, float srate)
     _overlap = 2;
   }
   
+  // init may be called again to change settings; drop the old buffers.
+  delete [] _bin_groups;
+  delete [] _input;
+  delete [] _output;
+  delete [] _outbuf;
+  delete [] _frames;
+  delete [] _hop_in;
+  delete [] _hop_out;
+  delete _bucket;
+  delete _fft;
+  
   _bin_groups = new int [_half_fftlen];
   
   set_srate(srate);
@@ -212,11 +273,12 @@ int SpectacleBase::init(int fftlen, int windowlen, int overlap, float srate)
   
   DPRINT2("_fftlen=%d, _decimation=%d", _fftlen, _decimation);
   
-  _input = new float [_window_len];            // interior input buffer
-  _output = new float [_window_len];           // interior output buffer
+  const int chanlen = _window_len * _nchans;
+  _input = new float [chanlen];                // interior input buffers
+  _output = new float [chanlen];               // interior output buffers
   if (_input == NULL || _output == NULL)
     return -1;
-  for (int i = 0; i < _window_len; i++)
+  for (int i = 0; i < chanlen; i++)
     _input[i] = _output[i] = 0.0f;
   
   // Read index chases write index by _decimation; add 2 extra locations to
@@ -225,24 +287,29 @@ int SpectacleBase::init(int fftlen, int windowlen, int overlap, float srate)
   _outframes = _decimation + 2;
   _out_read_index = _outframes - _decimation;
   _out_write_index = 0;
-  _outbuf = new float [_outframes];
+  _outbuf = new float [_outframes * _nchans];
   if (_outbuf == NULL)
     return -1;
-  for (int i = 0; i < _outframes; i++)
+  for (int i = 0; i < _outframes * _nchans; i++)
     _outbuf[i] = 0.0f;
   DPRINT1("_outframes: %d", _outframes);
   
-  _anal_window = new float [_window_len];
-  _synth_window = new float [_window_len];
-  if (_anal_window == NULL || _synth_window == NULL)
-    return -1;
-  if (make_windows() != 0)
-    return -1;
+  _hop_in = new float [_decimation * _nchans];
+  _hop_out = new float [_decimation * _nchans];
   
-  _bucket = new Obucket(_decimation, process_wrapper, (void *) this);
+  _windows = get_windows(_fftlen, _window_len, _overlap);
+  _anal_window = &_windows->anal[0];
+  _synth_window = &_windows->synth[0];
   
+  // The bucket collects whole interleaved frames, so it fills once per hop.
+  _bucket = new Obucket(_decimation * _nchans, process_wrapper, (void *) this);
+  
+  // One Offt transforms every channel's spectrum in turn.
   _fft = new Offt(_fftlen);
-  _fft_buf = _fft->getbuf();
+  _frames = new float [_fftlen * _nchans];
+  for (int i = 0; i < _fftlen * _nchans; i++)
+    _frames[i] = 0.0f;
+  _fft_buf = _frames;
   
   return 0;
 }
@@ -251,44 +318,55 @@ int SpectacleBase::init(int fftlen, int windowlen, int overlap, float srate)
 // -------------------------------------------------------------------- clear --
 void SpectacleBase::clear()
 {
-  for (int i = 0; i < _fftlen; i++)
+  sync();
+  _frame_state.store(kFrameIdle);
+  for (int i = 0; i < _fftlen * _nchans; i++)
     _fft_buf[i] = 0.0f;
-  for (int i = 0; i < _window_len; i++)
+  for (int i = 0; i < _window_len * _nchans; i++)
     _input[i] = _output[i] = 0.0f;
-  for (int i = 0; i < _outframes; i++)
+  for (int i = 0; i < _outframes * _nchans; i++)
     _outbuf[i] = 0.0f;
   _bucket->clear();
 }
 
 
 // ------------------------------------------------------------ prepare_input --
-// <buf> contains <_decimation> samples (mono) from most recent input.
+// <buf> contains <_decimation> frames of <_nchans> interleaved samples from
+// most recent input.
 
 void SpectacleBase::prepare_input(const float buf[])
 {
   DPRINT("prepare_input");
   
-  // Shift samples in <_input> from right to left by <_decimation>,
-  // leaving a hole of <_decimation> slots at right end.
-  
-  for (int i = 0; i < _window_len_minus_decimation; i++)
-    _input[i] = _input[i + _decimation];
-  
-  // Copy <_decimation> samples from <buf> to right end of <_input>.
-  
-  for (int i = _window_len_minus_decimation, j = 0; i < _window_len; i++, j++)
-    _input[i] = buf[j];
-  
-  // Multiply input array by analysis window, both of length <_window_len>.
-  // Fold and rotate windowed real input into FFT buffer.
-  
-  for (int i = 0; i < _fftlen; i++)
-    _fft_buf[i] = 0.0f;
-  int j = _cursamp % _fftlen;
-  for (int i = 0; i < _window_len; i++) {
-    _fft_buf[j] += _input[i] * _anal_window[i];
-    if (++j == _fftlen)
-      j = 0;
+  const int rotate = _frame_samp % _fftlen;
+  for (int c = 0; c < _nchans; c++) {
+    float *input = _input + c * _window_len;
+    float *fft_buf = _fft_buf + c * _fftlen;
+    
+    // Shift samples in <input> from right to left by <_decimation>,
+    // leaving a hole of <_decimation> slots at right end.
+    
+    for (int i = 0; i < _window_len_minus_decimation; i++)
+      input[i] = input[i + _decimation];
+    
+    // Copy <_decimation> samples of this channel from <buf> to right end
+    // of <input>.
+    
+    for (int i = _window_len_minus_decimation, j = c; i < _window_len;
+	 i++, j += _nchans)
+      input[i] = buf[j];
+    
+    // Multiply input array by analysis window, both of length <_window_len>.
+    // Fold and rotate windowed real input into FFT buffer.
+    
+    for (int i = 0; i < _fftlen; i++)
+      fft_buf[i] = 0.0f;
+    int j = rotate;
+    for (int i = 0; i < _window_len; i++) {
+      fft_buf[j] += input[i] * _anal_window[i];
+      if (++j == _fftlen)
+	j = 0;
+    }
   }
 }
 
@@ -298,57 +376,189 @@ void SpectacleBase::prepare_output()
 {
   DPRINT("prepare_output");
   
-  // overlap-add <_fft_buf> real data into <_output>
-  int j = _cursamp % _fftlen;
-  for (int i = 0; i < _window_len; i++) {
-    _output[i] += _fft_buf[j] * _synth_window[i];
-    if (++j == _fftlen)
-      j = 0;
-  }
-  
-  // transfer samples from <_output> to outer output buffer.
-  for (int i = 0; i < _decimation; i++) {
-    _outbuf[_out_write_index] = _output[i];
-    increment_out_write_index();
+  const int rotate = _frame_samp % _fftlen;
+  for (int c = 0; c < _nchans; c++) {
+    float *output = _output + c * _window_len;
+    const float *fft_buf = _fft_buf + c * _fftlen;
+    
+    // overlap-add <fft_buf> real data into <output>
+    int j = rotate;
+    for (int i = 0; i < _window_len; i++) {
+      output[i] += fft_buf[j] * _synth_window[i];
+      if (++j == _fftlen)
+	j = 0;
+    }
+    
+    // transfer samples from <output> to this channel of the finished hop
+    for (int i = 0, j = c; i < _decimation; i++, j += _nchans)
+      _hop_out[j] = output[i];
+    
+    // shift samples in <output> from right to left by <_decimation>
+    for (int i = 0; i < _window_len_minus_decimation; i++)
+      output[i] = output[i + _decimation];
+    for (int i = _window_len_minus_decimation; i < _window_len; i++)  
+      output[i] = 0.0f;
   }
-  
-  // shift samples in <_output> from right to left by <_decimation>
-  for (int i = 0; i < _window_len_minus_decimation; i++)
-    _output[i] = _output[i + _decimation];
-  for (int i = _window_len_minus_decimation; i < _window_len; i++)  
-    _output[i] = 0.0f;
 }
 
 
 // ---------------------------------------------------------- process_wrapper --
 // Called by Obucket whenever the input bucket is full (i.e., has _decimation
 // samps).  This static member wrapper function lets us call a non-static member
-// function, which we can't pass directly as a callback to Obucket.
+// function, which we can't pass directly as a callback to Obucket.  In
+// threaded mode, it hands the frame to the worker thread instead.
 // See http://www.newty.de/fpt/callback.html for one explanation of this.
 
 void SpectacleBase::process_wrapper(const float buf[], const int len,
 				    void *obj)
 {
   SpectacleBase *myself = (SpectacleBase *) obj;
-  myself->process(buf, len);
+  if (!myself->_threaded) {
+    myself->_frame_samp = myself->_cursamp;
+    myself->process(buf, myself->_reading_input);
+    myself->push_hop(myself->_hop_out);
+    return;
+  }
+  
+  // Collect the frame handed off one hop ago, which the worker has had a
+  // whole hop to finish, then hand off this one.
+  if (myself->_frame_state.load(std::memory_order_acquire) != kFrameIdle) {
+    myself->sync();
+    myself->push_hop(myself->_hop_out);
+  }
+  else
+    myself->push_hop(NULL);
+  for (int i = 0; i < len; i++)
+    myself->_hop_in[i] = buf[i];
+  myself->_frame_samp = myself->_cursamp;
+  myself->_frame_reading = myself->_reading_input;
+  {
+    std::lock_guard<std::mutex> lock(myself->_worker_mutex);
+    myself->_frame_state.store(kFrameQueued, std::memory_order_release);
+  }
+  myself->_worker_wake.notify_one();
 }
 
 
 // ------------------------------------------------------------------ process --
-void SpectacleBase::process(const float *buf, const int)
+void SpectacleBase::process(const float *buf, bool reading_input)
 {
   DPRINT("SpectacleBase::process");
   
-  if (_reading_input) {
+  if (reading_input) {
     prepare_input(buf);
-    _fft->r2c();
+    for (int c = 0; c < _nchans; c++)
+      _fft->r2c(_fft_buf + c * _fftlen);
   }
-  modify_analysis(_reading_input);
-  _fft->c2r();
+  modify_analysis(reading_input);
+  for (int c = 0; c < _nchans; c++)
+    _fft->c2r(_fft_buf + c * _fftlen);
   prepare_output();
 }
 
 
+// ----------------------------------------------------------------- push_hop --
+// Append <_decimation> frames of finished output, or silence if <hop> is
+// NULL, to the outer output buffer.
+
+void SpectacleBase::push_hop(const float *hop)
+{
+  for (int i = 0; i < _decimation; i++) {
+    float *frame = _outbuf + _out_write_index * _nchans;
+    for (int c = 0; c < _nchans; c++)
+      frame[c] = hop ? hop[i * _nchans + c] : 0.0f;
+    increment_out_write_index();
+  }
+}
+
+
+// ------------------------------------------------------------- set_threaded --
+void SpectacleBase::set_threaded(bool threaded)
+{
+#ifdef __EMSCRIPTEN__
+  threaded = false;
+#endif
+  if (threaded == _threaded)
+    return;
+  if (threaded) {
+    _worker_quit = false;
+    _worker = std::thread(&SpectacleBase::worker_loop, this);
+  }
+  else
+    stop_worker();
+  _frame_state.store(kFrameIdle);
+  _threaded = threaded;
+}
+
+
+// ---------------------------------------------------------- stop_processing --
+void SpectacleBase::stop_processing()
+{
+  set_threaded(false);
+  if (_host)
+    _host->remove(this);
+}
+
+
+// ------------------------------------------------------------- modify_frame --
+// Run modify_analysis on <buf>, a frame laid out like _fft_buf, in place of
+// our own analysis.  SpectralBus calls this for its processors.
+
+void SpectacleBase::modify_frame(float buf[], bool reading_input)
+{
+  float *own = _fft_buf;
+  _fft_buf = buf;
+  modify_analysis(reading_input);
+  _fft_buf = own;
+}
+
+
+// --------------------------------------------------------------------- sync --
+// A processor on a bus runs in the bus's frames, so wait for those too.
+
+void SpectacleBase::sync()
+{
+  if (_host)
+    _host->sync();
+  while (_frame_state.load(std::memory_order_acquire) == kFrameQueued)
+    std::this_thread::yield();
+}
+
+
+// -------------------------------------------------------------- worker_loop --
+void SpectacleBase::worker_loop()
+{
+  std::unique_lock<std::mutex> lock(_worker_mutex);
+  for (;;) {
+    _worker_wake.wait(lock, [this] {
+      return _worker_quit
+	|| _frame_state.load(std::memory_order_acquire) == kFrameQueued;
+    });
+    if (_worker_quit)
+      break;
+    lock.unlock();
+    process(_hop_in, _frame_reading);
+    _frame_state.store(kFrameDone, std::memory_order_release);
+    lock.lock();
+  }
+}
+
+
+// -------------------------------------------------------------- stop_worker --
+void SpectacleBase::stop_worker()
+{
+  if (!_worker.joinable())
+    return;
+  sync();
+  {
+    std::lock_guard<std::mutex> lock(_worker_mutex);
+    _worker_quit = true;
+  }
+  _worker_wake.notify_one();
+  _worker.join();
+}
+
+
 // ------------------------------------------------------------ set_freqrange --
 // Update the frequency range within which control tables operate.  Return true
 // if range has actually changed, resulting in an update_bin_groups call.
@@ -356,6 +566,7 @@ void SpectacleBase::process(const float *buf, const int)
 
 bool SpectacleBase::set_freqrange(float min, float max)
 {
+  sync();
   if (min != _minfreq || max != _maxfreq) {
     if (max == 0.0f)
       max = _nyquist;
@@ -629,20 +840,34 @@ void SpectacleBase::print_bin_groups(
 // ---------------------------------------------------------------------- run --
 void SpectacleBase::run(float in[], float out[], int nframes)
 {
-  if (_reading_input) {
-    for (int i = 0; i < nframes; i++) {
-      _bucket->drop(in[i]);	// may process <_decimation> input frames
-      out[i] = _outbuf[_out_read_index];
-      increment_out_read_index();
-      _cursamp++;
+  if (_nchans == 1) {
+    if (_reading_input) {
+      for (int i = 0; i < nframes; i++) {
+	_bucket->drop(in[i]);	// may process <_decimation> input frames
+	out[i] = _outbuf[_out_read_index];
+	increment_out_read_index();
+	_cursamp++;
+      }
     }
-  }
-  else {
-    for (int i = 0; i < nframes; i++) {
-      _bucket->drop(0.0f);		// may process <_decimation> input frames
-      out[i] = _outbuf[_out_read_index];
-      increment_out_read_index();
-      _cursamp++;
+    else {
+      for (int i = 0; i < nframes; i++) {
+	_bucket->drop(0.0f);	// may process <_decimation> input frames
+	out[i] = _outbuf[_out_read_index];
+	increment_out_read_index();
+	_cursamp++;
+      }
     }
+    return;
+  }
+  
+  for (int i = 0; i < nframes; i++, in += _nchans, out += _nchans) {
+    // the last sample of a frame may process <_decimation> input frames
+    for (int c = 0; c < _nchans; c++)
+      _bucket->drop(_reading_input ? in[c] : 0.0f);
+    const float *frame = _outbuf + _out_read_index * _nchans;
+    for (int c = 0; c < _nchans; c++)
+      out[c] = frame[c];
+    increment_out_read_index();
+    _cursamp++;
   }
 }
@@ -11,7 +11,16 @@
  *  GNU General Public License for more details.
  */
 
+#ifndef _SPECTACLEBASE_H_
+#define _SPECTACLEBASE_H_
+
 #include <math.h>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
 #include "genlib/Ougens.h"
 //#include "ext.h"	// for Max/MSP post and error functions
 
@@ -41,22 +50,56 @@ const int kMaxFFTLen = 16384;
 #define DPRINT3(msg, arg1, arg2, arg3)
 #endif
 
+// Analysis and synthesis windows depend only on FFT length, window length
+// and overlap, so instances with the same settings share one copy.
+struct SpectacleWindows {
+  std::vector<float> anal, synth;
+};
+
+class SpectralBus;
+
 class SpectacleBase {
   
  public:
   SpectacleBase();
   virtual ~SpectacleBase();
+  
+  // <in> and <out> hold <nframes> frames of get_nchans() interleaved samples.
   void run(float in[], float out[], int nframes);
   bool set_freqrange(float min, float max);
   
   // set hold to true to suppress input
-  void set_hold(bool hold) { _reading_input = !hold; }
+  void set_hold(bool hold) { sync(); _reading_input = !hold; }
   
   // set posteq to true to apply EQ after delay, rather than before
-  void set_posteq(bool posteq) { _posteq = posteq; }
+  void set_posteq(bool posteq) { sync(); _posteq = posteq; }
+  
+  // Set threaded to true to process each frame on a worker thread while
+  // the next hop of input arrives, rather than within run().  This spreads
+  // the cost of a frame evenly over the hop, at the price of one extra hop
+  // (fftlen / overlap samples) of latency.  Switching drops the frame in
+  // flight, so set this before audio starts if glitches matter.
+  void set_threaded(bool threaded);
+  bool get_threaded() const { return _threaded; }
+  
+  // Wait for the worker to finish the frame in flight, if any.  Call this
+  // before changing anything modify_analysis reads.  Subclass setters do
+  // this themselves; callers that pass in tables must also do it before
+  // writing to them.
+  void sync();
+  
+  // true while this instance is a processor on a SpectralBus
+  bool attached() const { return _host != NULL; }
+  
+  int get_fftlen() const { return _fftlen; }
+  int get_window_len() const { return _window_len; }
+  int get_overlap() const { return _overlap; }
+  int get_nchans() const { return _nchans; }
   
  protected:
-  int init(int fftlen, int windowlen, int overlap, float srate);
+  // <nchans> channels are analyzed in lockstep and share everything but
+  // their sample buffers and spectra.
+  int init(int fftlen, int windowlen, int overlap, float srate, int nchans = 1);
   void clear();
   void set_srate(float srate);
   virtual void modify_analysis(bool reading_input) = 0;
@@ -78,11 +121,8 @@ class SpectacleBase {
   
   // accessors for subclasses
   void set_fftlen(int fftlen) { _fftlen = fftlen; }
-  int get_fftlen() const { return _fftlen; }
   void set_window_len(int window_len) { _window_len = window_len; }
-  int get_window_len() const { return _window_len; }
   void set_overlap(int overlap) { _overlap = overlap; }
-  int get_overlap() const { return _overlap; }
   float get_minfreq() const { return _minfreq; }
   float get_maxfreq() const { return _maxfreq; }
   float get_srate() const { return _srate; }
@@ -101,8 +141,9 @@ class SpectacleBase {
   
   int _control_table_size;
   
-  // This pointer gives us direct access to the Offt object's buffer.
-  // It has _fftlen elements, interpreted as described in Offt.h.
+  // The spectra of the current frame, one per channel, each with _fftlen
+  // elements interpreted as described in Offt.h.  Channel c starts at
+  // _fft_buf + c * _fftlen.  A subclass's modify_analysis handles them all.
   
   float *_fft_buf;
   
@@ -121,22 +162,53 @@ class SpectacleBase {
   // Used for specifying bin groups.
   int *_binmaptable;
   
+  // Subclass destructors call this first: it stops the worker thread and
+  // takes this instance off its bus, both of which call modify_analysis.
+  void stop_processing();
+  
  private:
-  int make_windows();
+  friend class SpectralBus;
+  
+  void modify_frame(float buf[], bool reading_input);
+  static std::shared_ptr<const SpectacleWindows> get_windows(int fftlen,
+							   int window_len,
+							   int overlap);
+  static void make_windows(SpectacleWindows &windows, int fftlen,
+			   int window_len, int decimation);
   void prepare_input(const float buf[]);
   void prepare_output();
   static void process_wrapper(const float buf[], const int len, void *obj);
-  void process(const float *buf, const int len);
+  void process(const float *buf, bool reading_input);
+  void push_hop(const float *hop);
+  void worker_loop();
+  void stop_worker();
   inline void increment_out_read_index();
   inline void increment_out_write_index();
   
   bool _print_stats, _reading_input, _posteq;
-  int _fftlen, _window_len, _prev_bg_ignorevals;
+  int _fftlen, _window_len, _nchans, _prev_bg_ignorevals;
   int _out_read_index, _out_write_index, _outframes;
   int _window_len_minus_decimation;
   float _srate, _minfreq, _maxfreq;
-  float *_anal_window, *_synth_window, *_input, *_output, *_outbuf;
+  std::shared_ptr<const SpectacleWindows> _windows;
+  const float *_anal_window, *_synth_window;
+  float *_input, *_output;	// _window_len samples for each channel
+  float *_outbuf;		// _outframes interleaved frames
+  float *_frames;		// what _fft_buf points to
   unsigned long _cursamp;	// good for about 27 hours on a 32bit machine
+  unsigned long _frame_samp;	// _cursamp when the frame being processed filled
+  float *_hop_in, *_hop_out;	// one hop of input and of finished output,
+				// interleaved
+  
+  // The audio thread moves a frame from idle (or done) to queued; the worker
+  // moves it from queued to done.
+  enum { kFrameIdle, kFrameQueued, kFrameDone };
+  bool _threaded, _worker_quit, _frame_reading;
+  std::atomic<int> _frame_state;
+  std::thread _worker;
+  std::mutex _worker_mutex;
+  std::condition_variable _worker_wake;
+  SpectralBus *_host;		// the bus this instance is a processor on, if any
   Offt *_fft;
   Obucket *_bucket;
 };
@@ -163,4 +235,4 @@ inline void SpectacleBase::increment_out_write_index()
   //	assert(_out_write_index != _out_read_index);
 }
 
-
+#endif // _SPECTACLEBASE_H_
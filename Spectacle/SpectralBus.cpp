@@ -0,0 +1,107 @@
+// SpectralBus - see SpectralBus.h.
+
+#include "SpectralBus.h"
+#include <algorithm>
+#include <string.h>
+
+
+// -------------------------------------------------------------- SpectralBus --
+SpectralBus::SpectralBus()
+{
+}
+
+
+// ------------------------------------------------------------- ~SpectralBus --
+SpectralBus::~SpectralBus()
+{
+	stop_processing();
+	for (size_t i = 0; i < _processors.size(); i++)
+		_processors[i]->_host = NULL;
+}
+
+
+// --------------------------------------------------------------------- init --
+int SpectralBus::init(int fftlen, int windowlen, int overlap, float srate,
+	int nchans)
+{
+	if (SpectacleBase::init(fftlen, windowlen, overlap, srate, nchans) != 0)
+		return -1;
+	const int len = get_fftlen() * get_nchans();
+	_analysis.assign(len, 0.0f);
+	_scratch.assign(len, 0.0f);
+	_sum.assign(len, 0.0f);
+	return 0;
+}
+
+
+// ------------------------------------------------------------------ matches --
+bool SpectralBus::matches(const SpectacleBase *processor) const
+{
+	return processor->get_fftlen() == get_fftlen()
+		&& processor->get_window_len() == get_window_len()
+		&& processor->get_overlap() == get_overlap()
+		&& processor->get_nchans() == get_nchans();
+}
+
+
+// ---------------------------------------------------------------------- add --
+bool SpectralBus::add(SpectacleBase *processor)
+{
+	if (processor == NULL || processor == this || processor->_host != NULL)
+		return false;
+	if (!matches(processor))
+		return false;
+	sync();
+	_processors.push_back(processor);
+	processor->_host = this;
+	return true;
+}
+
+
+// ------------------------------------------------------------------- remove --
+void SpectralBus::remove(SpectacleBase *processor)
+{
+	std::vector<SpectacleBase *>::iterator it
+		= std::find(_processors.begin(), _processors.end(), processor);
+	if (it == _processors.end())
+		return;
+	sync();
+	_processors.erase(it);
+	processor->_host = NULL;
+}
+
+
+// ---------------------------------------------------------- modify_analysis --
+// Give each processor its own copy of the analysis frame, and replace the
+// frame with the sum of what they make of it.  With no processors, the
+// analysis passes through unchanged.
+
+void SpectralBus::modify_analysis(bool reading_input)
+{
+	if (_processors.empty())
+		return;
+
+	const int len = get_fftlen() * get_nchans();
+	float *analysis = &_analysis[0];
+	float *scratch = &_scratch[0];
+	float *sum = &_sum[0];
+
+	// When holding, _fft_buf wasn't refilled; processors get silence.
+	if (reading_input)
+		memcpy(analysis, _fft_buf, sizeof(float) * len);
+	else
+		memset(analysis, 0, sizeof(float) * len);
+	memset(sum, 0, sizeof(float) * len);
+
+	for (size_t p = 0; p < _processors.size(); p++) {
+		SpectacleBase *processor = _processors[p];
+		if (!matches(processor))
+			continue;
+		memcpy(scratch, analysis, sizeof(float) * len);
+		processor->modify_frame(scratch, reading_input);
+		for (int i = 0; i < len; i++)
+			sum[i] += scratch[i];
+	}
+
+	memcpy(_fft_buf, sum, sizeof(float) * len);
+}
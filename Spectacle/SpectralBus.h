@@ -0,0 +1,45 @@
+// SpectralBus - one STFT analysis shared by several spectral processors.
+//
+// The bus windows and transforms its input once per hop, hands a read-only
+// copy of each analysis frame to every attached processor (any SpectacleBase
+// subclass, such as Spectacle_dsp or SpectEQ), sums their modified spectra
+// and runs one inverse FFT.  N processors cost 2 FFTs per hop instead of 2N.
+//
+// A processor on the bus is driven only by the bus; don't also run() it.
+// Processors must be initialized with the bus's fftlen, window length,
+// overlap and channel count, and are skipped for any frame in which they
+// aren't.
+
+#ifndef _SPECTRALBUS_H_
+#define _SPECTRALBUS_H_
+
+#include "SpectacleBase.h"
+#include <vector>
+
+class SpectralBus : public SpectacleBase {
+
+public:
+	SpectralBus();
+	virtual ~SpectralBus();
+	int init(int fftlen, int windowlen, int overlap, float srate,
+		int nchans = 1);
+
+	// The bus doesn't own its processors; a processor leaves the bus when it
+	// is destroyed.  add returns false if <processor> is already on a bus or
+	// doesn't match the bus's settings.
+	bool add(SpectacleBase *processor);
+	void remove(SpectacleBase *processor);
+	int count() const { return int(_processors.size()); }
+
+protected:
+	virtual void modify_analysis(bool reading_input);
+	virtual const char *instname() { return "spectralbus~"; }
+
+private:
+	bool matches(const SpectacleBase *processor) const;
+
+	std::vector<SpectacleBase *> _processors;
+	std::vector<float> _analysis, _scratch, _sum;
+};
+
+#endif // _SPECTRALBUS_H_
@@ -0,0 +1,101 @@
+// offt-bench - compare SimdFFT, Offt's default backend, against FFTReal.
+//
+// For each FFT length Spectacle allows, checks that SimdFFT's spectrum and
+// round trip match FFTReal's (reordered into Offt's packing), then times a
+// forward + inverse transform pair with each.  Build with "make bench".
+
+#include "FFTReal.h"
+#include "SimdFFT.h"
+
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+static double now()
+{
+	using namespace std::chrono;
+	return duration<double>(steady_clock::now().time_since_epoch()).count();
+}
+
+// FFTReal's do_fft output, reordered and normalized as Offt does
+static void fftreal_r2c(const FFTReal &fft, const float *in, float *out,
+	float *tmp, int len)
+{
+	fft.do_fft(tmp, in);
+	const float scale = 1.0f / len;
+	const int half = len / 2;
+	out[0] = tmp[0] * scale;
+	out[1] = tmp[half] * scale;
+	for (int i = 1; i < half; i++) {
+		out[i + i] = tmp[i] * scale;
+		out[i + i + 1] = tmp[half + i] * scale;
+	}
+}
+
+static void fftreal_c2r(const FFTReal &fft, const float *in, float *out,
+	float *tmp, int len)
+{
+	const int half = len / 2;
+	tmp[0] = in[0];
+	tmp[half] = in[1];
+	for (int i = 1; i < half; i++) {
+		tmp[i] = in[i + i];
+		tmp[half + i] = in[i + i + 1];
+	}
+	fft.do_ifft(tmp, out);
+}
+
+int main(int argc, char *argv[])
+{
+	const int reps = (argc > 1) ? atoi(argv[1]) : 2000;
+
+	printf("%7s %12s %12s %12s %8s %8s\n", "fftlen", "spec err",
+		"trip err", "FFTReal us", "Simd us", "speedup");
+
+	for (int len = 64; len <= 16384; len *= 2) {
+		FFTReal fftreal(len);
+		std::shared_ptr<const SimdFFT> simd = SimdFFT::plan(len);
+
+		std::vector<float> in(len), a(len), b(len), tmp(len);
+		std::vector<float> work(simd->worksize());
+		srand(len);
+		for (int i = 0; i < len; i++)
+			in[i] = float(rand()) / RAND_MAX * 2.0f - 1.0f;
+
+		// accuracy: spectra relative to the largest bin, round trip absolute
+		fftreal_r2c(fftreal, &in[0], &a[0], &tmp[0], len);
+		simd->r2c(&in[0], &b[0], &work[0]);
+		double peak = 0.0, specerr = 0.0;
+		for (int i = 0; i < len; i++) {
+			peak = fmax(peak, fabs(a[i]));
+			specerr = fmax(specerr, fabs(a[i] - b[i]));
+		}
+		specerr /= peak;
+		simd->c2r(&b[0], &b[0], &work[0]);
+		double triperr = 0.0;
+		for (int i = 0; i < len; i++)
+			triperr = fmax(triperr, fabs(in[i] - b[i]));
+
+		// speed: reps forward + inverse pairs, scaled so each length does
+		// roughly the same amount of work
+		const int n = reps * 1024 / len + 1;
+		double t0 = now();
+		for (int r = 0; r < n; r++) {
+			fftreal_r2c(fftreal, &in[0], &a[0], &tmp[0], len);
+			fftreal_c2r(fftreal, &a[0], &a[0], &tmp[0], len);
+		}
+		double t1 = now();
+		for (int r = 0; r < n; r++) {
+			simd->r2c(&in[0], &b[0], &work[0]);
+			simd->c2r(&b[0], &b[0], &work[0]);
+		}
+		double t2 = now();
+		const double us_ref = (t1 - t0) * 1e6 / n, us_simd = (t2 - t1) * 1e6 / n;
+
+		printf("%7d %12.3g %12.3g %12.2f %8.2f %7.2fx\n", len, specerr,
+			triperr, us_ref, us_simd, us_ref / us_simd);
+	}
+	return 0;
+}
@@ -4,8 +4,12 @@
 */
 
 #include "Offt.h"
-#ifndef FFTW
+#include <string.h>
+#ifdef FFTW
+#elif defined(OFFT_FFTREAL)
 #include "FFTReal.h"
+#else
+#include "SimdFFT.h"
 #endif
 
 
@@ -21,11 +25,15 @@ Offt::Offt(int fftsize, unsigned int flags)
 		_plan_r2c = fftwf_plan_dft_r2c_1d(_len, _buf, _cbuf, FFTW_ESTIMATE);
 	if (flags & kComplexToReal)
 		_plan_c2r = fftwf_plan_dft_c2r_1d(_len, _cbuf, _buf, FFTW_ESTIMATE);
-#else // !FFTW
+#elif defined(OFFT_FFTREAL)
 	_buf = new float [_len];
 	_tmp = new float [_len];
 	_fftobj = new FFTReal(_len);
-#endif // !FFTW
+#else
+	_plan = SimdFFT::plan(_len);
+	_buf = new float [_len];
+	_work = new float [_plan->worksize()];
+#endif
 }
 
 Offt::~Offt()
@@ -37,57 +45,64 @@ Offt::~Offt()
 		fftwf_destroy_plan(_plan_c2r);
 	fftwf_free(_buf);
 	fftwf_free(_cbuf);
-#else // !FFTW
+#elif defined(OFFT_FFTREAL)
 	delete [] _buf;
 	delete [] _tmp;
 	delete _fftobj;
-#endif // !FFTW
+#else
+	delete [] _buf;
+	delete [] _work;
+#endif
 }
 
 
 #ifdef FFTW
 
-void Offt::r2c()
+void Offt::r2c(float *buf)
 {
+	if (buf != _buf)
+		memcpy(_buf, buf, sizeof(float) * _len);
 	fftwf_execute(_plan_r2c);
 
 	// _cbuf has complex result in real,imaginary pairs from DC to Nyquist;
-	// copy into _buf while reordering to...
+	// copy into buf while reordering to...
 	//    re(0), re(len/2), re(1), im(1), re(2), im(2)...re(len/2-1), im(len/2-1)
 	// and normalizing by 1 / fftlen.
 	float scale = 1.0 / _len;
 	int last = _len / 2;
-	_buf[0] = _cbuf[0][0] * scale;
-	_buf[1] = _cbuf[last][0] * scale;
+	buf[0] = _cbuf[0][0] * scale;
+	buf[1] = _cbuf[last][0] * scale;
 	for (int i = 1; i < last; i++) {
-		_buf[i + i] = _cbuf[i][0] * scale;
-		_buf[i + i + 1] = _cbuf[i][1] * scale;
+		buf[i + i] = _cbuf[i][0] * scale;
+		buf[i + i + 1] = _cbuf[i][1] * scale;
 	}
 }
 
-void Offt::c2r()
+void Offt::c2r(float *buf)
 {
-	// _buf has complex data; copy into _cbuf while reordering from...
+	// buf has complex data; copy into _cbuf while reordering from...
 	//    re(0), re(len/2), re(1), im(1), re(2), im(2)...re(len/2-1), im(len/2-1)
 	// to real,imaginary pairs from DC to Nyquist;
 	int last = _len / 2;
-	_cbuf[0][0] = _buf[0];
-	_cbuf[last][0] = _buf[1];
+	_cbuf[0][0] = buf[0];
+	_cbuf[last][0] = buf[1];
 	for (int i = 1; i < last; i++) {
-		_cbuf[i][0] = _buf[i + i];
-		_cbuf[i][1] = _buf[i + i + 1];
+		_cbuf[i][0] = buf[i + i];
+		_cbuf[i][1] = buf[i + i + 1];
 	}
 
 	fftwf_execute(_plan_c2r);
+	if (buf != _buf)
+		memcpy(buf, _buf, sizeof(float) * _len);
 }
 
-#else // !FFTW
+#elif defined(OFFT_FFTREAL)
 
-void Offt::r2c()
+void Offt::r2c(float *buf)
 {
-	_fftobj->do_fft(_tmp, _buf);
+	_fftobj->do_fft(_tmp, buf);
 
-	// _tmp has complex result; copy into _buf while reordering from...
+	// _tmp has complex result; copy into buf while reordering from...
 	//    re(0), re(1), re(2)...re(len/2), im(1), im(2)...im(len/2-1)
 	// to...
 	//    re(0), re(len/2), re(1), im(1), re(2), im(2)...re(len/2-1), im(len/2-1)
@@ -95,16 +110,16 @@ void Offt::r2c()
 
 	float scale = 1.0f / _len;
 	int j = _len / 2;
-	_buf[0] = _tmp[0] * scale;
-	_buf[1] = _tmp[j] * scale;
+	buf[0] = _tmp[0] * scale;
+	buf[1] = _tmp[j] * scale;
 #if 0
 	for (int i = 1; i < j; i++) {
-		_buf[i + i] = _tmp[i] * scale;				// real
-		_buf[i + i + 1] = _tmp[j + i] * scale;		// imag
+		buf[i + i] = _tmp[i] * scale;				// real
+		buf[i + i + 1] = _tmp[j + i] * scale;		// imag
 	}
 #else
 	int i = j - 1;
-	float *bp = &_buf[_len - 1];
+	float *bp = &buf[_len - 1];
 	float *tp = &_tmp[j + i];
 	do {
 		*bp-- = *tp-- * scale;         // imag
@@ -113,24 +128,24 @@ void Offt::r2c()
 #endif
 }
 
-void Offt::c2r()
+void Offt::c2r(float *buf)
 {
-	// _buf has complex data; copy into _tmp while reordering from...
+	// buf has complex data; copy into _tmp while reordering from...
 	//    re(0), re(len/2), re(1), im(1), re(2), im(2)...re(len/2-1), im(len/2-1)
 	// to...
 	//    re(0), re(1), re(2)...re(len/2), im(1), im(2)...im(len/2-1)
 
 	int j = _len / 2;
-	_tmp[0] = _buf[0];
-	_tmp[j] = _buf[1];
+	_tmp[0] = buf[0];
+	_tmp[j] = buf[1];
 #if 0
 	for (int i = 1; i < j; i++) {
-		_tmp[i] = _buf[i + i];				// real
-		_tmp[j + i] = _buf[i + i + 1];	// imag
+		_tmp[i] = buf[i + i];				// real
+		_tmp[j + i] = buf[i + i + 1];	// imag
 	}
 #else
 	int i = j - 1;
-	float *bp = &_buf[_len - 1];
+	float *bp = &buf[_len - 1];
 	float *tp = &_tmp[j + i];
 	do {
 		*tp-- = *bp--;         // imag
@@ -138,12 +153,26 @@ void Offt::c2r()
 	} while (i > 0);
 #endif
 
-	_fftobj->do_ifft(_tmp, _buf);
+	_fftobj->do_ifft(_tmp, buf);
 
-	// _buf now holds real output
+	// buf now holds real output
 }
 
-#endif // !FFTW
+#else // SimdFFT
+
+// SimdFFT reads and writes our packing directly, normalizing r2c output.
+
+void Offt::r2c(float *buf)
+{
+	_plan->r2c(buf, buf, _work);
+}
+
+void Offt::c2r(float *buf)
+{
+	_plan->c2r(buf, buf, _work);
+}
+
+#endif
 
 
 #include <stdio.h>
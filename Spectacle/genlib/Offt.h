@@ -2,11 +2,13 @@
 // See ``AUTHORS'' for a list of contributors. See ``LICENSE'' for
 // the license to this software and for a DISCLAIMER OF ALL WARRANTIES.
 
-// Offt provides an interface to two different FFT libraries: FFTW v3
-// <www.fftw.org> and FFTReal by Laurent de Soras <http://ldesoras.free.fr>.
-// This is a compile time choice, made via the configure script.  By default
-// you get FFTReal, unless you configure --with-fftw.  This code uses only
-// the float version of the fftw library, libfftw3f.
+// Offt provides an interface to three different FFT implementations: FFTW v3
+// <www.fftw.org>, FFTReal by Laurent de Soras <http://ldesoras.free.fr>, and
+// SimdFFT (see SimdFFT.h).  This is a compile time choice: define FFTW to use
+// fftw, or OFFT_FFTREAL to use FFTReal; otherwise you get SimdFFT, or FFTReal
+// when compiling for a target without SSE, where SimdFFT's scalar code is the
+// slower of the two.  This code uses only the float version of the fftw
+// library, libfftw3f.
 //
 // To use the Offt object, call the constructor with the FFT size, which must
 // be a power of 2.  Then call getbuf() to retrieve a pointer to the buffer
@@ -15,7 +17,8 @@
 // The format is the same as the old cmix fft routine, with pairs of real and
 // imaginary floats, and buf[1] replaced with the real value of Nyquist.
 // Muck around with the FFT complex data, then call c2r() to turn it back into
-// real-valued samples.
+// real-valued samples.  Or pass your own buffer of the same size to r2c()
+// and c2r().
 //
 // Check out Obucket also.  This class makes it fairly easy to decouple the
 // FFT length from your instrument's buffer size and to have a fixed latency,
@@ -23,10 +26,18 @@
 // example.
 //                                                     -John Gibson, 6/4/05
 
+#if !defined(FFTW) && !defined(OFFT_FFTREAL) && !(defined(__SSE__) \
+		|| defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1))
+#define OFFT_FFTREAL
+#endif
+
 #ifdef FFTW
 #include <fftw3.h>
-#else
+#elif defined(OFFT_FFTREAL)
 class FFTReal;
+#else
+#include <memory>
+class SimdFFT;
 #endif
 
 class Offt {
@@ -39,8 +50,13 @@ public:
 	Offt(int fftsize, unsigned int flags = kRealToComplex | kComplexToReal);
 	~Offt();
 	float *getbuf() const { return _buf; }
-	void r2c();
-	void c2r();
+	void r2c() { r2c(_buf); }
+	void c2r() { c2r(_buf); }
+
+	// Transform <buf>, which has the FFT size, in place of our own buffer,
+	// so that one Offt can serve several frames.
+	void r2c(float *buf);
+	void c2r(float *buf);
 
 private:
 	void printbuf(float *buf, char *msg);
@@ -50,9 +66,12 @@ private:
 #ifdef FFTW
 	fftwf_complex *_cbuf;
 	fftwf_plan _plan_r2c, _plan_c2r;
-#else
+#elif defined(OFFT_FFTREAL)
 	float *_tmp;
 	FFTReal *_fftobj;
+#else
+	float *_work;
+	std::shared_ptr<const SimdFFT> _plan;
 #endif
 };
 
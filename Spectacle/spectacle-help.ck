@@ -23,10 +23,20 @@
 // delay (dur) : set the same duration for all bands
 // eq (float) : set the same EQ value for all bands (value is +/- dB)
 // feedback (float) : set the same feedback value for all bands (-1.0 - 1.0)
+// delay, eq, feedback (float[]) : set every band at once, one value per band
+//                                 (delay in seconds); applied together at
+//                                 the next FFT frame
+// threaded (int) : 1 to process FFT frames on a worker thread; evens out CPU
+//                  at large fftlen, adds fftlen/overlap samples of latency
 //
 // table (string, string) : set delay, eq, or feedback tables to
 //                          random, ascending, or descending
 //    example: table ("delay", "random");
+//
+// Spectacle2, Spectacle4 and Spectacle8 take the same options and process
+// 2, 4 or 8 channels with one set of settings and tables, each channel with
+// its own delays; cheaper than one Spectacle per channel.
+//    example: adc => Spectacle2 spect2 => dac;
 
 // warning: use headphones or you'll get feedback!
 adc => Spectacle spect => dac;
@@ -0,0 +1,35 @@
+// SpectacleBus - several Spectacles sharing one FFT analysis
+//
+// Each Spectacle normally windows and transforms its input on its own.
+// Spectacles added to a SpectacleBus are processed by the bus instead:
+// the input is analyzed once, every Spectacle works on the same frames,
+// and their spectra are summed and resynthesized with one inverse FFT.
+//
+// Spectacles on a bus are silent on their own outputs, and must use the
+// bus's fftlen and overlap (default 1024 and 2).
+//
+// add (Spectacle) : add a Spectacle; returns 1 on success
+// remove (Spectacle) : take a Spectacle off the bus
+// size () : number of Spectacles on the bus
+// fftlen (int), overlap (int), threaded (int) : as for Spectacle
+
+SinOsc s => SpectacleBus bus => dac;
+220 => s.freq;
+0.3 => bus.gain;
+
+Spectacle echoes, shimmer;
+echoes.table("delay", "ascending");
+0.5 => echoes.feedback;
+shimmer.table("eq", "descending");
+50::ms => shimmer.delay;
+0.8 => shimmer.feedback;
+
+bus.add(echoes);
+bus.add(shimmer);
+<<< bus.size(), "Spectacles on the bus" >>>;
+
+while (true)
+{
+    Math.random2f(200, 800) => s.freq;
+    250::ms => now;
+}
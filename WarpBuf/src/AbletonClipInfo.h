@@ -1,6 +1,9 @@
 #pragma once
 
 #include "portable_endian.h"
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
 #include <vector>
 #include <string>
 #include <iostream>
@@ -26,6 +29,25 @@ public:
 
     std::vector<std::pair<double, double>> warp_markers;
 
+    // Without a warp file, treat the clip as a constant `bpm` for its whole duration.
+    // The loop_on and warp_on settings are preserved.
+    void assume_bpm(double bpm, double duration_seconds) {
+        const double end_in_beats = bpm * duration_seconds / 60.;
+        loop_start = 0.;
+        hidden_loop_start = 0.;
+        start_marker = 0.;
+        hidden_loop_end = end_in_beats;
+        loop_end = end_in_beats;
+        end_marker = end_in_beats;
+
+        // reset the warp markers based on the bpm:
+        warp_markers.clear();
+        warp_markers.push_back(std::make_pair(0, 0));
+        double beats = 1. / 32.;
+        double durSeconds = beats * (60. / bpm);
+        warp_markers.push_back(std::make_pair(durSeconds, beats));
+    }
+
     // For an input beat moment, return the moment's time in samples.
     int beat_to_sample(double beat, double sr) {
 
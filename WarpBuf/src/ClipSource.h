@@ -0,0 +1,51 @@
+#pragma once
+
+#include <sndfile.h>
+
+#include <algorithm>
+
+//-----------------------------------------------------------------------------
+// name: class ClipSource
+// desc: Where WarpBuf gets the frames it feeds to the stretcher: streamed from
+//       disk (DiskStreamer) or read from a preloaded clip (MemoryClipReader).
+//       seek() and setLoop() are called from the VM, read() from tick.
+//-----------------------------------------------------------------------------
+class ClipSource
+{
+public:
+    virtual ~ClipSource() {}
+
+    // Jump to a new read position.
+    virtual void seek(int frame) = 0;
+    // Loop region in file frames.
+    virtual void setLoop(bool loopOn, int loopStart, int loopEnd) = 0;
+    // Read up to `maxFrames` frames into non-interleaved `dst`. Returns the
+    // number of frames read (0 if none are ready yet). `wrapped` is set when
+    // the frames include a jump back to the loop start.
+    virtual int read(float** dst, int maxFrames, bool& wrapped) = 0;
+
+    // The read rules shared by all sources: frames outside the file are
+    // silent, and with looping on the read position goes back to the loop
+    // start once it reaches the loop end. Moves `pos` to the start of the next
+    // span (setting `wrap` if it jumped back) and returns how many of the
+    // `count` frames from there are either all inside or all outside the file.
+    static int nextSpan(int& pos, int count, sf_count_t frames,
+        bool loopOn, int loopStart, int loopEnd, bool& wrap)
+    {
+        wrap = false;
+        if (loopOn && pos >= loopEnd && loopEnd > loopStart) {
+            pos = loopStart;
+            wrap = true;
+        }
+        if (loopOn && loopEnd > pos) {
+            count = std::min(count, loopEnd - pos);
+        }
+        if (pos < 0) {
+            count = std::min(count, -pos);
+        }
+        else if (pos < frames) {
+            count = (int)std::min<sf_count_t>(count, frames - pos);
+        }
+        return count;
+    }
+};
@@ -0,0 +1,313 @@
+#include "DiskStreamer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+DiskStreamer::DiskStreamer()
+{
+    memset(&m_sfinfo, 0, sizeof(SF_INFO));
+}
+
+DiskStreamer::~DiskStreamer()
+{
+    stop();
+}
+
+void
+DiskStreamer::start(SNDFILE* sndfile, const SF_INFO& sfinfo, int frame)
+{
+    stop();
+
+    m_sndfile = sndfile;
+    m_sfinfo = sfinfo;
+    m_channels = sfinfo.channels;
+
+    m_ring.assign((size_t)s_ringFrames * m_channels, 0.f);
+    m_ringWrap.assign(s_ringFrames, 0);
+    m_loopCache.assign((size_t)s_loopCacheFrames * m_channels, 0.f);
+    m_loopCacheStart.store(-1);
+    m_loopCacheCount.store(0);
+    m_loopCacheSeq.store(0);
+    m_loopCacheForStart = m_loopCacheForEnd = -1;
+    m_jump.assign((size_t)s_loopCacheFrames * m_channels, 0.f);
+    m_jumpPos = m_jumpCount = 0;
+
+    m_writeIndex.store(0);
+    m_readIndex.store(0);
+    m_flushIndex.store(0);
+    m_readerGen = m_seekGen.load();
+    m_flushGen.store(m_readerGen);
+    m_consumerGen = m_expectGen = m_readerGen;
+    m_readPos = frame;
+    m_filePos = -1;
+
+    // the first frames are there before the first read()
+    produce(s_prefillFrames);
+
+    m_running = true;
+    m_thread = std::thread(&DiskStreamer::run, this);
+}
+
+void
+DiskStreamer::stop()
+{
+    if (m_thread.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(m_wakeMutex);
+            m_running = false;
+        }
+        m_wake.notify_one();
+        m_thread.join();
+    }
+    m_running = false;
+
+    if (m_sndfile) {
+        sf_close(m_sndfile);
+        m_sndfile = nullptr;
+    }
+}
+
+void
+DiskStreamer::seek(int frame)
+{
+    if (seekIntoLoopCache(frame)) {
+        return;
+    }
+
+    // Anywhere else: hand the position to the prefetch thread. read()
+    // returns nothing until it has decoded the first frames from there.
+    m_jumpPos = m_jumpCount = 0;
+    m_seekFrame.store(frame, std::memory_order_relaxed);
+    m_expectGen = m_seekGen.fetch_add(1, std::memory_order_release) + 1;
+    m_wake.notify_one();
+}
+
+// Copy the loop cache from `frame` on into m_jump and have the prefetch
+// thread carry on from the end of the cached frames. Returns false if
+// `frame` isn't cached, or the cache was being rewritten.
+bool
+DiskStreamer::seekIntoLoopCache(int frame)
+{
+    uint32_t seq = m_loopCacheSeq.load(std::memory_order_acquire);
+    if (seq & 1) {
+        return false;
+    }
+    int start = m_loopCacheStart.load(std::memory_order_relaxed);
+    int count = m_loopCacheCount.load(std::memory_order_relaxed);
+    if (frame < start || frame >= start + count) {
+        return false;
+    }
+    int n = start + count - frame;
+    memcpy(m_jump.data(), &m_loopCache[(size_t)(frame - start) * m_channels],
+        sizeof(float) * n * m_channels);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (m_loopCacheSeq.load(std::memory_order_relaxed) != seq) {
+        return false;
+    }
+
+    m_jumpPos = 0;
+    m_jumpCount = n;
+    m_seekFrame.store(start + count, std::memory_order_relaxed);
+    m_expectGen = m_seekGen.fetch_add(1, std::memory_order_release) + 1;
+    m_wake.notify_one();
+    return true;
+}
+
+void
+DiskStreamer::setLoop(bool loopOn, int loopStart, int loopEnd)
+{
+    m_loopOn.store(loopOn, std::memory_order_relaxed);
+    m_loopStart.store(loopStart, std::memory_order_relaxed);
+    m_loopEnd.store(loopEnd, std::memory_order_relaxed);
+}
+
+int
+DiskStreamer::read(float** dst, int maxFrames, bool& wrapped)
+{
+    wrapped = false;
+    if (!m_running) {
+        return 0;
+    }
+
+    // frames copied from the loop cache by a seek come first
+    int got = std::min(maxFrames, m_jumpCount - m_jumpPos);
+    for (int i = 0; i < got; i++) {
+        const float* frame = &m_jump[(size_t)(m_jumpPos + i) * m_channels];
+        for (int chan = 0; chan < m_channels; chan++) {
+            dst[chan][i] = frame[chan];
+        }
+    }
+    m_jumpPos += got;
+    if (got == maxFrames) {
+        return got;
+    }
+
+    uint64_t r = m_readIndex.load(std::memory_order_relaxed);
+
+    // Skip whatever was prefetched before the last seek; until the prefetch
+    // thread has seen that seek, nothing in the ring is ours.
+    if (m_consumerGen != m_expectGen) {
+        if (m_flushGen.load(std::memory_order_acquire) != m_expectGen) {
+            return got;
+        }
+        m_consumerGen = m_expectGen;
+        r = std::max(r, m_flushIndex.load(std::memory_order_relaxed));
+    }
+
+    uint64_t w = m_writeIndex.load(std::memory_order_acquire);
+    int count = (int)std::min<uint64_t>(maxFrames - got, w - r);
+
+    for (int i = 0; i < count; i++) {
+        int idx = (int)((r + i) & (s_ringFrames - 1));
+        wrapped = wrapped || m_ringWrap[idx];
+        const float* frame = &m_ring[(size_t)idx * m_channels];
+        for (int chan = 0; chan < m_channels; chan++) {
+            dst[chan][got + i] = frame[chan];
+        }
+    }
+
+    m_readIndex.store(r + count, std::memory_order_release);
+    return got + count;
+}
+
+void
+DiskStreamer::run()
+{
+    while (m_running) {
+        uint32_t seekGen = m_seekGen.load(std::memory_order_acquire);
+        if (seekGen != m_readerGen) {
+            // Start over from the seek position, and only let the reading
+            // side see it once the first frames from there are decoded.
+            m_readerGen = seekGen;
+            m_readPos = m_seekFrame.load(std::memory_order_relaxed);
+            m_flushIndex.store(m_writeIndex.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            produce(s_prefillFrames);
+            m_flushGen.store(seekGen, std::memory_order_release);
+            continue;
+        }
+
+        int loopStart = m_loopStart.load(std::memory_order_relaxed);
+        int loopEnd = m_loopEnd.load(std::memory_order_relaxed);
+        if (m_loopOn.load(std::memory_order_relaxed) &&
+            (loopStart != m_loopCacheForStart || loopEnd != m_loopCacheForEnd)) {
+            refreshLoopCache(loopStart, loopEnd);
+        }
+
+        if (space() >= s_chunkFrames) {
+            produce(s_chunkFrames);
+            continue;
+        }
+
+        // The ring is full: sleep until a seek or until the audio thread has
+        // had time to drain some frames. The audio thread never signals us,
+        // so that reading stays lock-free.
+        std::unique_lock<std::mutex> lock(m_wakeMutex);
+        if (m_running) {
+            m_wake.wait_for(lock, std::chrono::milliseconds(2));
+        }
+    }
+}
+
+// Free frames in the ring. Frames before the last flush index are never
+// read again, so they count as free even before the reading side has
+// skipped them. Called by the prefetch thread, or before it starts.
+int
+DiskStreamer::space()
+{
+    uint64_t w = m_writeIndex.load(std::memory_order_relaxed);
+    uint64_t r = std::max(m_readIndex.load(std::memory_order_acquire),
+        m_flushIndex.load(std::memory_order_relaxed));
+    return (int)(s_ringFrames - (w - r));
+}
+
+// Append up to `count` frames from the current read position to the ring.
+// Called by the prefetch thread, or before it starts.
+void
+DiskStreamer::produce(int count)
+{
+    uint64_t w = m_writeIndex.load(std::memory_order_relaxed);
+    count = std::min(count, space());
+
+    while (count > 0) {
+        bool wrap;
+        int pos = m_readPos;
+        int span = nextSpan(pos, count, m_sfinfo.frames,
+            m_loopOn.load(std::memory_order_relaxed),
+            m_loopStart.load(std::memory_order_relaxed),
+            m_loopEnd.load(std::memory_order_relaxed), wrap);
+        m_readPos = pos;
+
+        int idx = (int)(w & (s_ringFrames - 1));
+        // split the write where the ring storage wraps around
+        int first = std::min(span, s_ringFrames - idx);
+        decode(&m_ring[(size_t)idx * m_channels], m_readPos, first);
+        if (first < span) {
+            decode(&m_ring[0], m_readPos + first, span - first);
+        }
+        for (int i = 0; i < span; i++) {
+            m_ringWrap[(idx + i) & (s_ringFrames - 1)] = (i == 0 && wrap);
+        }
+
+        m_readPos += span;
+        w += span;
+        count -= span;
+        m_writeIndex.store(w, std::memory_order_release);
+    }
+}
+
+// Decode `count` interleaved frames starting at `frame`, which must either be
+// entirely inside the file or entirely outside of it.
+int
+DiskStreamer::decode(float* dst, int frame, int count)
+{
+    if (frame < 0 || frame >= m_sfinfo.frames) {
+        std::fill_n(dst, (size_t)count * m_channels, 0.f);
+        return count;
+    }
+
+    int cacheStart = m_loopCacheStart.load(std::memory_order_relaxed);
+    int cacheCount = m_loopCacheCount.load(std::memory_order_relaxed);
+    if (frame >= cacheStart && frame + count <= cacheStart + cacheCount) {
+        memcpy(dst, &m_loopCache[(size_t)(frame - cacheStart) * m_channels],
+            sizeof(float) * count * m_channels);
+        return count;
+    }
+
+    if (m_filePos != frame) {
+        sf_seek(m_sndfile, frame, SEEK_SET);
+    }
+    // Note that sf_readf_float can return -1 if no samples were read, so we take a max with zero.
+    int got = std::max<int>(0, (int)sf_readf_float(m_sndfile, dst, count));
+    m_filePos = frame + got;
+    std::fill(dst + (size_t)got * m_channels, dst + (size_t)count * m_channels, 0.f);
+    return count;
+}
+
+// Decode the start of the loop into the cache (no further than the loop
+// end, so a seek into it never has to wrap).
+void
+DiskStreamer::refreshLoopCache(int loopStart, int loopEnd)
+{
+    m_loopCacheForStart = loopStart;
+    m_loopCacheForEnd = loopEnd;
+
+    uint32_t seq = m_loopCacheSeq.load(std::memory_order_relaxed);
+    m_loopCacheSeq.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    // keep decode() from reading the cache while it is rewritten
+    m_loopCacheCount.store(0, std::memory_order_relaxed);
+
+    int count = 0;
+    if (loopStart >= 0 && loopStart < m_sfinfo.frames) {
+        count = (int)std::min<sf_count_t>(s_loopCacheFrames, m_sfinfo.frames - loopStart);
+        if (loopEnd > loopStart) {
+            count = std::min(count, loopEnd - loopStart);
+        }
+        decode(m_loopCache.data(), loopStart, count);
+    }
+
+    m_loopCacheStart.store(loopStart, std::memory_order_relaxed);
+    m_loopCacheCount.store(count, std::memory_order_relaxed);
+    m_loopCacheSeq.store(seq + 2, std::memory_order_release);
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include "ClipSource.h"
+
+#include <atomic>
+#include <cstdint>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+//-----------------------------------------------------------------------------
+// name: class DiskStreamer
+// desc: Decodes a sound file on a background thread into a lock-free
+//       single-producer/single-consumer ring of interleaved frames, so the
+//       audio thread never calls into libsndfile during playback. The
+//       prefetch thread follows the loop region itself (wrapping from the
+//       loop end to the loop start) and keeps the first frames of the loop
+//       decoded in memory. start() fills the start of the ring before
+//       returning, so read() has frames straight away. Seeks never touch
+//       the file: a seek into the cached loop start is served from the
+//       cache, any other is handed to the prefetch thread, and read()
+//       returns nothing until that has decoded the first frames.
+//-----------------------------------------------------------------------------
+class DiskStreamer : public ClipSource
+{
+public:
+    DiskStreamer();
+    ~DiskStreamer();
+
+    // Take ownership of an open sound file, decode the first frames from
+    // `frame` and start prefetching.
+    void start(SNDFILE* sndfile, const SF_INFO& sfinfo, int frame);
+    // Stop the prefetch thread and close the sound file.
+    void stop();
+
+    bool isOpen() { return m_sndfile != nullptr; }
+
+    // Frames already in the ring are dropped. Called on the reading side
+    // (never concurrently with read()); lock-free.
+    void seek(int frame) override;
+    void setLoop(bool loopOn, int loopStart, int loopEnd) override;
+    // Lock-free; returns fewer frames than asked for only when the prefetch
+    // thread has fallen behind or hasn't caught up with a seek yet.
+    int read(float** dst, int maxFrames, bool& wrapped) override;
+
+private:
+    // ring capacity in frames; must be a power of two
+    static const int s_ringFrames = 1 << 15;
+    // frames decoded per prefetch step
+    static const int s_chunkFrames = 1024;
+    // frames decoded from a new position before read() serves any of them
+    static const int s_prefillFrames = 8192;
+    // frames of the loop start kept decoded in memory
+    static const int s_loopCacheFrames = 1 << 14;
+
+    void run();
+    int space();
+    void produce(int count);
+    int decode(float* dst, int frame, int count);
+    void refreshLoopCache(int loopStart, int loopEnd);
+    bool seekIntoLoopCache(int frame);
+
+    SNDFILE* m_sndfile = nullptr;
+    SF_INFO m_sfinfo;
+    int m_channels = 0;
+
+    std::thread m_thread;
+    std::atomic<bool> m_running{ false };
+    std::mutex m_wakeMutex;
+    std::condition_variable m_wake;
+
+    // ring storage, written by the producer only
+    std::vector<float> m_ring;     // [s_ringFrames * m_channels]
+    std::vector<char> m_ringWrap;  // [s_ringFrames], 1 on the first frame after a wrap
+    std::atomic<uint64_t> m_writeIndex{ 0 };
+    std::atomic<uint64_t> m_readIndex{ 0 };
+
+    // seeks: the prefetch thread answers a new generation by publishing
+    // the ring index where frames for the new position begin
+    std::atomic<int> m_seekFrame{ 0 };
+    std::atomic<uint32_t> m_seekGen{ 0 };
+    std::atomic<uint64_t> m_flushIndex{ 0 };
+    std::atomic<uint32_t> m_flushGen{ 0 };
+    uint32_t m_readerGen = 0;   // prefetch thread
+    uint32_t m_consumerGen = 0; // reading side: last flush applied
+    uint32_t m_expectGen = 0;   // reading side: flush the ring must reach
+
+    // loop region
+    std::atomic<bool> m_loopOn{ false };
+    std::atomic<int> m_loopStart{ 0 };
+    std::atomic<int> m_loopEnd{ 0 };
+
+    // prefetch thread state
+    int m_readPos = 0;   // next frame to decode, may be outside the file
+    int m_filePos = -1;  // current libsndfile position
+
+    // the loop start cache, rewritten by the prefetch thread only and
+    // published like a seqlock: m_loopCacheSeq is odd while it is being
+    // rewritten, so the reading side can copy from it and check that it
+    // didn't change underneath
+    std::vector<float> m_loopCache;
+    std::atomic<int> m_loopCacheStart{ -1 };
+    std::atomic<int> m_loopCacheCount{ 0 };
+    std::atomic<uint32_t> m_loopCacheSeq{ 0 };
+    int m_loopCacheForStart = -1; // loop the cache was made for
+    int m_loopCacheForEnd = -1;
+
+    // reading side: frames copied from the loop cache by the last seek,
+    // played before the ring
+    std::vector<float> m_jump;
+    int m_jumpPos = 0;
+    int m_jumpCount = 0;
+};
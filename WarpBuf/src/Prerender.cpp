@@ -0,0 +1,271 @@
+#include "Prerender.h"
+
+#include <rubberband/RubberBandStretcher.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+
+std::mutex Prerender::s_mutex;
+std::map<std::string, std::weak_ptr<const RenderedLoop>> Prerender::s_renders;
+
+std::string
+Prerender::key(const RenderRequest& request)
+{
+    std::error_code ec;
+    auto mtime = std::filesystem::last_write_time(request.path, ec);
+
+    char settings[256];
+    snprintf(settings, sizeof(settings), "@%lld|%.17g|%.17g|%.17g|%.17g|%.17g",
+        ec ? 0LL : (long long)mtime.time_since_epoch().count(),
+        request.srate, request.bpm, request.pitchScale, request.loopStart, request.loopEnd);
+
+    std::string key = request.path + settings;
+    // the render depends on where the warp markers are, not just the file
+    for (auto& marker : request.clipInfo.warp_markers) {
+        snprintf(settings, sizeof(settings), "|%.17g:%.17g", marker.first, marker.second);
+        key += settings;
+    }
+    return key;
+}
+
+std::string
+Prerender::diskPath(const RenderRequest& request, const std::string& key)
+{
+    // FNV-1a, so the same render gets the same file name from run to run
+    uint64_t hash = 14695981039346656037ULL;
+    for (unsigned char c : key) {
+        hash ^= c;
+        hash *= 1099511628211ULL;
+    }
+    char name[64];
+    snprintf(name, sizeof(name), "warpbuf-%016llx.wav", (unsigned long long)hash);
+    return (std::filesystem::path(request.renderDir) / name).string();
+}
+
+std::shared_ptr<RenderedLoop>
+Prerender::readDisk(const std::string& path, int channels, int frames)
+{
+    if (!std::filesystem::exists(path)) {
+        return nullptr;
+    }
+
+    SF_INFO sfinfo;
+    memset(&sfinfo, 0, sizeof(SF_INFO));
+    SNDFILE* sndfile = sf_open(path.c_str(), SFM_READ, &sfinfo);
+    if (!sndfile) {
+        return nullptr;
+    }
+
+    std::shared_ptr<RenderedLoop> loop;
+    // a file left behind by an interrupted render is ignored
+    if (sfinfo.channels == channels && sfinfo.frames == frames) {
+        loop = std::make_shared<RenderedLoop>();
+        loop->channels = channels;
+        loop->frames = frames;
+        loop->data.assign((size_t)frames * channels, 0.f);
+        if (sf_readf_float(sndfile, loop->data.data(), frames) != frames) {
+            loop = nullptr;
+        }
+    }
+    sf_close(sndfile);
+    return loop;
+}
+
+void
+Prerender::writeDisk(const std::string& path, const RenderedLoop& loop, double srate)
+{
+    std::error_code ec;
+    std::filesystem::create_directories(std::filesystem::path(path).parent_path(), ec);
+
+    SF_INFO sfinfo;
+    memset(&sfinfo, 0, sizeof(SF_INFO));
+    sfinfo.samplerate = (int)srate;
+    sfinfo.channels = loop.channels;
+    sfinfo.format = SF_FORMAT_WAV | SF_FORMAT_FLOAT;
+
+    SNDFILE* sndfile = sf_open(path.c_str(), SFM_WRITE, &sfinfo);
+    if (!sndfile) {
+        std::cerr << "WARNING: Could not write pre-rendered clip \"" << path << "\": "
+            << sf_strerror(sndfile) << std::endl;
+        return;
+    }
+    sf_writef_float(sndfile, loop.data.data(), loop.frames);
+    sf_close(sndfile);
+}
+
+std::shared_ptr<RenderedLoop>
+Prerender::stretch(const RenderRequest& request, const CachedClip& clip, const std::atomic<bool>& cancel)
+{
+    using namespace RubberBand;
+
+    const int channels = clip.sfinfo.channels;
+    const double fileRate = clip.sfinfo.samplerate;
+    AbletonClipInfo clipInfo = request.clipInfo;
+
+    int inStart = clipInfo.beat_to_sample(request.loopStart, fileRate);
+    int inEnd = clipInfo.beat_to_sample(request.loopEnd, fileRate);
+    int inFrames = inEnd - inStart;
+    int outFrames = (int)std::lround((request.loopEnd - request.loopStart) * 60. / request.bpm * request.srate);
+    if (inFrames < 1 || outFrames < 1) {
+        return nullptr;
+    }
+
+    // De-interleave the loop region; positions outside the file are silent.
+    std::vector<std::vector<float>> input(channels, std::vector<float>(inFrames, 0.f));
+    for (int i = 0; i < inFrames; i++) {
+        sf_count_t frame = (sf_count_t)inStart + i;
+        if (frame < 0 || frame >= clip.sfinfo.frames) {
+            continue;
+        }
+        for (int c = 0; c < channels; c++) {
+            input[c][i] = clip.frames[frame * channels + c];
+        }
+    }
+
+    RubberBandStretcher::Options options = 0;
+    options |= RubberBandStretcher::OptionProcessOffline;
+    options |= RubberBandStretcher::OptionStretchPrecise;
+    options |= RubberBandStretcher::OptionThreadingNever;
+    options |= RubberBandStretcher::OptionPitchHighQuality;
+
+    RubberBandStretcher stretcher(fileRate, channels, options, (double)outFrames / inFrames, request.pitchScale);
+    stretcher.setExpectedInputDuration(inFrames);
+
+    // Pin every warp marker inside the loop to the output frame of its beat,
+    // so the render follows the clip's tempo changes like the real-time path.
+    std::map<size_t, size_t> keyFrames;
+    for (auto& marker : clipInfo.warp_markers) {
+        double beat = marker.second;
+        if (beat <= request.loopStart || beat >= request.loopEnd) {
+            continue;
+        }
+        int in = clipInfo.beat_to_sample(beat, fileRate) - inStart;
+        int out = (int)std::lround((beat - request.loopStart) * 60. / request.bpm * request.srate);
+        if (in > 0 && in < inFrames && out > 0 && out < outFrames) {
+            keyFrames[in] = out;
+        }
+    }
+    if (!keyFrames.empty()) {
+        stretcher.setKeyFrameMap(keyFrames);
+    }
+
+    const int chunk = 4096;
+    std::vector<const float*> in(channels);
+
+    for (int pos = 0; pos < inFrames; pos += chunk) {
+        if (cancel.load(std::memory_order_relaxed)) {
+            return nullptr;
+        }
+        int count = std::min(chunk, inFrames - pos);
+        for (int c = 0; c < channels; c++) {
+            in[c] = input[c].data() + pos;
+        }
+        stretcher.study(in.data(), count, pos + count >= inFrames);
+    }
+
+    auto loop = std::make_shared<RenderedLoop>();
+    loop->bpm = request.bpm;
+    loop->pitchScale = request.pitchScale;
+    loop->loopStart = request.loopStart;
+    loop->loopEnd = request.loopEnd;
+    loop->channels = channels;
+    loop->frames = outFrames;
+    loop->data.assign((size_t)outFrames * channels, 0.f);
+
+    std::vector<std::vector<float>> output(channels, std::vector<float>(chunk));
+    std::vector<float*> out(channels);
+    for (int c = 0; c < channels; c++) {
+        out[c] = output[c].data();
+    }
+
+    int written = 0;
+    auto drain = [&]() {
+        int avail;
+        while ((avail = stretcher.available()) > 0) {
+            int count = (int)stretcher.retrieve(out.data(), std::min(avail, chunk));
+            // the length of the offline output can be off by a few frames;
+            // it is trimmed (or padded with silence) to exactly one loop
+            for (int i = 0; i < count && written < outFrames; i++, written++) {
+                for (int c = 0; c < channels; c++) {
+                    loop->data[(size_t)written * channels + c] = output[c][i];
+                }
+            }
+        }
+    };
+
+    for (int pos = 0; pos < inFrames; pos += chunk) {
+        if (cancel.load(std::memory_order_relaxed)) {
+            return nullptr;
+        }
+        int count = std::min(chunk, inFrames - pos);
+        for (int c = 0; c < channels; c++) {
+            in[c] = input[c].data() + pos;
+        }
+        stretcher.process(in.data(), count, pos + count >= inFrames);
+        drain();
+    }
+    drain();
+
+    return loop;
+}
+
+std::shared_ptr<const RenderedLoop>
+Prerender::render(const RenderRequest& request, const std::atomic<bool>& cancel)
+{
+    std::string renderKey = key(request);
+
+    {
+        std::lock_guard<std::mutex> lock(s_mutex);
+        auto found = s_renders.find(renderKey);
+        if (found != s_renders.end()) {
+            if (auto loop = found->second.lock()) {
+                return loop;
+            }
+        }
+    }
+
+    std::shared_ptr<const CachedClip> clip = SampleCache::load(request.path);
+    if (!clip || clip->sfinfo.channels < 1) {
+        return nullptr;
+    }
+
+    std::shared_ptr<RenderedLoop> loop;
+    std::string path;
+    if (!request.renderDir.empty()) {
+        path = diskPath(request, renderKey);
+        int frames = (int)std::lround((request.loopEnd - request.loopStart) * 60. / request.bpm * request.srate);
+        loop = readDisk(path, clip->sfinfo.channels, frames);
+        if (loop) {
+            loop->bpm = request.bpm;
+            loop->pitchScale = request.pitchScale;
+            loop->loopStart = request.loopStart;
+            loop->loopEnd = request.loopEnd;
+        }
+    }
+
+    if (!loop) {
+        loop = stretch(request, *clip, cancel);
+        if (!loop) {
+            return nullptr;
+        }
+        if (!path.empty()) {
+            writeDisk(path, *loop, request.srate);
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(s_mutex);
+    for (auto it = s_renders.begin(); it != s_renders.end();) {
+        if (it->second.expired()) {
+            it = s_renders.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+    s_renders[renderKey] = loop;
+    return loop;
+}
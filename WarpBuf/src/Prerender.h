@@ -0,0 +1,67 @@
+#pragma once
+
+#include "SampleCache.h"
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+//-----------------------------------------------------------------------------
+// name: struct RenderRequest
+// desc: Everything that determines the sound of a pre-rendered loop.
+//-----------------------------------------------------------------------------
+struct RenderRequest
+{
+    std::string path;
+    AbletonClipInfo clipInfo;  // the instance's markers, which may differ from the file's
+    double srate = 44100.;     // output sample rate
+    double bpm = 120.;
+    double pitchScale = 1.;
+    double loopStart = 0.;     // beats
+    double loopEnd = 0.;       // beats
+    std::string renderDir;     // if not empty, renders are also kept here as .wav files
+};
+
+//-----------------------------------------------------------------------------
+// name: struct RenderedLoop
+// desc: One pass of a clip's loop region, stretched offline to a fixed tempo
+//       and transposition, ready to be played with a plain buffer read.
+//-----------------------------------------------------------------------------
+struct RenderedLoop
+{
+    double bpm;
+    double pitchScale;
+    double loopStart;
+    double loopEnd;
+    int channels;
+    int frames;
+    std::vector<float> data;  // interleaved: [frames * channels]
+};
+
+//-----------------------------------------------------------------------------
+// name: class Prerender
+// desc: Renders loops with RubberBand's offline mode, which looks at the whole
+//       loop before stretching it and sounds better than the real-time mode.
+//       Renders are cached in memory (shared by every WarpBuf asking for the
+//       same one) and, optionally, on disk.
+//-----------------------------------------------------------------------------
+class Prerender
+{
+public:
+    // Blocking; meant to be called from a background thread. Returns nullptr
+    // if the clip can't be read or `cancel` was set.
+    static std::shared_ptr<const RenderedLoop> render(const RenderRequest& request, const std::atomic<bool>& cancel);
+
+private:
+    static std::string key(const RenderRequest& request);
+    static std::string diskPath(const RenderRequest& request, const std::string& key);
+    static std::shared_ptr<RenderedLoop> readDisk(const std::string& path, int channels, int frames);
+    static void writeDisk(const std::string& path, const RenderedLoop& loop, double srate);
+    static std::shared_ptr<RenderedLoop> stretch(const RenderRequest& request, const CachedClip& clip, const std::atomic<bool>& cancel);
+
+    static std::mutex s_mutex;
+    static std::map<std::string, std::weak_ptr<const RenderedLoop>> s_renders;
+};
@@ -0,0 +1,169 @@
+#include "SampleCache.h"
+
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+
+std::mutex SampleCache::s_mutex;
+std::map<std::string, SampleCache::Entry> SampleCache::s_clips;
+
+std::shared_ptr<const CachedClip>
+SampleCache::load(const std::string& path)
+{
+    // Key on the modification time too, so an edited file is decoded again
+    // while instances still playing the old one keep their copy.
+    std::error_code ec;
+    auto mtime = std::filesystem::last_write_time(path, ec);
+    std::string key = path + "@" + std::to_string(ec ? 0 : (long long)mtime.time_since_epoch().count());
+
+    // The file is decoded without holding the lock, so that a big file
+    // doesn't hold up every other load. Whoever asks for it first decodes
+    // it; anyone asking for the same file meanwhile waits for that decode.
+    std::promise<std::shared_ptr<const CachedClip>> promise;
+    std::shared_future<std::shared_ptr<const CachedClip>> decoding;
+    {
+        std::lock_guard<std::mutex> lock(s_mutex);
+
+        // drop entries whose clips have been freed
+        for (auto it = s_clips.begin(); it != s_clips.end();) {
+            if (!it->second.decoding.valid() && it->second.clip.expired()) {
+                it = s_clips.erase(it);
+            }
+            else {
+                ++it;
+            }
+        }
+
+        Entry& entry = s_clips[key];
+        if (auto clip = entry.clip.lock()) {
+            return clip;
+        }
+        if (entry.decoding.valid()) {
+            decoding = entry.decoding;
+        }
+        else {
+            entry.decoding = promise.get_future().share();
+        }
+    }
+
+    if (decoding.valid()) {
+        return decoding.get();
+    }
+
+    std::shared_ptr<const CachedClip> clip;
+    try {
+        clip = decode(path);
+    }
+    catch (...) {
+        finish(key, nullptr);
+        promise.set_exception(std::current_exception());
+        throw;
+    }
+    finish(key, clip);
+    promise.set_value(clip);
+    return clip;
+}
+
+// Publish the outcome of a decode started by load(). A clip that couldn't
+// be decoded isn't kept, so the next load tries again.
+void
+SampleCache::finish(const std::string& key, std::shared_ptr<const CachedClip> clip)
+{
+    std::lock_guard<std::mutex> lock(s_mutex);
+    if (clip) {
+        s_clips[key] = Entry{ clip, {} };
+    }
+    else {
+        s_clips.erase(key);
+    }
+}
+
+std::shared_ptr<CachedClip>
+SampleCache::decode(const std::string& path)
+{
+    auto clip = std::make_shared<CachedClip>();
+    clip->path = path;
+    memset(&clip->sfinfo, 0, sizeof(SF_INFO));
+
+    SNDFILE* sndfile = sf_open(path.c_str(), SFM_READ, &clip->sfinfo);
+    if (!sndfile) {
+        std::cerr << "ERROR: Failed to open input file \"" << path << "\": "
+            << sf_strerror(sndfile) << std::endl;
+        return nullptr;
+    }
+
+    if (clip->sfinfo.samplerate == 0) {
+        std::cerr << "ERROR: File lacks sample rate in header" << std::endl;
+        sf_close(sndfile);
+        return nullptr;
+    }
+
+    clip->frames.assign((size_t)clip->sfinfo.frames * clip->sfinfo.channels, 0.f);
+    sf_count_t count = sf_readf_float(sndfile, clip->frames.data(), clip->sfinfo.frames);
+    sf_close(sndfile);
+    if (count < clip->sfinfo.frames) {
+        // keep what could be decoded; the rest stays silent
+        std::cerr << "WARNING: Could only decode " << std::max<sf_count_t>(0, count) << " of "
+            << clip->sfinfo.frames << " frames of \"" << path << "\"" << std::endl;
+    }
+
+    auto asd_path = path + std::string(".asd");
+    if (std::filesystem::exists(asd_path)) {
+        try {
+            clip->hasWarpFile = clip->clipInfo.readWarpFile(asd_path.c_str());
+        }
+        catch (const std::exception& e) {
+            std::cerr << e.what() << std::endl;
+            clip->hasWarpFile = false;
+        }
+    }
+
+    return clip;
+}
+
+MemoryClipReader::MemoryClipReader(std::shared_ptr<const CachedClip> clip, int frame) :
+    m_clip(clip),
+    m_readPos(frame)
+{
+}
+
+void
+MemoryClipReader::setLoop(bool loopOn, int loopStart, int loopEnd)
+{
+    m_loopOn = loopOn;
+    m_loopStart = loopStart;
+    m_loopEnd = loopEnd;
+}
+
+int
+MemoryClipReader::read(float** dst, int maxFrames, bool& wrapped)
+{
+    wrapped = false;
+    const int channels = m_clip->sfinfo.channels;
+    const sf_count_t frames = m_clip->sfinfo.frames;
+
+    int done = 0;
+    while (done < maxFrames) {
+        bool wrap;
+        int count = nextSpan(m_readPos, maxFrames - done, frames, m_loopOn, m_loopStart, m_loopEnd, wrap);
+        wrapped = wrapped || wrap;
+
+        if (m_readPos < 0 || m_readPos >= frames) {
+            for (int chan = 0; chan < channels; chan++) {
+                std::fill_n(dst[chan] + done, count, 0.f);
+            }
+        }
+        else {
+            const float* src = &m_clip->frames[(size_t)m_readPos * channels];
+            for (int i = 0; i < count; i++) {
+                for (int chan = 0; chan < channels; chan++) {
+                    dst[chan][done + i] = src[i * channels + chan];
+                }
+            }
+        }
+
+        m_readPos += count;
+        done += count;
+    }
+    return done;
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "AbletonClipInfo.h"
+#include "ClipSource.h"
+
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+//-----------------------------------------------------------------------------
+// name: struct CachedClip
+// desc: A sound file decoded entirely into memory, together with the warp
+//       information parsed from its .asd file.
+//-----------------------------------------------------------------------------
+struct CachedClip
+{
+    std::string path;
+    SF_INFO sfinfo;
+    std::vector<float> frames;  // interleaved: [sfinfo.frames * sfinfo.channels]
+    AbletonClipInfo clipInfo;
+    bool hasWarpFile = false;
+};
+
+//-----------------------------------------------------------------------------
+// name: class SampleCache
+// desc: Process-wide cache of decoded clips. Every WarpBuf that preloads the
+//       same file (with the same modification time) shares one CachedClip;
+//       it is freed when the last of them lets go of it.
+//-----------------------------------------------------------------------------
+class SampleCache
+{
+public:
+    // Return the decoded clip at `path`, decoding it on first use (other
+    // loads of the same file wait for that decode, loads of other files
+    // don't). Returns nullptr if the file can't be read.
+    static std::shared_ptr<const CachedClip> load(const std::string& path);
+
+private:
+    struct Entry {
+        std::weak_ptr<const CachedClip> clip;
+        // valid while the first load() of the file is decoding it
+        std::shared_future<std::shared_ptr<const CachedClip>> decoding;
+    };
+
+    static std::shared_ptr<CachedClip> decode(const std::string& path);
+    static void finish(const std::string& key, std::shared_ptr<const CachedClip> clip);
+
+    // guards s_clips only; files are decoded outside of it
+    static std::mutex s_mutex;
+    static std::map<std::string, Entry> s_clips;
+};
+
+//-----------------------------------------------------------------------------
+// name: class MemoryClipReader
+// desc: Reads frames from a preloaded clip; no file I/O during playback.
+//-----------------------------------------------------------------------------
+class MemoryClipReader : public ClipSource
+{
+public:
+    MemoryClipReader(std::shared_ptr<const CachedClip> clip, int frame);
+
+    void seek(int frame) override { m_readPos = frame; }
+    void setLoop(bool loopOn, int loopStart, int loopEnd) override;
+    int read(float** dst, int maxFrames, bool& wrapped) override;
+
+private:
+    std::shared_ptr<const CachedClip> m_clip;
+    int m_readPos;
+    bool m_loopOn = false;
+    int m_loopStart = 0;
+    int m_loopEnd = 0;
+};
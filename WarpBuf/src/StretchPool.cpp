@@ -0,0 +1,107 @@
+#include "StretchPool.h"
+
+StretchPool&
+StretchPool::instance()
+{
+    static StretchPool pool;
+    return pool;
+}
+
+StretchPool::StretchPool()
+{
+    // leave one core for ChucK's audio thread
+    int count = (int)std::thread::hardware_concurrency() - 1;
+    if (count < 1) {
+        count = 1;
+    }
+    for (int i = 0; i < count; i++) {
+        m_threads.emplace_back(&StretchPool::run, this);
+    }
+}
+
+StretchPool::~StretchPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_running = false;
+    }
+    m_wake.notify_all();
+    for (auto& thread : m_threads) {
+        thread.join();
+    }
+}
+
+void
+StretchPool::submit(StretchJob* job)
+{
+    job->m_done.store(false, std::memory_order_relaxed);
+    job->m_next = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_tail) {
+            m_tail->m_next = job;
+        }
+        else {
+            m_head = job;
+        }
+        m_tail = job;
+    }
+    m_wake.notify_one();
+}
+
+void
+StretchPool::finish(StretchJob* job)
+{
+    bool claimed = false;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        StretchJob* prev = nullptr;
+        for (StretchJob* it = m_head; it; prev = it, it = it->m_next) {
+            if (it == job) {
+                if (prev) {
+                    prev->m_next = job->m_next;
+                }
+                else {
+                    m_head = job->m_next;
+                }
+                if (m_tail == job) {
+                    m_tail = prev;
+                }
+                claimed = true;
+                break;
+            }
+        }
+    }
+
+    if (claimed) {
+        job->run();
+        job->m_done.store(true, std::memory_order_release);
+        return;
+    }
+
+    while (!job->m_done.load(std::memory_order_acquire)) {
+        std::this_thread::yield();
+    }
+}
+
+void
+StretchPool::run()
+{
+    while (true) {
+        StretchJob* job = nullptr;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [this] { return !m_running || m_head != nullptr; });
+            if (!m_running) {
+                return;
+            }
+            job = m_head;
+            m_head = job->m_next;
+            if (!m_head) {
+                m_tail = nullptr;
+            }
+        }
+        job->run();
+        job->m_done.store(true, std::memory_order_release);
+    }
+}
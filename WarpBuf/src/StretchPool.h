@@ -0,0 +1,61 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//-----------------------------------------------------------------------------
+// name: class StretchJob
+// desc: A unit of work for the StretchPool. Jobs are owned by the caller and
+//       linked into the pool's queue in place, so submitting one never
+//       allocates on the audio thread.
+//-----------------------------------------------------------------------------
+class StretchJob
+{
+public:
+    virtual ~StretchJob() {}
+    virtual void run() = 0;
+
+private:
+    friend class StretchPool;
+    StretchJob* m_next = nullptr;
+    std::atomic<bool> m_done{ true };
+};
+
+//-----------------------------------------------------------------------------
+// name: class StretchPool
+// desc: Worker threads shared by every WarpBuf in the process, so a session
+//       with many clips spreads its stretching over the available cores
+//       instead of running it all on ChucK's audio thread.
+//-----------------------------------------------------------------------------
+class StretchPool
+{
+public:
+    static StretchPool& instance();
+
+    ~StretchPool();
+
+    // Queue a job. The job must not already be pending.
+    void submit(StretchJob* job);
+    // Wait until the job has run. If no worker has picked it up yet, it is
+    // run on the calling thread instead, so a busy pool never leaves the
+    // caller waiting on someone else's work.
+    void finish(StretchJob* job);
+    // true once the job has run; never waits
+    bool done(StretchJob* job) { return job->m_done.load(std::memory_order_acquire); }
+
+    int workers() { return (int)m_threads.size(); }
+
+private:
+    StretchPool();
+    void run();
+
+    std::vector<std::thread> m_threads;
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    StretchJob* m_head = nullptr;
+    StretchJob* m_tail = nullptr;
+    bool m_running = true;
+};
@@ -6,19 +6,25 @@ WarpBufChugin::WarpBufChugin(t_CKFLOAT srate)
     // sample rate
     m_srate = srate;
     memset(&sfinfo, 0, sizeof(SF_INFO));
+    m_job.owner = this;
+    m_restartJob.owner = this;
 
     this->recreateStretcher();
 }
 
 WarpBufChugin::~WarpBufChugin()
 {
+    stopRender();
+    waitForJob();
+    m_source.reset();
     clearBufs();
-    m_rbstretcher.release();
+    m_rbstretcher.reset();
 }
 
 void
 WarpBufChugin::reset() {
-    m_rbstretcher->reset();
+    stopSwitch();
+    restartLive(m_playHeadBeats);
 }
 
 void
@@ -38,7 +44,42 @@ WarpBufChugin::recreateStretcher() {
         sfinfo.channels,
         options,
         1.,
-        1.);
+        m_pitchScale);
+
+    m_blockPos = m_blockCount = 0;
+    m_startDiscard = 0;
+    if (sfinfo.channels == 0) {
+        return;
+    }
+    allocate(sfinfo.channels);
+    // the file is being (re)read anyway, so there's no point in queueing this
+    restartStretcher(blockParams(m_playHeadBeats));
+}
+
+// Start the stretcher afresh for output from the block `params` describes.
+// In real-time mode RubberBand wants getPreferredStartPad() frames of silence
+// ahead of the first input frame, and then delays its output by
+// getStartDelay() frames. The pad is fed here and renderBlock drops the
+// delay, so the first frame played is the one the source was seeked to.
+// Only touches the stretcher and m_nonInterleavedBuffer, so it can run on a
+// StretchPool worker (see restartLive).
+void
+WarpBufChugin::restartStretcher(const BlockParams& params) {
+
+    m_rbstretcher->reset();
+    m_rbstretcher->setTimeRatio(params.ratio);
+    m_rbstretcher->setPitchScale(params.pitchScale);
+
+    for (int c = 0; c < m_channels; c++) {
+        std::fill_n(m_nonInterleavedBuffer[c], interleaved_buffer_size, 0.f);
+    }
+    int pad = (int)m_rbstretcher->getPreferredStartPad();
+    while (pad > 0) {
+        int count = std::min(pad, interleaved_buffer_size);
+        m_rbstretcher->process(m_nonInterleavedBuffer, count, false);
+        pad -= count;
+    }
+    m_startDiscard = (int)m_rbstretcher->getStartDelay();
 }
 
 // clear
@@ -53,7 +94,13 @@ WarpBufChugin::clearBufs()
     }
     CK_SAFE_DELETE_ARRAY(m_retrieveBuffer);
 
-    CK_SAFE_DELETE_ARRAY(m_interleavedBuffer);
+    if (m_aheadBuffer != NULL)
+    {
+        for (int i = 0; i < m_channels; i++) {
+            CK_SAFE_DELETE_ARRAY(m_aheadBuffer[i]);
+        }
+    }
+    CK_SAFE_DELETE_ARRAY(m_aheadBuffer);
 
     if (m_nonInterleavedBuffer != NULL)
     {
@@ -64,31 +111,35 @@ WarpBufChugin::clearBufs()
     CK_SAFE_DELETE_ARRAY(m_nonInterleavedBuffer);
 }
 
-// Allocate the buffers if the number of channels or number of samples changed.
+// Allocate the buffers if the number of channels changed.
 void
-WarpBufChugin::allocate(int numChannels, int numSamples)
+WarpBufChugin::allocate(int numChannels)
 {
-    if (m_numAllocated == numSamples && m_channels == numChannels) {
+    if (m_channels == numChannels) {
         return;
     }
 
     // clear
+    waitForJob();
     clearBufs();
 
     m_channels = numChannels;
-    m_numAllocated = numSamples;
+    m_blockPos = m_blockCount = 0;
 
     m_nonInterleavedBuffer = new float* [m_channels];
     for (int i = 0; i < m_channels; i++) {
         m_nonInterleavedBuffer[i] = new float[interleaved_buffer_size];
     }
-       
-    m_interleavedBuffer = new float[m_channels * interleaved_buffer_size];
-    
+
     m_retrieveBuffer = new float * [m_channels];
     // allocate buffers for each channel
     for (int i = 0; i < m_channels; i++) {
-        m_retrieveBuffer[i] = new float[numSamples];
+        m_retrieveBuffer[i] = new float[s_blockFrames];
+    }
+
+    m_aheadBuffer = new float * [m_channels];
+    for (int i = 0; i < m_channels; i++) {
+        m_aheadBuffer[i] = new float[s_blockFrames];
     }
 }
 
@@ -101,17 +152,47 @@ void
 WarpBufChugin::setPlayhead(double playhead) {
 
     m_playHeadBeats = playhead;
-    sfReadPos = m_clipInfo.beat_to_sample(m_playHeadBeats, sfinfo.samplerate);
-    sf_seek(sndfile, std::max(0, sfReadPos), SEEK_SET);
-    // seeking doesn't change sfReadPos
+    // pick the position in the render back up from the new playhead
+    m_playingRendered = false;
+    stopSwitch();
+    // don't keep playing frames from before the jump
+    restartLive(m_playHeadBeats);
+}
+
+// Move live playback to `beat` without blocking: the source is pointed at it
+// (a DiskStreamer hands the seek to its prefetch thread) and the stretcher is
+// restarted on the StretchPool. tick plays silence until liveReady(), and
+// after that until the source has frames from the new position.
+void
+WarpBufChugin::restartLive(double beat) {
+
+    waitForJob();
+    // drop whatever the stretcher had produced before
+    m_blockPos = m_blockCount = 0;
+    if (!m_source || sfinfo.channels == 0) {
+        return;
+    }
+    allocate(sfinfo.channels);
+
+    m_source->seek(m_clipInfo.beat_to_sample(beat, sfinfo.samplerate));
+    m_restartJob.params = blockParams(beat);
+    m_restartPending = true;
+    StretchPool::instance().submit(&m_restartJob);
+}
+
+// true once the restart queued by restartLive has run
+bool
+WarpBufChugin::liveReady() {
+    if (m_restartPending && StretchPool::instance().done(&m_restartJob)) {
+        m_restartPending = false;
+    }
+    return !m_restartPending;
 }
 
 double
 WarpBufChugin::getTranspose() {
 
-    double scale = m_rbstretcher->getPitchScale();
-
-    double transpose = 12. * std::log2(scale);
+    double transpose = 12. * std::log2(m_pitchScale);
 
     return transpose;
 }
@@ -119,9 +200,8 @@ WarpBufChugin::getTranspose() {
 void
 WarpBufChugin::setTranspose(double transpose) {
 
-    double scale = std::pow(2., transpose/12.);
-
-    m_rbstretcher->setPitchScale(scale);
+    // applied to the stretcher at the next block boundary
+    m_pitchScale = std::pow(2., transpose/12.);
 }
 
 double
@@ -138,152 +218,418 @@ WarpBufChugin::setBPM(double bpm) {
     m_bpm = bpm;
 }
 
+// Work out the stretcher settings for the block that starts at `beat`.
+// Looking up the clip tempo under the playhead is only done here, once per
+// block, rather than on every frame.
+WarpBufChugin::BlockParams
+WarpBufChugin::blockParams(double beat)
+{
+    BlockParams params;
+
+    double _;
+    double clipBPM = -1.;
+
+    m_clipInfo.beat_to_seconds(beat, _, clipBPM);
+
+    params.ratio = (m_srate / sfinfo.samplerate);
+    if (clipBPM > 0) {
+        params.ratio *= clipBPM / m_bpm;
+    }
+    params.pitchScale = m_pitchScale;
+    params.loopOn = m_clipInfo.loop_on;
+    params.loopStart = m_clipInfo.beat_to_sample(m_clipInfo.loop_start, sfinfo.samplerate);
+    params.loopEnd = m_clipInfo.beat_to_sample(m_clipInfo.loop_end, sfinfo.samplerate);
+
+    return params;
+}
+
+// Pull one block of output from the stretcher into `dst` and return the
+// number of frames retrieved. Only touches the stretcher, the clip source
+// and m_nonInterleavedBuffer, so it can run on a StretchPool worker.
+int
+WarpBufChugin::renderBlock(const BlockParams& params, float** dst)
+{
+    if (params.ratio != m_rbstretcher->getTimeRatio()) {
+        m_rbstretcher->setTimeRatio(params.ratio);
+    }
+    if (params.pitchScale != m_rbstretcher->getPitchScale()) {
+        m_rbstretcher->setPitchScale(params.pitchScale);
+    }
+
+    m_source->setLoop(params.loopOn, params.loopStart, params.loopEnd);
+
+    // After a restart, the stretcher's start delay is thrown away before
+    // anything is played.
+    while (m_startDiscard > 0) {
+        int count = std::min(m_startDiscard, s_blockFrames);
+        if (!feedStretcher(count)) {
+            return 0;
+        }
+        m_startDiscard -= (int)m_rbstretcher->retrieve(dst, count);
+    }
+
+    feedStretcher(s_blockFrames);
+    return (int)m_rbstretcher->retrieve(dst, s_blockFrames);
+}
+
+// Feed the stretcher from the clip source until it has `frames` frames of
+// output available. The source already took care of looping and of writing
+// zeros for positions outside the file. Returns false if the source ran dry
+// first: the prefetch thread has fallen behind the disk, and rather than
+// feed the stretcher anything that isn't in the file, tick plays silence
+// until it catches up.
+bool
+WarpBufChugin::feedStretcher(int frames)
+{
+    while (m_rbstretcher->available() < frames) {
+        bool wrapped = false;
+        int count = m_source->read(m_nonInterleavedBuffer, interleaved_buffer_size, wrapped);
+        if (count < 1) {
+            return false;
+        }
+        m_rbstretcher->process(m_nonInterleavedBuffer, count, false);
+    }
+    return true;
+}
+
+// Make the next block of output current in m_retrieveBuffer.
+// In threaded mode the next block was rendered on the StretchPool while
+// the previous one played; it is swapped in and the one after it is queued.
+void
+WarpBufChugin::fillBlock()
+{
+    if (m_jobPending) {
+        StretchPool::instance().finish(&m_job);
+        m_jobPending = false;
+        std::swap(m_retrieveBuffer, m_aheadBuffer);
+        m_blockCount = m_job.count;
+    }
+    else {
+        m_blockCount = renderBlock(blockParams(m_playHeadBeats), m_retrieveBuffer);
+    }
+    m_blockPos = 0;
+
+    if (m_threaded) {
+        // settings for the block after this one
+        double blockBeats = m_bpm * double(s_blockFrames) / (60. * m_srate);
+        m_job.params = blockParams(m_playHeadBeats + blockBeats);
+        m_jobPending = true;
+        StretchPool::instance().submit(&m_job);
+    }
+}
+
+// Wait for the restart or block queued on the StretchPool (if any), throwing
+// a block away. Anything that touches the stretcher, the clip source or the
+// buffers from the ChucK thread has to call this first.
+void
+WarpBufChugin::waitForJob()
+{
+    if (m_restartPending) {
+        StretchPool::instance().finish(&m_restartJob);
+        m_restartPending = false;
+    }
+    if (m_jobPending) {
+        StretchPool::instance().finish(&m_job);
+        m_jobPending = false;
+    }
+}
+
 void
 WarpBufChugin::tick(SAMPLE* in, SAMPLE* out, int nframes)
 {
-    allocate(sfinfo.channels, nframes);
+    allocate(sfinfo.channels);
 
     bool past_end_marker_and_loop_off = m_playHeadBeats > m_clipInfo.end_marker && !m_clipInfo.loop_on;
     // If our sound file has zero channels, or for some reason the number of allocated channels (m_channels)
     // is zero, or play is disabled, or (loop is off and our playhead measured in beats is greater than
     // our end marker measured in beats)
-    if (sfinfo.channels == 0 || m_channels == 0 || (!m_play) || past_end_marker_and_loop_off) {
+    if (!m_source || sfinfo.channels == 0 || m_channels == 0 || (!m_play) || past_end_marker_and_loop_off) {
         // Write zeros into our output buffer and return.
         // Note that we are not feeding the zeros to the stretcher.
         std::fill_n(out, nframes * WARPBUF_MAX_OUTPUTS, 0.f);
         return;
     }
 
-    double _;
-    double clipBPM = -1.;
+    if (m_renderDone.load(std::memory_order_acquire)) {
+        m_rendered = std::move(m_renderResult);
+        m_renderDone.store(false, std::memory_order_relaxed);
+    }
 
-    m_clipInfo.beat_to_seconds(m_playHeadBeats, _, clipBPM);
+    if (renderedMatches()) {
+        if (!m_playingRendered && m_playHeadBeats >= m_clipInfo.loop_start && m_playHeadBeats < m_clipInfo.loop_end) {
+            m_renderPos = (int)std::lround((m_playHeadBeats - m_clipInfo.loop_start) * 60. / m_bpm * m_srate);
+            m_renderPos = std::min(std::max(m_renderPos, 0), m_rendered->frames - 1);
+            m_playingRendered = true;
+            stopSwitch();
+        }
+    }
+    else if (m_playingRendered) {
+        // the settings moved away from the render
+        leaveRender();
+    }
 
-    int loop_start_sample = m_clipInfo.beat_to_sample(m_clipInfo.loop_start, sfinfo.samplerate);
-    int loop_end_sample = m_clipInfo.beat_to_sample(m_clipInfo.loop_end, sfinfo.samplerate);
+    // beats the playhead moves per frame played
+    double beatsPerFrame = m_bpm / (60. * m_srate);
 
-    double ratio = (m_srate / sfinfo.samplerate);
-    if (clipBPM > 0) {
-        ratio *= clipBPM / m_bpm;
-    }
-    m_rbstretcher->setTimeRatio(ratio);
-
-    // progress the playhead based on the number of frames.
-    // Note that it would be slightly better to do this more incrementally inside
-    // a loop, but that's hard to conceptualize with how a rubber band stretcher
-    // makes samples retrievable.
-    m_playHeadBeats += m_bpm * double(nframes) / (60. * m_srate);
-
-    int count = 0;
-    int numAvailable = m_rbstretcher->available();
-    int allowedReadCount = 0;
-    // In a while loop, we read from the sound file into an interleaved buffer and count the number of samples we read in a "count" variable.
-    // We also track our read position integer in `sfReadPos`.
-    // If count is zero:
-    //   Then maybe we want to loop around and update our read position.
-    //   Or maybe we have some reason to write zeros into the interleaved buffer (discussed in code far below).
-    // Once we've read new samples or written zeros into tje interleaved buffer, we copy it into a non-interleaved buffer.
-    // Then we tell Rubber Band to process the non-interleaved buffer, and we wait for enough retrievable samples.
-    // When there are enough samples, we retrieve them and copy them into chuck's output buffer.
-    // Note that ChucK pretty much only asks for one frame at a time (`nframes` is 1).
-    while (numAvailable < nframes) {
-
-        // If our sample read position is in bounds given our sound file
-        if (sfReadPos > -1 && sfReadPos < sfinfo.frames) {
-
-            // We might want to artificially restrict the number of samples to try to read from the soundfile.
-            if (m_clipInfo.loop_on) {
-                // If we're looping, we want to prevent reading samples beyond the loop end sample point.
-                // If we're not beyond the loop end sample read point, we can greedily grab `interleaved_buffer_size` samples.
-                allowedReadCount = std::min(interleaved_buffer_size, loop_end_sample - sfReadPos);
-            }
-            else {
-                // Not looping, so greedily grab `interleaved_buffer_size` samples.
-                allowedReadCount = interleaved_buffer_size;
+    if (m_playingRendered) {
+        // plain buffer read from the pre-rendered loop
+        const float* data = m_rendered->data.data();
+        for (int i = 0; i < nframes; i++) {
+            for (int chan = 0; chan < m_channels; chan++) {
+                out[chan + WARPBUF_MAX_OUTPUTS * i] = data[m_renderPos * m_channels + chan];
             }
-            if (allowedReadCount) {
-                count = sf_readf_float(sndfile, m_interleavedBuffer, allowedReadCount);
-                // Note that sf_readf_float can return -1 if no samples were read, so we take a max with zero.
-                count = std::max(0, count);
-                sfReadPos += count;
+            m_renderPos++;
+            // the playhead stays on the frame the render plays next
+            if (m_renderPos >= m_rendered->frames) {
+                m_renderPos = 0;
+                m_playHeadBeats = m_clipInfo.loop_start;
             }
             else {
-                count = 0;
+                m_playHeadBeats += beatsPerFrame;
             }
         }
-        else {
-            // Our sfReadPos is out of bounds, so we didn't "read" any samples: set count to zero.
-            // We will probably want to write zeros into the buffer given to Rubber Band.
-            count = 0;
-        }
-
-        if (count < 1) {
+        return;
+    }
 
-            bool do_write_zeros = false;
-            if (m_clipInfo.loop_on) {
-
-                if ((sfReadPos >= loop_end_sample) && (loop_end_sample > loop_start_sample)) {
-                    // Our read position reached the loop_end_sample, so we should go back to the loop start.
-                    // This will change sfReadPos and hopefully put it in bounds.
-                    setPlayhead(m_clipInfo.loop_start);
-                }
-                else {
-                    // Our read position didn't reach the loop_end sample. Maybe the loop_end_sample is actually
-                    // to the right of the bounds of the file. We have to write zeros to kill time until we get there.
-                    // Or maybe the loop_end is less than the loop_start, and we should write zeros.
-                    do_write_zeros = true;
-                }
+    // ChucK pretty much only asks for one frame at a time (`nframes` is 1),
+    // so serve frames from the current block and only go back to the
+    // stretcher when it runs out.
+    for (int i = 0; i < nframes; i++) {
+        float* frame = out + WARPBUF_MAX_OUTPUTS * i;
+        if (m_switching) {
+            if (m_switchLeft == 0) {
+                takeOver();
             }
-
-            // If we decided earlier to write zeros, or our read pos is out of bounds, then we should write one frame of zeros.
-            if (do_write_zeros || sfReadPos < 0 || sfReadPos >= sfinfo.frames) {
-                count = 1;
-                sfReadPos += count;
-                // fill with zeros
-                for (int c = 0; c < m_channels; c++) {
-                    for (int i = 0; i < count; i++) {
-                        m_interleavedBuffer[i * m_channels + c] = 0.;
-                    }
-                }
+            else if (m_switchLeft < 0 && liveReady()) {
+                aimSwitch();
             }
-            else {
-                // We didn't write zeros (or anything) to the interleaved buffer, so we have to "continue"
-                // in order to not copy the invalid interleaved buffer to the nonInterleavedBuffer.
-                // However, our read pos is in bounds, so we can expect to get samples next time.
-                continue;
+        }
+        if (m_switching) {
+            // still on the render being left
+            std::fill_n(frame, m_channels, 0.f);
+            mixFadeRender(frame, 1.f);
+            if (m_switchLeft > 0) {
+                m_switchLeft--;
             }
         }
-        
-        // Copy from the interleaved buffer to the non interleaved buffer.
-        for (int chan = 0; chan < m_channels; ++chan) {
-            for (int i = 0; i < count; ++i) {
-                m_nonInterleavedBuffer[chan][i] = m_interleavedBuffer[i * m_channels + chan];
+        else {
+            if (!liveReady()) {
+                // The stretcher is still being restarted: play silence for
+                // the rest of this tick, with the playhead held where it
+                // restarts.
+                std::fill_n(frame, (nframes - i) * WARPBUF_MAX_OUTPUTS, 0.f);
+                break;
+            }
+            if (m_blockPos >= m_blockCount) {
+                fillBlock();
+            }
+            if (m_blockPos >= m_blockCount) {
+                // Underrun: play silence for the rest of this tick. The
+                // source and the playhead stay put, so playback picks up
+                // where it was.
+                std::fill_n(frame, (nframes - i) * WARPBUF_MAX_OUTPUTS, 0.f);
+                break;
+            }
+            // out needs to receive interleaved channels.
+            for (int chan = 0; chan < m_channels; chan++) {
+                frame[chan] = m_retrieveBuffer[chan][m_blockPos];
             }
+            if (m_fadeLeft > 0) {
+                // still crossfading from the render we just left
+                mixFadeRender(frame, m_fadeLeft / (float)s_fadeFrames);
+                m_fadeLeft--;
+            }
+            m_blockPos++;
+        }
+        // The playhead follows the frames played rather than the source,
+        // which runs ahead of them by whatever the stretcher holds.
+        m_playHeadBeats += beatsPerFrame;
+        if (m_clipInfo.loop_on && m_clipInfo.loop_end > m_clipInfo.loop_start &&
+            m_playHeadBeats >= m_clipInfo.loop_end) {
+            m_playHeadBeats = m_clipInfo.loop_start;
         }
+    }
+}
 
-        m_rbstretcher->process(m_nonInterleavedBuffer, count, false);
-        numAvailable = m_rbstretcher->available();
+bool
+WarpBufChugin::renderedMatches() {
+    return m_rendered &&
+        m_clipInfo.loop_on &&
+        m_rendered->channels == m_channels &&
+        m_rendered->bpm == m_bpm &&
+        m_rendered->pitchScale == m_pitchScale &&
+        m_rendered->loopStart == m_clipInfo.loop_start &&
+        m_rendered->loopEnd == m_clipInfo.loop_end;
+}
+
+// Stop playing from the render without a gap. The stretcher restart and
+// the seek take a while (both happen off the audio thread), so the render
+// plays on until the playhead gets to where live playback was started, and
+// then fades out as that takes over.
+void
+WarpBufChugin::leaveRender() {
+    m_playingRendered = false;
+    m_fadeRender = m_rendered;
+    m_switching = true;
+    aimSwitch();
+}
+
+// Start live playback at the beat the playhead reaches s_switchFrames from
+// now.
+void
+WarpBufChugin::aimSwitch() {
+    double beatsPerFrame = m_bpm / (60. * m_srate);
+    m_switchLeft = s_switchFrames;
+    m_switchBeat = loopBeat(m_playHeadBeats + s_switchFrames * beatsPerFrame);
+    restartLive(m_switchBeat);
+}
+
+// The playhead got to the switch beat: hand over to live playback if it has
+// frames from there, or else aim further ahead. If the restart hasn't even
+// run yet, that waits until it has.
+void
+WarpBufChugin::takeOver() {
+    m_playHeadBeats = m_switchBeat;
+    if (!liveReady()) {
+        m_switchLeft = -1;
+        return;
+    }
+    if (m_blockPos >= m_blockCount) {
+        fillBlock();
     }
+    if (m_blockPos < m_blockCount) {
+        m_switching = false;
+        m_fadeLeft = s_fadeFrames;
+        return;
+    }
+    aimSwitch();
+}
 
-    m_rbstretcher->retrieve(m_retrieveBuffer, nframes);
+// Forget the render being left, for when playback moves somewhere else.
+void
+WarpBufChugin::stopSwitch() {
+    m_switching = false;
+    m_switchLeft = 0;
+    m_fadeLeft = 0;
+    m_fadeRender.reset();
+}
 
-    // Copy from m_retrieveBuffer to chuck's output.
-    // out needs to receive alternating left/right channels.
+// Mix the next frame of the render being left into `frame`.
+void
+WarpBufChugin::mixFadeRender(float* frame, float gain) {
+    if (m_renderPos >= m_fadeRender->frames) {
+        m_renderPos = 0;
+    }
+    const float* src = &m_fadeRender->data[(size_t)m_renderPos * m_channels];
     for (int chan = 0; chan < m_channels; chan++) {
-        auto chanPtr = m_retrieveBuffer[chan];
-        for (int i = 0; i < nframes; i++) {
-            out[chan + m_channels * i] = *chanPtr++;
-        }
+        frame[chan] = frame[chan] * (1.f - gain) + src[chan] * gain;
+    }
+    m_renderPos++;
+}
+
+// `beat` with the loop applied, for a beat at most a few blocks ahead of
+// the playhead
+double
+WarpBufChugin::loopBeat(double beat) {
+    double length = m_clipInfo.loop_end - m_clipInfo.loop_start;
+    if (m_clipInfo.loop_on && length > 0 && beat >= m_clipInfo.loop_end) {
+        beat = m_clipInfo.loop_start + std::fmod(beat - m_clipInfo.loop_end, length);
+    }
+    return beat;
+}
+
+bool
+WarpBufChugin::prerender() {
+    if (!m_source) {
+        std::cerr << "Error: prerender needs a file to be read first." << std::endl;
+        return false;
+    }
+    if (!m_clipInfo.loop_on || m_clipInfo.loop_end <= m_clipInfo.loop_start) {
+        std::cerr << "Error: prerender needs looping on and a loop end after the loop start." << std::endl;
+        return false;
+    }
+
+    stopRender();
+
+    RenderRequest request;
+    request.path = m_path;
+    request.clipInfo = m_clipInfo;
+    request.srate = m_srate;
+    request.bpm = m_bpm;
+    request.pitchScale = m_pitchScale;
+    request.loopStart = m_clipInfo.loop_start;
+    request.loopEnd = m_clipInfo.loop_end;
+    request.renderDir = m_renderDir;
+
+    m_renderCancel = false;
+    m_renderThread = std::thread([this, request]() {
+        m_renderResult = Prerender::render(request, m_renderCancel);
+        m_renderDone.store(true, std::memory_order_release);
+    });
+    return true;
+}
+
+// Cancel a render in progress and forget any finished one. If it is playing,
+// playback carries on live from the same position (see leaveRender).
+void
+WarpBufChugin::stopRender() {
+    m_renderCancel = true;
+    if (m_renderThread.joinable()) {
+        m_renderThread.join();
+    }
+    m_renderDone = false;
+    m_renderResult.reset();
+    if (m_playingRendered) {
+        leaveRender();
+    }
+    m_rendered.reset();
+}
+
+void
+WarpBufChugin::setPreload(bool preload) {
+    if (preload == m_preload) {
+        return;
+    }
+    m_preload = preload;
+    // switch the current file over to the new mode
+    if (m_source) {
+        double playhead = m_playHeadBeats;
+        read(m_path);
+        setPlayhead(playhead);
     }
 }
 
 // return true if the file was read
 bool
 WarpBufChugin::read(const std::string& path) {
-    
+
+    stopRender();
+    waitForJob();
+    stopSwitch();
+    m_source.reset();
+    m_path = path;
     memset(&sfinfo, 0, sizeof(SF_INFO));
 
-    sndfile = sf_open(path.c_str(), SFM_READ, &sfinfo);
+    if (m_preload) {
+        std::shared_ptr<const CachedClip> clip = SampleCache::load(path);
+        if (!clip) {
+            return false;
+        }
+        sfinfo = clip->sfinfo;
+        if (clip->hasWarpFile) {
+            m_clipInfo = clip->clipInfo;
+        }
+        else {
+            // We didn't find a warp file, so assume it's 120 bpm.
+            m_clipInfo.assume_bpm(120., sfinfo.frames / (double)sfinfo.samplerate);
+        }
+        m_playHeadBeats = m_clipInfo.start_marker;
+        m_source = std::make_unique<MemoryClipReader>(clip, m_clipInfo.beat_to_sample(m_playHeadBeats, sfinfo.samplerate));
+        this->recreateStretcher();
+        return true;
+    }
+
+    SNDFILE* sndfile = sf_open(path.c_str(), SFM_READ, &sfinfo);
     if (!sndfile) {
         std::cerr << "ERROR: Failed to open input file \"" << path << "\": "
             << sf_strerror(sndfile) << std::endl;
@@ -292,6 +638,8 @@ WarpBufChugin::read(const std::string& path) {
 
     if (sfinfo.samplerate == 0) {
         std::cerr << "ERROR: File lacks sample rate in header" << std::endl;
+        sf_close(sndfile);
+        memset(&sfinfo, 0, sizeof(SF_INFO));
         return false;
     }
 
@@ -300,26 +648,15 @@ WarpBufChugin::read(const std::string& path) {
 
     if (! (file_exists && m_clipInfo.readWarpFile(asd_path.c_str()))) {
         // We didn't find a warp file, so assume it's 120 bpm.
-        const double bpm = 120.;
-        const double end_in_beats = bpm * sfinfo.frames / (sfinfo.samplerate * 60.);
         //m_clipInfo.loop_on = true; // todo: maybe we want to do this. Let's just preserve the previous setting.
         //m_clipInfo.warp_on = true; // todo: maybe we want to do this. Let's just preserve the previous setting.
-        m_clipInfo.loop_start = 0.;
-        m_clipInfo.hidden_loop_start = 0.;
-        m_clipInfo.start_marker = 0.;
-        m_clipInfo.hidden_loop_end = end_in_beats;
-        m_clipInfo.loop_end = end_in_beats;
-        m_clipInfo.end_marker = end_in_beats;
-
-        // reset the warp markers based on the default bpm:
-        m_clipInfo.warp_markers.clear();
-        m_clipInfo.warp_markers.push_back(std::make_pair(0, 0));
-        double beats = 1. / 32.;
-        double durSeconds = beats * (60. / bpm);
-        m_clipInfo.warp_markers.push_back(std::make_pair(durSeconds, beats));
-    }
-
-    this->setPlayhead(m_clipInfo.start_marker);
+        m_clipInfo.assume_bpm(120., sfinfo.frames / (double)sfinfo.samplerate);
+    }
+
+    m_playHeadBeats = m_clipInfo.start_marker;
+    auto streamer = std::make_unique<DiskStreamer>();
+    streamer->start(sndfile, sfinfo, m_clipInfo.beat_to_sample(m_playHeadBeats, sfinfo.samplerate));
+    m_source = std::move(streamer);
 
     this->recreateStretcher();
 
@@ -14,6 +14,13 @@
 
 #include <rubberband/RubberBandStretcher.h>
 #include "AbletonClipInfo.h"
+#include "DiskStreamer.h"
+#include "SampleCache.h"
+#include "StretchPool.h"
+#include "Prerender.h"
+
+#include <atomic>
+#include <thread>
 
 #define WARPBUF_MAX_OUTPUTS 16
 
@@ -43,6 +50,30 @@ public:
 
     bool read(const std::string& filename);
 
+    // Preload mode: decode the whole file into a sample cache shared by all
+    // WarpBufs playing it, instead of streaming it from disk.
+    bool getPreload() { return m_preload; }
+    void setPreload(bool preload);
+
+    // Threaded mode: stretch on the shared StretchPool, one block ahead of
+    // playback, instead of on the audio thread. A block already queued is
+    // still played when this is turned off.
+    bool getThreaded() { return m_threaded; }
+    void setThreaded(bool threaded) { m_threaded = threaded; }
+    // Frames by which tempo and pitch changes lag behind in threaded mode.
+    int getLatency() { return m_threaded ? s_blockFrames : 0; }
+
+    // Render the loop region at the current BPM and transposition with
+    // RubberBand's offline mode on a background thread. Once it is ready the
+    // loop plays from the render until the BPM, transposition or loop
+    // markers change, and then crossfades into live stretching at the same
+    // position. Returns false if there's nothing to render.
+    bool prerender();
+    // true while the current settings are served from a finished render
+    bool getRendered() { return renderedMatches(); }
+    // directory in which renders are also kept as .wav files ("" for none)
+    void setRenderDir(const std::string& dir) { m_renderDir = dir; }
+
     bool getPlay() { return m_play; };
     void setPlay(bool play) { m_play = play; };
 
@@ -65,24 +96,103 @@ private:
 
     // buffer related vars:
     const int interleaved_buffer_size = 1024;
-    int m_numAllocated = 0;  // keep track of allocated samples
+    // frames pulled from the stretcher at a time; tempo and pitch changes
+    // take effect on these boundaries
+    static const int s_blockFrames = 256;
     int m_channels = 0;  // keep track of allocated channels
-    float** m_retrieveBuffer = NULL; // non interleaved: [m_channels][nframes] where nframes is the dynamic number of frames chuck requests on tick
-    float* m_interleavedBuffer = nullptr;  // interleaved: [m_channels*interleaved_buffer_size]
+    float** m_retrieveBuffer = NULL; // non interleaved: [m_channels][s_blockFrames], output FIFO served to tick
+    int m_blockPos = 0;    // next frame of m_retrieveBuffer to output
+    int m_blockCount = 0;  // frames in m_retrieveBuffer
+    int m_startDiscard = 0;  // stretcher output frames still to drop after a restart
+    float** m_aheadBuffer = NULL; // non interleaved: [m_channels][s_blockFrames], next block rendered by the pool
     float** m_nonInterleavedBuffer = NULL;  // non interleaved: [m_channels][interleaved_buffer_size]
 
     // soundfile vars:
-    SNDFILE* sndfile;
     SF_INFO sfinfo;
-    int sfReadPos = 0;
+    std::string m_path;
+    bool m_preload = false;
+    // where tick gets its frames: a DiskStreamer decoding on a background
+    // thread, or a MemoryClipReader over a preloaded clip
+    std::unique_ptr<ClipSource> m_source;
 
     AbletonClipInfo m_clipInfo;
 
     double m_playHeadBeats = 0.; // measured in quarter notes
     bool m_play = true;
     double m_bpm = 120.;  // desired playback bpm (not the source bpm)
+    double m_pitchScale = 1.;  // requested pitch scale, applied at block boundaries
 
     void clearBufs();
-    void allocate(int numChannels, int numSamples);
+    // stretcher settings for one block, taken on the ChucK thread
+    struct BlockParams {
+        double ratio;
+        double pitchScale;
+        bool loopOn;
+        int loopStart;
+        int loopEnd;
+    };
+
+    // renders the next block into m_aheadBuffer on a pool worker
+    class BlockJob : public StretchJob {
+    public:
+        WarpBufChugin* owner = nullptr;
+        BlockParams params;
+        int count = 0;
+        void run() override { count = owner->renderBlock(params, owner->m_aheadBuffer); }
+    };
+
+    // restarts the stretcher on a pool worker, so the pre-padding doesn't
+    // run on the audio thread
+    class RestartJob : public StretchJob {
+    public:
+        WarpBufChugin* owner = nullptr;
+        BlockParams params;
+        void run() override { owner->restartStretcher(params); }
+    };
+
+    // pre-rendering
+    std::string m_renderDir;
+    std::thread m_renderThread;
+    std::atomic<bool> m_renderCancel{ false };
+    std::atomic<bool> m_renderDone{ false };
+    std::shared_ptr<const RenderedLoop> m_renderResult; // written by m_renderThread before m_renderDone
+    std::shared_ptr<const RenderedLoop> m_rendered;     // the render tick plays from
+    bool m_playingRendered = false;
+    int m_renderPos = 0;  // next frame of m_rendered (or m_fadeRender) to output
+    // Leaving the render, it plays on while the stretcher restarts aimed at
+    // the beat the playhead reaches s_switchFrames later, and live playback
+    // takes over there, fading out of the render over s_fadeFrames.
+    static const int s_switchFrames = 4096;
+    static const int s_fadeFrames = 512;
+    std::shared_ptr<const RenderedLoop> m_fadeRender;  // the render being left
+    bool m_switching = false;
+    int m_switchLeft = 0;    // frames to the switch beat, -1 once it was missed
+    double m_switchBeat = 0.;
+    int m_fadeLeft = 0;   // frames of the fade still to play
+
+    bool renderedMatches();
+    void stopRender();
+    void leaveRender();
+    void aimSwitch();
+    void takeOver();
+    void stopSwitch();
+    void mixFadeRender(float* frame, float gain);
+    double loopBeat(double beat);
+
+    bool m_threaded = false;
+    bool m_jobPending = false;
+    BlockJob m_job;
+    bool m_restartPending = false;
+    RestartJob m_restartJob;
+
+    void allocate(int numChannels);
+    BlockParams blockParams(double beat);
+    int renderBlock(const BlockParams& params, float** dst);
+    bool feedStretcher(int frames);
+    void fillBlock();
+    void waitForJob();
     void recreateStretcher();
+    void restartStretcher(const BlockParams& params);
+    void restartLive(double beat);
+    bool liveReady();
 };
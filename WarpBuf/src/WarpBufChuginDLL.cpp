@@ -1,4 +1,5 @@
 #include "WarpBufChugin.h"
+#include "WarpSession.h"
 
 // declaration of chugin constructor
 CK_DLL_CTOR(warpbuf_ctor);
@@ -26,6 +27,14 @@ CK_DLL_MFUN(warpbuf_getloopstart);
 CK_DLL_MFUN(warpbuf_setloopstart);
 CK_DLL_MFUN(warpbuf_getloopend);
 CK_DLL_MFUN(warpbuf_setloopend);
+CK_DLL_MFUN(warpbuf_getpreload);
+CK_DLL_MFUN(warpbuf_setpreload);
+CK_DLL_MFUN(warpbuf_getthreaded);
+CK_DLL_MFUN(warpbuf_setthreaded);
+CK_DLL_MFUN(warpbuf_getlatency);
+CK_DLL_MFUN(warpbuf_prerender);
+CK_DLL_MFUN(warpbuf_getrendered);
+CK_DLL_MFUN(warpbuf_setrenderdir);
 
 // multi-channel audio synthesis tick function
 CK_DLL_TICKF(warpbuf_tick);
@@ -33,6 +42,35 @@ CK_DLL_TICKF(warpbuf_tick);
 // this is a special offset reserved for Chugin internal data
 t_CKINT warpbuf_data_offset = 0;
 
+CK_DLL_CTOR(warpsession_ctor);
+CK_DLL_DTOR(warpsession_dtor);
+CK_DLL_TICKF(warpsession_tick);
+CK_DLL_MFUN(warpsession_add);
+CK_DLL_MFUN(warpsession_clips);
+CK_DLL_MFUN(warpsession_launch);
+CK_DLL_MFUN(warpsession_stop);
+CK_DLL_MFUN(warpsession_stopall);
+CK_DLL_MFUN(warpsession_playing);
+CK_DLL_MFUN(warpsession_getbpm);
+CK_DLL_MFUN(warpsession_setbpm);
+CK_DLL_MFUN(warpsession_getquantize);
+CK_DLL_MFUN(warpsession_setquantize);
+CK_DLL_MFUN(warpsession_beat);
+CK_DLL_MFUN(warpsession_gettranspose);
+CK_DLL_MFUN(warpsession_settranspose);
+CK_DLL_MFUN(warpsession_getclipgain);
+CK_DLL_MFUN(warpsession_setclipgain);
+CK_DLL_MFUN(warpsession_getoutput);
+CK_DLL_MFUN(warpsession_setoutput);
+CK_DLL_MFUN(warpsession_getloop);
+CK_DLL_MFUN(warpsession_setloop);
+CK_DLL_MFUN(warpsession_getthreaded);
+CK_DLL_MFUN(warpsession_setthreaded);
+CK_DLL_MFUN(warpsession_getmaxvoices);
+CK_DLL_MFUN(warpsession_setmaxvoices);
+
+t_CKINT warpsession_data_offset = 0;
+
 //-----------------------------------------------------------------------------
 // query function: chuck calls this when loading the Chugin
 //-----------------------------------------------------------------------------
@@ -94,6 +132,23 @@ CK_DLL_QUERY(WarpBuf)
     QUERY->add_mfun(QUERY, warpbuf_setloopend, "float", "loopEnd");
     QUERY->add_arg(QUERY, "float", "loopEnd");
 
+    QUERY->add_mfun(QUERY, warpbuf_getpreload, "int", "preload");
+    QUERY->add_mfun(QUERY, warpbuf_setpreload, "int", "preload");
+    QUERY->add_arg(QUERY, "int", "preload");
+
+    QUERY->add_mfun(QUERY, warpbuf_getthreaded, "int", "threaded");
+    QUERY->add_mfun(QUERY, warpbuf_setthreaded, "int", "threaded");
+    QUERY->add_arg(QUERY, "int", "threaded");
+
+    QUERY->add_mfun(QUERY, warpbuf_getlatency, "int", "latency");
+
+    QUERY->add_mfun(QUERY, warpbuf_prerender, "int", "prerender");
+
+    QUERY->add_mfun(QUERY, warpbuf_getrendered, "int", "rendered");
+
+    QUERY->add_mfun(QUERY, warpbuf_setrenderdir, "void", "renderDir");
+    QUERY->add_arg(QUERY, "string", "dir");
+
     // this reserves a variable in the ChucK internal class to store
     // referene to the c++ class we defined above
     warpbuf_data_offset = QUERY->add_mvar(QUERY, "int", "@b_data", false);
@@ -102,6 +157,75 @@ CK_DLL_QUERY(WarpBuf)
     // IMPORTANT: this MUST be called!
     QUERY->end_class(QUERY);
 
+    // WarpSession: many clips on one beat clock
+    QUERY->begin_class(QUERY, "WarpSession", "UGen");
+    QUERY->add_ctor(QUERY, warpsession_ctor);
+    QUERY->add_dtor(QUERY, warpsession_dtor);
+
+    QUERY->add_ugen_funcf(QUERY, warpsession_tick, NULL, 0, WARPSESSION_MAX_OUTPUTS);
+
+    QUERY->add_mfun(QUERY, warpsession_add, "int", "add");
+    QUERY->add_arg(QUERY, "string", "filename");
+
+    QUERY->add_mfun(QUERY, warpsession_clips, "int", "clips");
+
+    QUERY->add_mfun(QUERY, warpsession_launch, "void", "launch");
+    QUERY->add_arg(QUERY, "int", "clip");
+
+    QUERY->add_mfun(QUERY, warpsession_stop, "void", "stop");
+    QUERY->add_arg(QUERY, "int", "clip");
+
+    QUERY->add_mfun(QUERY, warpsession_stopall, "void", "stopAll");
+
+    QUERY->add_mfun(QUERY, warpsession_playing, "int", "playing");
+    QUERY->add_arg(QUERY, "int", "clip");
+
+    QUERY->add_mfun(QUERY, warpsession_getbpm, "float", "bpm");
+    QUERY->add_mfun(QUERY, warpsession_setbpm, "float", "bpm");
+    QUERY->add_arg(QUERY, "float", "bpm");
+
+    QUERY->add_mfun(QUERY, warpsession_getquantize, "float", "quantize");
+    QUERY->add_mfun(QUERY, warpsession_setquantize, "float", "quantize");
+    QUERY->add_arg(QUERY, "float", "beats");
+
+    QUERY->add_mfun(QUERY, warpsession_beat, "float", "beat");
+
+    QUERY->add_mfun(QUERY, warpsession_gettranspose, "float", "transpose");
+    QUERY->add_arg(QUERY, "int", "clip");
+    QUERY->add_mfun(QUERY, warpsession_settranspose, "float", "transpose");
+    QUERY->add_arg(QUERY, "int", "clip");
+    QUERY->add_arg(QUERY, "float", "transpose");
+
+    QUERY->add_mfun(QUERY, warpsession_getclipgain, "float", "clipGain");
+    QUERY->add_arg(QUERY, "int", "clip");
+    QUERY->add_mfun(QUERY, warpsession_setclipgain, "float", "clipGain");
+    QUERY->add_arg(QUERY, "int", "clip");
+    QUERY->add_arg(QUERY, "float", "gain");
+
+    QUERY->add_mfun(QUERY, warpsession_getoutput, "int", "output");
+    QUERY->add_arg(QUERY, "int", "clip");
+    QUERY->add_mfun(QUERY, warpsession_setoutput, "int", "output");
+    QUERY->add_arg(QUERY, "int", "clip");
+    QUERY->add_arg(QUERY, "int", "channel");
+
+    QUERY->add_mfun(QUERY, warpsession_getloop, "int", "loop");
+    QUERY->add_arg(QUERY, "int", "clip");
+    QUERY->add_mfun(QUERY, warpsession_setloop, "int", "loop");
+    QUERY->add_arg(QUERY, "int", "clip");
+    QUERY->add_arg(QUERY, "int", "loop");
+
+    QUERY->add_mfun(QUERY, warpsession_getthreaded, "int", "threaded");
+    QUERY->add_mfun(QUERY, warpsession_setthreaded, "int", "threaded");
+    QUERY->add_arg(QUERY, "int", "threaded");
+
+    QUERY->add_mfun(QUERY, warpsession_getmaxvoices, "int", "maxVoices");
+    QUERY->add_mfun(QUERY, warpsession_setmaxvoices, "int", "maxVoices");
+    QUERY->add_arg(QUERY, "int", "voices");
+
+    warpsession_data_offset = QUERY->add_mvar(QUERY, "int", "@ws_data", false);
+
+    QUERY->end_class(QUERY);
+
     return TRUE;
 }
 
@@ -306,3 +430,289 @@ CK_DLL_MFUN(warpbuf_setloopend)
     chug->setLoopEnd(loopEnd);
     RETURN->v_float = loopEnd;
 }
+
+CK_DLL_MFUN(warpbuf_getpreload)
+{
+    WarpBufChugin* chug = (WarpBufChugin*)OBJ_MEMBER_INT(SELF, warpbuf_data_offset);
+
+    RETURN->v_int = chug->getPreload();
+}
+
+CK_DLL_MFUN(warpbuf_setpreload)
+{
+    t_CKBOOL preload = GET_NEXT_INT(ARGS);
+
+    WarpBufChugin* chug = (WarpBufChugin*)OBJ_MEMBER_INT(SELF, warpbuf_data_offset);
+    chug->setPreload(preload);
+    RETURN->v_int = preload;
+}
+
+CK_DLL_MFUN(warpbuf_getthreaded)
+{
+    WarpBufChugin* chug = (WarpBufChugin*)OBJ_MEMBER_INT(SELF, warpbuf_data_offset);
+
+    RETURN->v_int = chug->getThreaded();
+}
+
+CK_DLL_MFUN(warpbuf_setthreaded)
+{
+    t_CKBOOL threaded = GET_NEXT_INT(ARGS);
+
+    WarpBufChugin* chug = (WarpBufChugin*)OBJ_MEMBER_INT(SELF, warpbuf_data_offset);
+    chug->setThreaded(threaded);
+    RETURN->v_int = threaded;
+}
+
+CK_DLL_MFUN(warpbuf_getlatency)
+{
+    WarpBufChugin* chug = (WarpBufChugin*)OBJ_MEMBER_INT(SELF, warpbuf_data_offset);
+
+    RETURN->v_int = chug->getLatency();
+}
+
+CK_DLL_MFUN(warpbuf_prerender)
+{
+    WarpBufChugin* chug = (WarpBufChugin*)OBJ_MEMBER_INT(SELF, warpbuf_data_offset);
+
+    RETURN->v_int = chug->prerender();
+}
+
+CK_DLL_MFUN(warpbuf_getrendered)
+{
+    WarpBufChugin* chug = (WarpBufChugin*)OBJ_MEMBER_INT(SELF, warpbuf_data_offset);
+
+    RETURN->v_int = chug->getRendered();
+}
+
+CK_DLL_MFUN(warpbuf_setrenderdir)
+{
+    std::string dir = GET_NEXT_STRING_SAFE(ARGS);
+
+    WarpBufChugin* chug = (WarpBufChugin*)OBJ_MEMBER_INT(SELF, warpbuf_data_offset);
+    chug->setRenderDir(dir);
+}
+
+//-----------------------------------------------------------------------------
+// WarpSession
+//-----------------------------------------------------------------------------
+CK_DLL_CTOR(warpsession_ctor)
+{
+    OBJ_MEMBER_INT(SELF, warpsession_data_offset) = 0;
+
+    WarpSession* session = new WarpSession(API->vm->srate(VM));
+
+    OBJ_MEMBER_INT(SELF, warpsession_data_offset) = (t_CKINT)session;
+}
+
+CK_DLL_DTOR(warpsession_dtor)
+{
+    WarpSession* session = (WarpSession*)OBJ_MEMBER_INT(SELF, warpsession_data_offset);
+    if (session)
+    {
+        delete session;
+        OBJ_MEMBER_INT(SELF, warpsession_data_offset) = 0;
+    }
+}
+
+CK_DLL_TICKF(warpsession_tick)
+{
+    WarpSession* session = (WarpSession*)OBJ_MEMBER_INT(SELF, warpsession_data_offset);
+
+    if (session) session->tick(in, out, nframes);
+
+    return TRUE;
+}
+
+CK_DLL_MFUN(warpsession_add)
+{
+    std::string filename = GET_NEXT_STRING_SAFE(ARGS);
+
+    WarpSession* session = (WarpSession*)OBJ_MEMBER_INT(SELF, warpsession_data_offset);
+
+    RETURN->v_int = session->add(filename);
+}
+
+CK_DLL_MFUN(warpsession_clips)
+{
+    WarpSession* session = (WarpSession*)OBJ_MEMBER_INT(SELF, warpsession_data_offset);
+
+    RETURN->v_int = session->getClipCount();
+}
+
+CK_DLL_MFUN(warpsession_launch)
+{
+    t_CKINT clip = GET_NEXT_INT(ARGS);
+
+    WarpSession* session = (WarpSession*)OBJ_MEMBER_INT(SELF, warpsession_data_offset);
+    session->launch(clip);
+}
+
+CK_DLL_MFUN(warpsession_stop)
+{
+    t_CKINT clip = GET_NEXT_INT(ARGS);
+
+    WarpSession* session = (WarpSession*)OBJ_MEMBER_INT(SELF, warpsession_data_offset);
+    session->stop(clip);
+}
+
+CK_DLL_MFUN(warpsession_stopall)
+{
+    WarpSession* session = (WarpSession*)OBJ_MEMBER_INT(SELF, warpsession_data_offset);
+    session->stopAll();
+}
+
+CK_DLL_MFUN(warpsession_playing)
+{
+    t_CKINT clip = GET_NEXT_INT(ARGS);
+
+    WarpSession* session = (WarpSession*)OBJ_MEMBER_INT(SELF, warpsession_data_offset);
+
+    RETURN->v_int = session->getPlaying(clip);
+}
+
+CK_DLL_MFUN(warpsession_getbpm)
+{
+    WarpSession* session = (WarpSession*)OBJ_MEMBER_INT(SELF, warpsession_data_offset);
+
+    RETURN->v_float = session->getBPM();
+}
+
+CK_DLL_MFUN(warpsession_setbpm)
+{
+    t_CKFLOAT bpm = GET_NEXT_FLOAT(ARGS);
+
+    WarpSession* session = (WarpSession*)OBJ_MEMBER_INT(SELF, warpsession_data_offset);
+    session->setBPM(bpm);
+    RETURN->v_float = session->getBPM();
+}
+
+CK_DLL_MFUN(warpsession_getquantize)
+{
+    WarpSession* session = (WarpSession*)OBJ_MEMBER_INT(SELF, warpsession_data_offset);
+
+    RETURN->v_float = session->getQuantize();
+}
+
+CK_DLL_MFUN(warpsession_setquantize)
+{
+    t_CKFLOAT beats = GET_NEXT_FLOAT(ARGS);
+
+    WarpSession* session = (WarpSession*)OBJ_MEMBER_INT(SELF, warpsession_data_offset);
+    session->setQuantize(beats);
+    RETURN->v_float = session->getQuantize();
+}
+
+CK_DLL_MFUN(warpsession_beat)
+{
+    WarpSession* session = (WarpSession*)OBJ_MEMBER_INT(SELF, warpsession_data_offset);
+
+    RETURN->v_float = session->getBeat();
+}
+
+CK_DLL_MFUN(warpsession_gettranspose)
+{
+    t_CKINT clip = GET_NEXT_INT(ARGS);
+
+    WarpSession* session = (WarpSession*)OBJ_MEMBER_INT(SELF, warpsession_data_offset);
+
+    RETURN->v_float = session->getTranspose(clip);
+}
+
+CK_DLL_MFUN(warpsession_settranspose)
+{
+    t_CKINT clip = GET_NEXT_INT(ARGS);
+    t_CKFLOAT transpose = GET_NEXT_FLOAT(ARGS);
+
+    WarpSession* session = (WarpSession*)OBJ_MEMBER_INT(SELF, warpsession_data_offset);
+    session->setTranspose(clip, transpose);
+    RETURN->v_float = transpose;
+}
+
+CK_DLL_MFUN(warpsession_getclipgain)
+{
+    t_CKINT clip = GET_NEXT_INT(ARGS);
+
+    WarpSession* session = (WarpSession*)OBJ_MEMBER_INT(SELF, warpsession_data_offset);
+
+    RETURN->v_float = session->getClipGain(clip);
+}
+
+CK_DLL_MFUN(warpsession_setclipgain)
+{
+    t_CKINT clip = GET_NEXT_INT(ARGS);
+    t_CKFLOAT gain = GET_NEXT_FLOAT(ARGS);
+
+    WarpSession* session = (WarpSession*)OBJ_MEMBER_INT(SELF, warpsession_data_offset);
+    session->setClipGain(clip, gain);
+    RETURN->v_float = gain;
+}
+
+CK_DLL_MFUN(warpsession_getoutput)
+{
+    t_CKINT clip = GET_NEXT_INT(ARGS);
+
+    WarpSession* session = (WarpSession*)OBJ_MEMBER_INT(SELF, warpsession_data_offset);
+
+    RETURN->v_int = session->getOutput(clip);
+}
+
+CK_DLL_MFUN(warpsession_setoutput)
+{
+    t_CKINT clip = GET_NEXT_INT(ARGS);
+    t_CKINT channel = GET_NEXT_INT(ARGS);
+
+    WarpSession* session = (WarpSession*)OBJ_MEMBER_INT(SELF, warpsession_data_offset);
+    session->setOutput(clip, channel);
+    RETURN->v_int = session->getOutput(clip);
+}
+
+CK_DLL_MFUN(warpsession_getloop)
+{
+    t_CKINT clip = GET_NEXT_INT(ARGS);
+
+    WarpSession* session = (WarpSession*)OBJ_MEMBER_INT(SELF, warpsession_data_offset);
+
+    RETURN->v_int = session->getLoop(clip);
+}
+
+CK_DLL_MFUN(warpsession_setloop)
+{
+    t_CKINT clip = GET_NEXT_INT(ARGS);
+    t_CKINT loop = GET_NEXT_INT(ARGS);
+
+    WarpSession* session = (WarpSession*)OBJ_MEMBER_INT(SELF, warpsession_data_offset);
+    session->setLoop(clip, loop);
+    RETURN->v_int = loop;
+}
+
+CK_DLL_MFUN(warpsession_getthreaded)
+{
+    WarpSession* session = (WarpSession*)OBJ_MEMBER_INT(SELF, warpsession_data_offset);
+
+    RETURN->v_int = session->getThreaded();
+}
+
+CK_DLL_MFUN(warpsession_setthreaded)
+{
+    t_CKINT threaded = GET_NEXT_INT(ARGS);
+
+    WarpSession* session = (WarpSession*)OBJ_MEMBER_INT(SELF, warpsession_data_offset);
+    session->setThreaded(threaded);
+    RETURN->v_int = threaded;
+}
+
+CK_DLL_MFUN(warpsession_getmaxvoices)
+{
+    WarpSession* session = (WarpSession*)OBJ_MEMBER_INT(SELF, warpsession_data_offset);
+
+    RETURN->v_int = session->getMaxVoices();
+}
+
+CK_DLL_MFUN(warpsession_setmaxvoices)
+{
+    t_CKINT voices = GET_NEXT_INT(ARGS);
+
+    WarpSession* session = (WarpSession*)OBJ_MEMBER_INT(SELF, warpsession_data_offset);
+    session->setMaxVoices(voices);
+    RETURN->v_int = session->getMaxVoices();
+}
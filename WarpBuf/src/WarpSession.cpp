@@ -0,0 +1,578 @@
+#include "WarpSession.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+WarpSession::WarpSession(t_CKFLOAT srate)
+{
+    m_srate = srate;
+    m_mix.assign((size_t)s_blockFrames * WARPSESSION_MAX_OUTPUTS, 0.f);
+    // the voices themselves are made once a clip says how many channels
+    // they need (see sizePool)
+    sizePool();
+}
+
+WarpSession::~WarpSession()
+{
+}
+
+int
+WarpSession::add(const std::string& path)
+{
+    std::shared_ptr<const CachedClip> data = SampleCache::load(path);
+    if (!data) {
+        return -1;
+    }
+
+    auto clip = std::make_unique<Clip>();
+    clip->data = data;
+    if (data->hasWarpFile) {
+        clip->clipInfo = data->clipInfo;
+    }
+    else {
+        // We didn't find a warp file, so assume it's 120 bpm.
+        clip->clipInfo.assume_bpm(120., data->sfinfo.frames / (double)data->sfinfo.samplerate);
+    }
+    clip->source = std::make_unique<MemoryClipReader>(data, 0);
+    clip->job.clip = clip.get();
+
+    int channels = data->sfinfo.channels;
+    m_clips.push_back(std::move(clip));
+    if (std::find(m_widths.begin(), m_widths.end(), channels) == m_widths.end()) {
+        m_widths.push_back(channels);
+        sizePool();
+    }
+    return (int)m_clips.size() - 1;
+}
+
+void
+WarpSession::setMaxVoices(int voices)
+{
+    if (voices < 1) {
+        std::cerr << "Error: WarpSession needs at least one voice." << std::endl;
+        return;
+    }
+    m_maxVoices = voices;
+    sizePool();
+}
+
+// Make (or drop idle) stretchers so there are m_maxVoices of them for every
+// channel count in m_widths. Voices that are playing when the pool shrinks
+// are dropped the next time it is sized. Runs on the ChucK side only, so
+// tick never allocates.
+void
+WarpSession::sizePool()
+{
+    int total = 0;
+    for (int channels : m_widths) {
+        int count = 0;
+        for (auto& slot : m_idleSlots) {
+            count += slot->channels == channels;
+        }
+        for (auto& clip : m_clips) {
+            count += clip->slot && clip->slot->channels == channels;
+        }
+        for (; count < m_maxVoices; count++) {
+            m_idleSlots.push_back(makeSlot(channels));
+        }
+        for (size_t i = m_idleSlots.size(); i-- > 0 && count > m_maxVoices;) {
+            if (m_idleSlots[i]->channels == channels) {
+                m_idleSlots.erase(m_idleSlots.begin() + i);
+                count--;
+            }
+        }
+        total += count;
+    }
+    // releaseClip hands voices back, and mixBlock lists the playing clips,
+    // without growing these
+    m_idleSlots.reserve(std::max(total, m_maxVoices));
+    m_topUp.reserve(std::max(total, m_maxVoices));
+}
+
+WarpSession::Clip*
+WarpSession::find(int clip)
+{
+    if (clip < 0 || clip >= (int)m_clips.size()) {
+        std::cerr << "Error: WarpSession has no clip " << clip << "." << std::endl;
+        return nullptr;
+    }
+    return m_clips[clip].get();
+}
+
+double
+WarpSession::nextBoundary(double beat)
+{
+    if (m_quantize <= 0.) {
+        return beat;
+    }
+    // a tiny tolerance so a request made right on a boundary keeps it
+    return std::ceil(beat / m_quantize - 1e-9) * m_quantize;
+}
+
+// The first frame at or after `beats` into a block. Beats that land within
+// rounding error of a frame land on that frame.
+int
+WarpSession::frameAt(double beats, double beatsPerFrame)
+{
+    return (int)std::ceil(beats / beatsPerFrame - 1e-6);
+}
+
+double
+WarpSession::getBeat()
+{
+    return m_mixBeat + m_mixPos * m_mixBeatsPerFrame;
+}
+
+void
+WarpSession::launch(int index)
+{
+    Clip* clip = find(index);
+    if (!clip) {
+        return;
+    }
+    clip->launchBeat = nextBoundary(getBeat());
+    clip->stopBeat = -1.;
+
+    if (!clip->slot) {
+        int busy = 0;
+        for (auto& c : m_clips) {
+            busy += c->slot && c->stopBeat < 0.;
+        }
+        if (busy >= m_maxVoices) {
+            std::cerr << "Warning: all " << m_maxVoices << " WarpSession voices are playing; clip "
+                << index << " only starts if one stops by then." << std::endl;
+        }
+    }
+}
+
+void
+WarpSession::stop(int index)
+{
+    Clip* clip = find(index);
+    if (!clip) {
+        return;
+    }
+    if (clip->playing) {
+        clip->stopBeat = nextBoundary(getBeat());
+    }
+    // a launch that hasn't happened yet is simply dropped
+    clip->launchBeat = -1.;
+}
+
+void
+WarpSession::stopAll()
+{
+    for (int i = 0; i < (int)m_clips.size(); i++) {
+        stop(i);
+    }
+}
+
+bool
+WarpSession::getPlaying(int index)
+{
+    Clip* clip = find(index);
+    return clip && clip->playing;
+}
+
+void
+WarpSession::setBPM(double bpm)
+{
+    if (bpm <= 0) {
+        std::cerr << "Error: BPM must be positive." << std::endl;
+        return;
+    }
+    m_bpm = bpm;
+}
+
+double
+WarpSession::getTranspose(int index)
+{
+    Clip* clip = find(index);
+    return clip ? 12. * std::log2(clip->pitchScale) : 0.;
+}
+
+void
+WarpSession::setTranspose(int index, double transpose)
+{
+    if (Clip* clip = find(index)) {
+        clip->pitchScale = std::pow(2., transpose / 12.);
+    }
+}
+
+double
+WarpSession::getClipGain(int index)
+{
+    Clip* clip = find(index);
+    return clip ? clip->gain : 0.;
+}
+
+void
+WarpSession::setClipGain(int index, double gain)
+{
+    if (Clip* clip = find(index)) {
+        clip->gain = gain;
+    }
+}
+
+int
+WarpSession::getOutput(int index)
+{
+    Clip* clip = find(index);
+    return clip ? clip->output : 0;
+}
+
+void
+WarpSession::setOutput(int index, int channel)
+{
+    if (channel < 0 || channel >= WARPSESSION_MAX_OUTPUTS) {
+        std::cerr << "Error: WarpSession output must be between 0 and "
+            << WARPSESSION_MAX_OUTPUTS - 1 << "." << std::endl;
+        return;
+    }
+    if (Clip* clip = find(index)) {
+        clip->output = channel;
+    }
+}
+
+bool
+WarpSession::getLoop(int index)
+{
+    Clip* clip = find(index);
+    return clip && clip->clipInfo.loop_on;
+}
+
+void
+WarpSession::setLoop(int index, bool loop)
+{
+    if (Clip* clip = find(index)) {
+        clip->clipInfo.loop_on = loop;
+    }
+}
+
+// Take an idle stretcher with the right channel count, or nullptr.
+std::unique_ptr<WarpSession::StretchSlot>
+WarpSession::acquireSlot(int channels)
+{
+    for (size_t i = 0; i < m_idleSlots.size(); i++) {
+        if (m_idleSlots[i]->channels == channels) {
+            std::unique_ptr<StretchSlot> slot = std::move(m_idleSlots[i]);
+            m_idleSlots.erase(m_idleSlots.begin() + i);
+            return slot;
+        }
+    }
+    return nullptr;
+}
+
+std::unique_ptr<WarpSession::StretchSlot>
+WarpSession::makeSlot(int channels)
+{
+    using namespace RubberBand;
+
+    RubberBandStretcher::Options options = 0;
+
+    options |= RubberBandStretcher::OptionProcessRealTime;
+    options |= RubberBandStretcher::OptionStretchPrecise;
+    options |= RubberBandStretcher::OptionThreadingNever;
+    options |= RubberBandStretcher::OptionPitchHighQuality;
+
+    auto slot = std::make_unique<StretchSlot>();
+    slot->channels = channels;
+    slot->stretcher = std::make_unique<RubberBandStretcher>(m_srate, channels, options, 1., 1.);
+    slot->input.assign(channels, std::vector<float>(s_readFrames, 0.f));
+    slot->output.assign(channels, std::vector<float>(2 * s_blockFrames, 0.f));
+    for (int c = 0; c < channels; c++) {
+        slot->inputPtrs.push_back(slot->input[c].data());
+        slot->outputPtrs.push_back(slot->output[c].data());
+    }
+    return slot;
+}
+
+// Time ratio for stretching `clip` at its playhead to the session tempo.
+double
+WarpSession::stretchRatio(Clip& clip)
+{
+    double _;
+    double clipBPM = -1.;
+    clip.clipInfo.beat_to_seconds(clip.playHeadBeats, _, clipBPM);
+
+    double ratio = m_srate / clip.data->sfinfo.samplerate;
+    if (clipBPM > 0) {
+        ratio *= clipBPM / m_bpm;
+    }
+    return ratio;
+}
+
+// Give `clip` a voice. With all of them taken, a clip that stops in this
+// block is finished first: it is topped up and mixed up to its stop now,
+// and its voice goes to `clip`. Returns false if no clip is stopping.
+bool
+WarpSession::takeVoice(Clip& clip, double blockStart, double blockEnd, double beatsPerFrame)
+{
+    if (m_voicesInUse >= m_maxVoices) {
+        Clip* stopping = nullptr;
+        for (auto& c : m_clips) {
+            if (c->slot && c->stopBeat >= 0. && c->stopBeat < blockEnd) {
+                stopping = c.get();
+                break;
+            }
+        }
+        if (!stopping) {
+            return false;
+        }
+        if (prepareJob(*stopping)) {
+            stopping->job.run();
+        }
+        mixClip(*stopping, blockStart, blockEnd, beatsPerFrame);
+    }
+
+    clip.slot = acquireSlot(clip.data->sfinfo.channels);
+    if (!clip.slot) {
+        return false;
+    }
+    m_voicesInUse++;
+    return true;
+}
+
+// Start a clip that has a voice. A relaunch of a playing clip restarts it
+// from the start of this block.
+void
+WarpSession::startClip(Clip& clip, double blockStart, double beatsPerFrame)
+{
+    // Launches that were asked for too late to land on their beat (inside a
+    // block that was already mixed) start right away, but from the point in
+    // the clip they would have reached, so they stay in phase.
+    double late = std::max(0., blockStart - clip.launchBeat);
+    clip.startOffset = 0;
+    if (clip.launchBeat > blockStart) {
+        clip.startOffset = std::min(frameAt(clip.launchBeat - blockStart, beatsPerFrame), s_blockFrames - 1);
+    }
+
+    clip.playHeadBeats = clip.clipInfo.start_marker + late;
+    clip.source->seek(clip.clipInfo.beat_to_sample(clip.playHeadBeats, clip.data->sfinfo.samplerate));
+    clip.playing = true;
+    clip.launchBeat = -1.;
+
+    // In real-time mode RubberBand wants getPreferredStartPad() frames of
+    // silence ahead of the first input frame, and then delays its output by
+    // getStartDelay() frames. Feed the pad now and have the job drop the
+    // delay, so the clip's first frame sounds on the launch frame.
+    StretchSlot& slot = *clip.slot;
+    RubberBand::RubberBandStretcher& stretcher = *slot.stretcher;
+    stretcher.reset();
+    stretcher.setTimeRatio(stretchRatio(clip));
+    stretcher.setPitchScale(clip.pitchScale);
+    slot.count = 0;
+
+    for (int c = 0; c < slot.channels; c++) {
+        std::fill(slot.input[c].begin(), slot.input[c].end(), 0.f);
+    }
+    int pad = (int)stretcher.getPreferredStartPad();
+    while (pad > 0) {
+        int count = std::min(pad, s_readFrames);
+        stretcher.process(slot.inputPtrs.data(), count, false);
+        pad -= count;
+    }
+    slot.discard = (int)stretcher.getStartDelay();
+}
+
+void
+WarpSession::releaseClip(Clip& clip)
+{
+    clip.playing = false;
+    clip.stopBeat = -1.;
+    if (clip.slot) {
+        clip.slot->stretcher->reset();
+        clip.slot->count = 0;
+        m_idleSlots.push_back(std::move(clip.slot));
+        m_voicesInUse--;
+    }
+}
+
+void
+WarpSession::ClipJob::run()
+{
+    StretchSlot& slot = *clip->slot;
+    RubberBand::RubberBandStretcher& stretcher = *slot.stretcher;
+
+    if (ratio != stretcher.getTimeRatio()) {
+        stretcher.setTimeRatio(ratio);
+    }
+    if (pitchScale != stretcher.getPitchScale()) {
+        stretcher.setPitchScale(pitchScale);
+    }
+
+    for (int c = 0; c < slot.channels; c++) {
+        slot.outputPtrs[c] = slot.output[c].data() + slot.count;
+    }
+
+    // After a launch the stretcher's start delay is dropped first; the
+    // frames are retrieved into the free end of the output and overwritten.
+    while (slot.discard > 0) {
+        int count = std::min(slot.discard, s_blockFrames);
+        fill(count);
+        slot.discard -= (int)stretcher.retrieve(slot.outputPtrs.data(), count);
+    }
+
+    int need = s_blockFrames - slot.count;
+    fill(need);
+    slot.count += (int)stretcher.retrieve(slot.outputPtrs.data(), need);
+}
+
+// Feed the clip to its stretcher until it has `frames` frames of output.
+void
+WarpSession::ClipJob::fill(int frames)
+{
+    StretchSlot& slot = *clip->slot;
+    while (slot.stretcher->available() < frames) {
+        bool wrap = false;
+        int count = clip->source->read(slot.inputPtrs.data(), s_readFrames, wrap);
+        slot.stretcher->process(slot.inputPtrs.data(), count, false);
+    }
+}
+
+// Work out the settings for topping up a playing clip, once per block.
+// Returns false if it already has a block of stretched frames.
+bool
+WarpSession::prepareJob(Clip& clip)
+{
+    if (!clip.playing || clip.slot->count >= s_blockFrames) {
+        return false;
+    }
+
+    int sr = clip.data->sfinfo.samplerate;
+    clip.job.ratio = stretchRatio(clip);
+    clip.job.pitchScale = clip.pitchScale;
+    clip.source->setLoop(clip.clipInfo.loop_on,
+        clip.clipInfo.beat_to_sample(clip.clipInfo.loop_start, sr),
+        clip.clipInfo.beat_to_sample(clip.clipInfo.loop_end, sr));
+    return true;
+}
+
+// Mix a playing clip's frames for this block into m_mix, and let go of its
+// voice if it stops.
+void
+WarpSession::mixClip(Clip& clip, double blockStart, double blockEnd, double beatsPerFrame)
+{
+    int end = s_blockFrames;
+    bool stopping = clip.stopBeat >= 0. && clip.stopBeat < blockEnd;
+    if (stopping) {
+        end = frameAt(clip.stopBeat - blockStart, beatsPerFrame);
+        end = std::min(std::max(end, 0), s_blockFrames);
+    }
+
+    StretchSlot& slot = *clip.slot;
+    int count = std::min(end - clip.startOffset, slot.count);
+    float gain = (float)clip.gain;
+
+    for (int chan = 0; chan < slot.channels; chan++) {
+        int out = clip.output + chan;
+        if (out >= WARPSESSION_MAX_OUTPUTS) {
+            break;
+        }
+        const float* src = slot.output[chan].data();
+        float* dst = &m_mix[(size_t)clip.startOffset * WARPSESSION_MAX_OUTPUTS + out];
+        for (int i = 0; i < count; i++) {
+            dst[i * WARPSESSION_MAX_OUTPUTS] += gain * src[i];
+        }
+    }
+
+    if (count > 0) {
+        for (int chan = 0; chan < slot.channels; chan++) {
+            memmove(slot.output[chan].data(), slot.output[chan].data() + count, (slot.count - count) * sizeof(float));
+        }
+        slot.count -= count;
+        // The playhead follows the frames mixed rather than the source,
+        // which runs ahead of them by whatever the stretcher holds.
+        clip.playHeadBeats += count * beatsPerFrame;
+        const AbletonClipInfo& info = clip.clipInfo;
+        if (info.loop_on && info.loop_end > info.loop_start && clip.playHeadBeats >= info.loop_end) {
+            clip.playHeadBeats = info.loop_start + std::fmod(clip.playHeadBeats - info.loop_end, info.loop_end - info.loop_start);
+        }
+    }
+
+    bool past_end_marker_and_loop_off = clip.playHeadBeats > clip.clipInfo.end_marker && !clip.clipInfo.loop_on;
+    if (stopping || past_end_marker_and_loop_off) {
+        releaseClip(clip);
+    }
+}
+
+void
+WarpSession::mixBlock()
+{
+    const double beatsPerFrame = m_bpm / (60. * m_srate);
+    const double blockStart = m_beat;
+    const double blockEnd = m_beat + s_blockFrames * beatsPerFrame;
+
+    std::fill(m_mix.begin(), m_mix.end(), 0.f);
+    for (auto& c : m_clips) {
+        c->startOffset = 0;
+    }
+
+    // start the clips whose launch falls in this block
+    for (auto& c : m_clips) {
+        Clip& clip = *c;
+        if (clip.launchBeat >= 0. && clip.launchBeat < blockEnd) {
+            if (!clip.slot && !takeVoice(clip, blockStart, blockEnd, beatsPerFrame)) {
+                // every voice is taken: the launch is dropped
+                clip.launchBeat = -1.;
+                continue;
+            }
+            startClip(clip, blockStart, beatsPerFrame);
+        }
+    }
+
+    // Give every playing clip a block of stretched frames. The settings are
+    // worked out here, once per block; the stretching itself can run on the
+    // StretchPool, one clip per worker.
+    m_topUp.clear();
+    for (auto& c : m_clips) {
+        if (prepareJob(*c)) {
+            m_topUp.push_back(c.get());
+        }
+    }
+
+    if (m_threaded && m_topUp.size() > 1) {
+        for (Clip* clip : m_topUp) {
+            StretchPool::instance().submit(&clip->job);
+        }
+        // finish() runs any job no worker has got to yet on this thread
+        for (Clip* clip : m_topUp) {
+            StretchPool::instance().finish(&clip->job);
+        }
+    }
+    else {
+        for (Clip* clip : m_topUp) {
+            clip->job.run();
+        }
+    }
+
+    for (auto& c : m_clips) {
+        if (c->playing) {
+            mixClip(*c, blockStart, blockEnd, beatsPerFrame);
+        }
+    }
+
+    m_mixBeat = blockStart;
+    m_mixBeatsPerFrame = beatsPerFrame;
+    m_mixPos = 0;
+    m_beat = blockEnd;
+}
+
+void
+WarpSession::tick(SAMPLE* in, SAMPLE* out, int nframes)
+{
+    // ChucK pretty much only asks for one frame at a time, so the clips are
+    // mixed a block at a time and served from m_mix.
+    for (int i = 0; i < nframes; i++) {
+        if (m_mixPos >= s_blockFrames) {
+            mixBlock();
+        }
+        const float* frame = &m_mix[(size_t)m_mixPos * WARPSESSION_MAX_OUTPUTS];
+        for (int chan = 0; chan < WARPSESSION_MAX_OUTPUTS; chan++) {
+            out[chan + WARPSESSION_MAX_OUTPUTS * i] = frame[chan];
+        }
+        m_mixPos++;
+    }
+}
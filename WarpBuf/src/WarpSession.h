@@ -0,0 +1,157 @@
+#pragma once
+
+#include <chugin.h>
+
+#include <rubberband/RubberBandStretcher.h>
+#include "AbletonClipInfo.h"
+#include "SampleCache.h"
+#include "StretchPool.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#define WARPSESSION_MAX_OUTPUTS 16
+
+//-----------------------------------------------------------------------------
+// name: class WarpSession
+// desc: Plays many clips against one shared beat clock, like a column of
+//       clip slots in Ableton Live. Clips are launched and stopped on the
+//       next multiple of `quantize` beats and mixed to up to 16 outputs.
+//       Clips are preloaded into the SampleCache. Stretchers and their
+//       buffers come from a fixed pool of `maxVoices` voices (for each
+//       channel count in use); a clip takes one when it starts and returns
+//       it when it stops, so nothing is allocated on the audio thread and
+//       memory and CPU go with the clips playing at once rather than the
+//       clips added.
+//-----------------------------------------------------------------------------
+class WarpSession
+{
+public:
+    WarpSession(t_CKFLOAT srate);
+    ~WarpSession();
+
+    void tick(SAMPLE* in, SAMPLE* out, int nframes);
+
+    // Load a clip; returns its index, or -1 if the file can't be read.
+    int add(const std::string& path);
+    int getClipCount() { return (int)m_clips.size(); }
+
+    // Start (or restart) / stop a clip on the next quantize boundary.
+    void launch(int clip);
+    void stop(int clip);
+    void stopAll();
+    // 1 while the clip is audible
+    bool getPlaying(int clip);
+
+    double getBPM() { return m_bpm; }
+    void setBPM(double bpm);
+    double getQuantize() { return m_quantize; }
+    void setQuantize(double beats) { m_quantize = beats > 0 ? beats : 0.; }
+    // position of the shared beat clock, in quarter notes
+    double getBeat();
+
+    double getTranspose(int clip);
+    void setTranspose(int clip, double transpose);
+    double getClipGain(int clip);
+    void setClipGain(int clip, double gain);
+    // first output channel the clip is mixed to
+    int getOutput(int clip);
+    void setOutput(int clip, int channel);
+    bool getLoop(int clip);
+    void setLoop(int clip, bool loop);
+
+    // stretch the playing clips in parallel on the StretchPool
+    bool getThreaded() { return m_threaded; }
+    void setThreaded(bool threaded) { m_threaded = threaded; }
+
+    // Clips that can play at once. A launch with every voice taken gets the
+    // voice of a clip stopping in the same block, or else is dropped.
+    int getMaxVoices() { return m_maxVoices; }
+    void setMaxVoices(int voices);
+
+private:
+    // output frames mixed at a time; launches and stops are placed on exact
+    // frames inside a block
+    static constexpr int s_blockFrames = 256;
+    // frames read from a clip per call
+    static constexpr int s_readFrames = 1024;
+    static constexpr int s_defaultVoices = 8;
+
+    // a stretcher and its buffers, borrowed by a clip while it plays
+    struct StretchSlot {
+        int channels;
+        std::unique_ptr<RubberBand::RubberBandStretcher> stretcher;
+        std::vector<std::vector<float>> input;   // [channels][s_readFrames]
+        std::vector<std::vector<float>> output;  // [channels][2 * s_blockFrames], stretched frames not yet mixed
+        std::vector<float*> inputPtrs;
+        std::vector<float*> outputPtrs;
+        int count = 0;  // frames in output
+        int discard = 0;  // stretcher output frames still to drop after a launch
+    };
+
+    struct Clip;
+
+    // tops up one clip's stretched frames, on a pool worker when threaded
+    class ClipJob : public StretchJob {
+    public:
+        Clip* clip = nullptr;
+        double ratio = 1.;
+        double pitchScale = 1.;
+        void run() override;
+    private:
+        void fill(int frames);
+    };
+
+    struct Clip {
+        std::shared_ptr<const CachedClip> data;
+        AbletonClipInfo clipInfo;
+        std::unique_ptr<MemoryClipReader> source;
+        double pitchScale = 1.;
+        double gain = 1.;
+        int output = 0;
+
+        bool playing = false;
+        double launchBeat = -1.;  // pending launch on the session clock, or -1
+        double stopBeat = -1.;    // pending stop on the session clock, or -1
+        double playHeadBeats = 0.;  // in the clip's own beats
+        int startOffset = 0;      // frame of the current block where the clip starts
+
+        std::unique_ptr<StretchSlot> slot;
+        ClipJob job;
+    };
+
+    void mixBlock();
+    bool takeVoice(Clip& clip, double blockStart, double blockEnd, double beatsPerFrame);
+    void startClip(Clip& clip, double blockStart, double beatsPerFrame);
+    bool prepareJob(Clip& clip);
+    void mixClip(Clip& clip, double blockStart, double blockEnd, double beatsPerFrame);
+    void releaseClip(Clip& clip);
+    std::unique_ptr<StretchSlot> acquireSlot(int channels);
+    std::unique_ptr<StretchSlot> makeSlot(int channels);
+    void sizePool();
+    double stretchRatio(Clip& clip);
+    double nextBoundary(double beat);
+    static int frameAt(double beats, double beatsPerFrame);
+    Clip* find(int clip);
+
+    t_CKFLOAT m_srate;
+    double m_bpm = 120.;
+    double m_quantize = 4.;
+    bool m_threaded = false;
+
+    std::vector<std::unique_ptr<Clip>> m_clips;
+    // the voice pool
+    int m_maxVoices = s_defaultVoices;
+    int m_voicesInUse = 0;
+    std::vector<int> m_widths;  // channel counts the pool has voices for
+    std::vector<std::unique_ptr<StretchSlot>> m_idleSlots;
+    std::vector<Clip*> m_topUp;  // clips being topped up in the current block
+
+    // mixed output, interleaved [s_blockFrames][WARPSESSION_MAX_OUTPUTS]
+    std::vector<float> m_mix;
+    int m_mixPos = s_blockFrames;  // next frame of m_mix to output
+    double m_mixBeat = 0.;         // session beat of the first frame of m_mix
+    double m_mixBeatsPerFrame = 0.;
+    double m_beat = 0.;            // session beat of the next block to mix
+};
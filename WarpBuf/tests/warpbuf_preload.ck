@@ -0,0 +1,27 @@
+@import "WarpBuf.chug"
+
+// Several WarpBufs preloading the same file share one decoded
+// copy of it, so only the first read touches the disk.
+
+4 => int N;
+WarpBuf bufs[N];
+
+for (0 => int i; i < N; i++) {
+    bufs[i] => dac;
+    (1. / N) => bufs[i].gain;
+    1 => bufs[i].preload;
+    me.dir() + "assets/1375__sleep__90-bpm-nylon2.wav" => bufs[i].read;
+    // offset each copy by a beat
+    i => bufs[i].playhead;
+    (i * 2) => bufs[i].transpose;
+}
+
+<<<"preload", bufs[0].preload()>>>;
+
+// Switching back to streaming keeps the playhead.
+5::second => now;
+0 => bufs[N-1].preload;
+
+while(true) {
+    1::second => now;
+}
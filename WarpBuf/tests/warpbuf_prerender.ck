@@ -0,0 +1,26 @@
+@import "WarpBuf.chug"
+
+WarpBuf s => dac;
+s.gain(.5);
+
+me.dir() + "assets/1375__sleep__90-bpm-nylon2.wav" => s.read;
+110. => s.bpm;
+-2 => s.transpose;
+
+// Optionally keep the render on disk for the next run.
+// me.dir() + "renders" => s.renderDir;
+
+// Render in the background; the loop is stretched
+// in real time until the render is ready.
+s.prerender();
+
+while(!s.rendered()) {
+    10::ms => now;
+}
+<<<"playing from the render">>>;
+8::second => now;
+
+// Changing the tempo goes back to real-time stretching.
+140. => s.bpm;
+<<<"rendered", s.rendered()>>>;
+8::second => now;
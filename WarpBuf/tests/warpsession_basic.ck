@@ -0,0 +1,33 @@
+@import "WarpBuf.chug"
+
+WarpSession session => dac;
+
+session.add(me.dir() + "assets/1375__sleep__90-bpm-nylon2.wav") => int guitar;
+session.add(me.dir() + "assets/381353__waveplaysfx__drumloop-120-bpm-edm-drum-loop-022.wav") => int drums;
+
+// The guitar goes to the right channel and the drums to the left.
+session.output(guitar, 1);
+session.output(drums, 0);
+session.clipGain(guitar, .5);
+
+125. => session.bpm;
+
+// Test that clips launched at different times line up.
+// You should hear the drums, then the guitar joining on the next bar.
+session.launch(drums);
+1::second => now;
+session.launch(guitar);
+<<<"beat", session.beat(), "guitar playing", session.playing(guitar)>>>;
+
+// Test that stopping is quantized too.
+// The drums should stop on a bar line.
+6::second => now;
+session.stop(drums);
+
+// Test that transposing one clip leaves the other alone.
+4::second => now;
+session.transpose(guitar, -5);
+
+while(true) {
+    1::second => now;
+}